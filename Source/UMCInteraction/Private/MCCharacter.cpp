@@ -10,6 +10,16 @@
 #include "HeadMountedDisplay.h"
 #include "IHeadMountedDisplay.h"
 #include "IXRTrackingSystem.h"
+#include "PhysicsPublic.h"
+#include "PhysicsEngine/PhysicsSettings.h"
+#include "Misc/App.h"
+#include "Misc/Paths.h"
+#include "Net/UnrealNetwork.h"
+#include "Engine/NetConnection.h"
+#include "UObject/CoreNet.h"
+#include "MCStats.h"
+#include "MCWorldRegistry.h"
+#include "MCControlAdapter.h"
 
 // Sets default values
 AMCCharacter::AMCCharacter()
@@ -62,10 +72,81 @@ AMCCharacter::AMCCharacter()
 	DGain = 50.0f;
 	MaxOutput = 350000.0f;
 	RotationBoost = 12000.f;
+	LeftLinearControl = EMCLinearControl::ForcePD;
+	RightLinearControl = EMCLinearControl::ForcePD;
+	VelocityPGain = 20.f;
+	VelocityMaxOutput = 1000.f;
+	bMassAwareControl = false;
+	FeedforwardGain = 1.f;
+	FeedforwardSamples = 4;
+
+	// Hands are set at BeginPlay
+	LeftHand = nullptr;
+	RightHand = nullptr;
 
 	// Init rotation offset
 	LeftHandRotationOffset = FQuat::Identity;
 	RightHandRotationOffset = FQuat::Identity;
+
+	// Post physics tick, used for measuring the physics step of the frame budget governor
+	PostPhysicsTickFunction.bCanEverTick = true;
+	PostPhysicsTickFunction.bStartWithTickEnabled = false;
+	PostPhysicsTickFunction.TickGroup = TG_PostPhysics;
+	ControllerUpdateFrames = 0;
+	ControllerUpdateDeltaTime = 0.f;
+
+	// Deterministic mode defaults
+	bDeterministicMode = false;
+	bTimingSettingsSaved = false;
+	bSavedUseFixedTimeStep = false;
+	SavedFixedDeltaTime = 0.0;
+	bSavedSubstepping = false;
+	SavedMaxSubsteps = 0;
+	SavedMaxSubstepDeltaTime = 0.f;
+	SavedMaxPhysicsDeltaTime = 0.f;
+	SimulationStepHz = 90.f;
+	PhysicsSubsteps = 2;
+	RandomSeed = 0;
+	InputMode = EMCInputMode::Live;
+	InputRecordingFile = TEXT("MCInput.bin");
+	FixedStepDeltaTime = 0.f;
+	SimulationStep = 0;
+
+	// Shared memory tracker defaults
+	bUseSharedMemoryPoses = false;
+	SharedMemoryName = TEXT("MCTrackerPoses");
+	SharedPoseOpenDeltaTime = 0.f;
+
+	// Glove input defaults
+	bUseGloveInput = false;
+	GloveInputMode = EMCInputMode::Live;
+	LeftGloveRecordingFile = TEXT("MCGloveLeft.bin");
+	RightGloveRecordingFile = TEXT("MCGloveRight.bin");
+	GloveFilterCutoffHz = 10.f;
+	GloveResampleDelay = 0.01f;
+
+	// Replication defaults
+	LeftHandClass = nullptr;
+	RightHandClass = nullptr;
+	bReplicateHands = true;
+	HandNetSendHz = 30.f;
+	bReplicateJointAngles = true;
+	RemoteHandInterpolationDelay = 0.1f;
+	bCountClientHandNetBits = false;
+	bRemoteHandsEnabled = false;
+	bSpawnedHands = false;
+	HandNetSendDeltaTime = 0.f;
+	HandNetBits = 0;
+	HandNetTime = 0.f;
+
+	// Trajectory export defaults
+	bExportTrajectory = false;
+	TrajectoryFile = TEXT("MCTrajectory.mct");
+	TrajectoryRowsPerChunk = 1024;
+	bBinarySemanticLog = false;
+	SemanticLogFile = TEXT("MCSemanticEvents.bin");
+	TrajectorySample = 0;
+	TrajectoryTime = 0.f;
 }
 
 // Called when the game starts or when spawned
@@ -78,8 +159,8 @@ void AMCCharacter::BeginPlay()
 	RightTargetArrow->SetHiddenInGame(!bShowTargetArrows);
 
 	// Set the hand PID controller values
-	LeftPIDController.SetValues(PGain, IGain, DGain, MaxOutput, -MaxOutput);
-	RightPIDController.SetValues(PGain, IGain, DGain, MaxOutput, -MaxOutput);
+	AMCCharacter::SetupLinearController(LeftPIDController, LeftLinearControl);
+	AMCCharacter::SetupLinearController(RightPIDController, RightLinearControl);
 
 	// Check if VR is enabled
 	IHeadMountedDisplay* HMD = (IHeadMountedDisplay*)(GEngine->XRSystem->GetHMDDevice());
@@ -98,6 +179,25 @@ void AMCCharacter::BeginPlay()
 		MCRight->SetRelativeLocation(FVector(75.f, 30.f, 30.f));
 	}
 
+	// Hands of the characters spawned at runtime (e.g. the characters of other users) are local to every machine
+	if (!LeftSkelActor && LeftHandClass)
+	{
+		LeftSkelActor = AMCCharacter::SpawnHand(LeftHandClass, MCLeft);
+		bSpawnedHands = true;
+	}
+	if (!RightSkelActor && RightHandClass)
+	{
+		RightSkelActor = AMCCharacter::SpawnHand(RightHandClass, MCRight);
+		bSpawnedHands = true;
+	}
+
+	// The server replicates the hand states at the send rate, standalone sessions keep the actor defaults
+	if (bReplicateHands && GetNetMode() != NM_Standalone)
+	{
+		NetUpdateFrequency = HandNetSendHz;
+		MinNetUpdateFrequency = FMath::Min(MinNetUpdateFrequency, HandNetSendHz);
+	}
+
 	if (LeftSkelActor)
 	{	
 		// Cast the hands to AMCHand
@@ -132,30 +232,844 @@ void AMCCharacter::BeginPlay()
 			false, (FHitResult*)nullptr,ETeleportType::TeleportPhysics);
 	}
 
-	// If two hands are available, let them know about each other (for two hands fixation grasp)
+	// Motion controller poses come from the external tracker, tracker space is the motion controller origin
+	if (bUseSharedMemoryPoses)
+	{
+		MCLeft->Deactivate();
+		MCRight->Deactivate();
+		SharedPoseRing.OpenForReading(SharedMemoryName);
+	}
+
+	// Per-joint finger input, the recordings replace the glove hardware
+	if (bUseGloveInput)
+	{
+		LeftGloveStream.Init(GloveFilterCutoffHz, GloveResampleDelay);
+		RightGloveStream.Init(GloveFilterCutoffHz, GloveResampleDelay);
+		if (GloveInputMode == EMCInputMode::Record)
+		{
+			LeftGloveStream.StartRecording();
+			RightGloveStream.StartRecording();
+		}
+		else if (GloveInputMode == EMCInputMode::Replay)
+		{
+			LeftGloveStream.StartReplay(AMCCharacter::GetGloveRecordingPath(LeftGloveRecordingFile));
+			RightGloveStream.StartReplay(AMCCharacter::GetGloveRecordingPath(RightGloveRecordingFile));
+		}
+	}
+
+	// Register the character, if two hands are available pair them (for two hands fixation grasp)
+	FMCWorldRegistry& WorldRegistry = FMCWorldRegistry::Get(GetWorld());
+	WorldRegistry.RegisterCharacter(this);
 	bTryTwoHandsFixationGrasp = (bTryTwoHandsFixationGrasp && LeftHand && RightHand);
 	if (bTryTwoHandsFixationGrasp)
 	{
-		LeftHand->SetOtherHand(RightHand);
-		RightHand->SetOtherHand(LeftHand);
+		WorldRegistry.RegisterHandPair(LeftHand, RightHand);
+	}
+
+	// Fixed simulation clock, the frame budget governor is wall clock dependent and not used
+	if (bDeterministicMode)
+	{
+		AMCCharacter::SetupDeterministicMode();
+		FrameBudgetGovernor.bEnabled = false;
+	}
+
+	// Measure the plugin cost and the physics step time, start at the highest quality tier
+	FrameBudgetGovernor.Init();
+	if (FrameBudgetGovernor.bEnabled)
+	{
+		FPhysScene* PhysScene = GetWorld()->GetPhysicsScene();
+		if (PhysScene)
+		{
+			PhysSceneStepHandle = PhysScene->OnPhysSceneStep.AddUObject(this, &AMCCharacter::OnPhysSceneStep);
+		}
+		PostPhysicsTickFunction.SetTickFunctionEnable(true);
+	}
+	AMCCharacter::ApplyQualityTier();
+
+	if (bExportTrajectory)
+	{
+		AMCCharacter::StartTrajectoryExport(TrajectoryFile);
+	}
+
+	if (bBinarySemanticLog)
+	{
+		WorldRegistry.OpenSemanticEventLog(FPaths::IsRelative(SemanticLogFile) ?
+			FPaths::Combine(FPaths::ProjectDir(), SemanticLogFile) : SemanticLogFile);
 	}
 }
 
+// Called when the game ends or when destroyed
+void AMCCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	// Stop measuring the physics step
+	FPhysScene* PhysScene = GetWorld()->GetPhysicsScene();
+	if (PhysScene && PhysSceneStepHandle.IsValid())
+	{
+		PhysScene->OnPhysSceneStep.Remove(PhysSceneStepHandle);
+		PhysSceneStepHandle.Reset();
+	}
+
+	FMCWorldRegistry::Get(GetWorld()).UnregisterCharacter(this);
+
+	AMCCharacter::FinishTrajectoryExport();
+
+	// The editor and later play sessions keep their own time step and substeps
+	AMCCharacter::RestoreTimingSettings();
+
+	if (HandNetBits > 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("AMCCharacter: %s sent %.1f bytes per hand per second (%.1f s, %d Hz)"),
+			*GetName(), AMCCharacter::GetHandNetBytesPerSecond(), HandNetTime, FMath::RoundToInt(HandNetSendHz));
+	}
+
+	// Spawned hands are removed with the character
+	if (bSpawnedHands)
+	{
+		if (LeftSkelActor)
+		{
+			LeftSkelActor->Destroy();
+		}
+		if (RightSkelActor)
+		{
+			RightSkelActor->Destroy();
+		}
+	}
+
+	if (SharedPoseRing.IsOpen())
+	{
+		UE_LOG(LogTemp, Log, TEXT("AMCCharacter: %llu tracker samples published, %llu overwritten before read"),
+			SharedPoseRing.GetWriteIndex(), SharedPoseRing.GetNumDropped());
+		SharedPoseRing.Close();
+	}
+
+	// Write the recorded input
+	if (bDeterministicMode && InputMode == EMCInputMode::Record)
+	{
+		InputRecording.SaveToFile(AMCCharacter::GetInputRecordingPath());
+	}
+	if (bUseGloveInput && GloveInputMode == EMCInputMode::Record)
+	{
+		LeftGloveStream.SaveRecording(AMCCharacter::GetGloveRecordingPath(LeftGloveRecordingFile));
+		RightGloveStream.SaveRecording(AMCCharacter::GetGloveRecordingPath(RightGloveRecordingFile));
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame
 void AMCCharacter::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
+	// Hands of other users are rendered from their replicated states
+	const bool bNetworked = bReplicateHands && GetNetMode() != NM_Standalone;
+	if (bNetworked)
+	{
+		AMCCharacter::UpdateHandNetStats(DeltaTime);
+		if (AMCCharacter::IsRemoteCharacter())
+		{
+			AMCCharacter::UpdateRemoteHands(DeltaTime);
+			return;
+		}
+	}
+
+	// Newest tracker sample, latched (and recorded) like the motion controller poses
+	if (bUseSharedMemoryPoses && !(bDeterministicMode && InputMode == EMCInputMode::Replay))
+	{
+		// The tracker might start after the game, retry opening the region once per second
+		if (!SharedPoseRing.IsOpen() && (SharedPoseOpenDeltaTime += DeltaTime) > 1.f)
+		{
+			SharedPoseOpenDeltaTime = 0.f;
+			SharedPoseRing.OpenForReading(SharedMemoryName);
+		}
+		AMCCharacter::ApplySharedPoses();
+	}
+
+	FMCScopedPluginCost PluginCost(FrameBudgetGovernor);
+	SCOPE_CYCLE_COUNTER(STAT_MCHandControl);
+
+	// Finger joint targets at the simulation rate
+	if (bUseGloveInput)
+	{
+		AMCCharacter::UpdateGloves(bDeterministicMode ? FixedStepDeltaTime : DeltaTime);
+	}
+
+	// Hand states of the last physics step to the other users
+	if (bNetworked)
+	{
+		AMCCharacter::SendHandStates(DeltaTime);
+	}
+
+	// Every frame is one fixed simulation step
+	if (bDeterministicMode)
+	{
+		AMCCharacter::StepSimulation(FixedStepDeltaTime);
+		return;
+	}
+
+	// Skip controller updates depending on the active quality tier, the skipped time is accumulated
+	ControllerUpdateDeltaTime += DeltaTime;
+	if (++ControllerUpdateFrames < FrameBudgetGovernor.GetActiveTier().ControllerUpdateInterval)
+	{
+		return;
+	}
+	AMCCharacter::UpdateHands(ControllerUpdateDeltaTime);
+	ControllerUpdateFrames = 0;
+	ControllerUpdateDeltaTime = 0.f;
+}
+
+// Move both hands towards their motion controller targets
+void AMCCharacter::UpdateHands(const float DeltaTime)
+{
 	// Force based movement of the hands to target location and rotation
 	if (LeftSkelActor)
 	{
 		AMCCharacter::UpdateHandLocationAndRotation(
-			MCLeft, LeftHandRotationOffset, LeftSkelActor->GetSkeletalMeshComponent(), LeftPIDController, DeltaTime);
+			MCLeft, LeftHandRotationOffset, LeftSkelActor->GetSkeletalMeshComponent(), LeftHand,
+			LeftPIDController, LeftLinearControl, DeltaTime);
 	}
 	if (RightSkelActor)
 	{
 		AMCCharacter::UpdateHandLocationAndRotation(
-			MCRight, RightHandRotationOffset, RightSkelActor->GetSkeletalMeshComponent(), RightPIDController, DeltaTime);
+			MCRight, RightHandRotationOffset, RightSkelActor->GetSkeletalMeshComponent(), RightHand,
+			RightPIDController, RightLinearControl, DeltaTime);
+	}
+
+	// Palm poses of the last physics step and the current targets (release velocities, prediction, telemetry)
+	if (LeftHand)
+	{
+		LeftHand->RecordKinematics(FTransform(MCLeft->GetComponentQuat() * LeftHandRotationOffset, MCLeft->GetComponentLocation()));
+		LeftHand->UpdateGraspIntent();
+	}
+	if (RightHand)
+	{
+		RightHand->RecordKinematics(FTransform(MCRight->GetComponentQuat() * RightHandRotationOffset, MCRight->GetComponentLocation()));
+		RightHand->UpdateGraspIntent();
+	}
+}
+
+// Copy the newest shared memory tracker sample to the motion controllers and the grasp input
+void AMCCharacter::ApplySharedPoses()
+{
+	FMCSharedPoseSample Sample;
+	if (!SharedPoseRing.ReadLatest(Sample))
+	{
+		// Nothing new, the targets keep their last pose
+		return;
+	}
+
+	// Finger curls replace the grasp axis values (applied after the player input)
+	const float LeftCurl = AMCCharacter::ApplySharedHandPose(Sample.Left, MCLeft);
+	if (LeftCurl >= 0.f)
+	{
+		AMCCharacter::GraspWithLeftHand(LeftCurl);
+	}
+	const float RightCurl = AMCCharacter::ApplySharedHandPose(Sample.Right, MCRight);
+	if (RightCurl >= 0.f)
+	{
+		AMCCharacter::GraspWithRightHand(RightCurl);
+	}
+}
+
+// Copy a shared memory hand pose to its motion controller, returns the mean finger curl (negative if none)
+float AMCCharacter::ApplySharedHandPose(const FMCSharedHandPose& HandPose, UMotionControllerComponent* MC)
+{
+	if (!(HandPose.Flags & MCSP_Valid))
+	{
+		// Hand not tracked in this sample
+		return -1.f;
+	}
+
+	const FQuat Rotation(HandPose.Rotation[0], HandPose.Rotation[1], HandPose.Rotation[2], HandPose.Rotation[3]);
+	MC->SetRelativeLocationAndRotation(
+		FVector(HandPose.Location[0], HandPose.Location[1], HandPose.Location[2]), Rotation.GetNormalized());
+
+	if (!(HandPose.Flags & MCSP_HasFingers))
+	{
+		return -1.f;
+	}
+	float Curl = 0.f;
+	for (int32 FingerIdx = 0; FingerIdx < MC_NUM_FINGERS; ++FingerIdx)
+	{
+		Curl += HandPose.FingerCurl[FingerIdx];
+	}
+	return FMath::Clamp(Curl / MC_NUM_FINGERS, 0.f, 1.f);
+}
+
+// Resample the glove streams and drive the finger joints of the hands
+void AMCCharacter::UpdateGloves(const float DeltaTime)
+{
+	float JointAngles[MC_NUM_GLOVE_ANGLES];
+	LeftGloveStream.AdvanceReplay(DeltaTime);
+	if (LeftGloveStream.Resample(JointAngles) && LeftHand)
+	{
+		LeftHand->UpdateJointTargets(JointAngles);
+	}
+	RightGloveStream.AdvanceReplay(DeltaTime);
+	if (RightGloveStream.Resample(JointAngles) && RightHand)
+	{
+		RightHand->UpdateJointTargets(JointAngles);
+	}
+}
+
+// Get the absolute path of a glove recording file
+FString AMCCharacter::GetGloveRecordingPath(const FString& InGloveRecordingFile) const
+{
+	return FPaths::IsRelative(InGloveRecordingFile) ? FPaths::Combine(FPaths::ProjectDir(), InGloveRecordingFile) : InGloveRecordingFile;
+}
+
+// Spawn a hand for the character at the motion controller
+AMCHand* AMCCharacter::SpawnHand(TSubclassOf<AMCHand> InHandClass, UMotionControllerComponent* MC)
+{
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.Owner = this;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return GetWorld()->SpawnActor<AMCHand>(InHandClass, MC->GetComponentTransform(), SpawnParams);
+}
+
+// Replicate the hand states to the other users
+void AMCCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// The owner simulates its own hands
+	DOREPLIFETIME_CONDITION(AMCCharacter, LeftHandNetState, COND_SkipOwner);
+	DOREPLIFETIME_CONDITION(AMCCharacter, RightHandNetState, COND_SkipOwner);
+}
+
+// Check if the character belongs to another user
+bool AMCCharacter::IsRemoteCharacter() const
+{
+	if (!bReplicateHands || GetNetMode() == NM_Standalone)
+	{
+		return false;
+	}
+	return Role == ROLE_Authority ? !IsLocallyControlled() : Role == ROLE_SimulatedProxy;
+}
+
+// Quantize the current state of a hand
+void AMCCharacter::GetHandNetState(AMCHand* Hand, FMCHandNetState& OutState) const
+{
+	if (!Hand)
+	{
+		OutState = FMCHandNetState();
+		return;
+	}
+
+	USkeletalMeshComponent* const SkelMesh = Hand->GetSkeletalMeshComponent();
+	const FTransform Palm(SkelMesh->GetComponentQuat(), SkelMesh->GetComponentLocation());
+	float JointAngles[MC_NUM_HAND_JOINTS * 3];
+	if (bReplicateJointAngles)
+	{
+		Hand->GetJointAngles(JointAngles);
+	}
+	AStaticMeshActor* const GraspedObject = Hand->GetGraspedObject();
+	OutState.Quantize(GetWorld()->GetTimeSeconds(), Palm, Hand->GetGraspGoal(),
+		bReplicateJointAngles ? JointAngles : nullptr, Hand->GetGraspState(), GraspedObject,
+		GraspedObject ? GraspedObject->GetActorTransform().GetRelativeTransform(Palm) : FTransform::Identity);
+}
+
+// Send the hand states at the send rate
+void AMCCharacter::SendHandStates(const float DeltaTime)
+{
+	// Skipped time is not carried over, the states are sent at most once per frame
+	const float SendInterval = 1.f / HandNetSendHz;
+	HandNetSendDeltaTime += DeltaTime;
+	if (HandNetSendDeltaTime < SendInterval)
+	{
+		return;
+	}
+	HandNetSendDeltaTime = FMath::Fmod(HandNetSendDeltaTime, SendInterval);
+
+	FMCHandNetState LeftState;
+	FMCHandNetState RightState;
+	AMCCharacter::GetHandNetState(LeftHand, LeftState);
+	AMCCharacter::GetHandNetState(RightHand, RightState);
+
+	// User on the listen server, the states are replicated (delta compressed) to the other users
+	if (Role == ROLE_Authority)
+	{
+		LeftHandNetState.State = LeftState;
+		RightHandNetState.State = RightState;
+		return;
+	}
+
+	// The RPC payload is only measured on request, it costs a second serialization of the states
+	UNetConnection* const NetConnection = bCountClientHandNetBits ? GetNetConnection() : nullptr;
+	if (NetConnection)
+	{
+		bool bSuccess = true;
+		FNetBitWriter Writer(NetConnection->PackageMap, 256);
+		LeftState.NetSerialize(Writer, NetConnection->PackageMap, bSuccess);
+		RightState.NetSerialize(Writer, NetConnection->PackageMap, bSuccess);
+		HandNetBits += Writer.GetNumBits();
+		INC_DWORD_STAT_BY(STAT_MCHandNetBytes, (Writer.GetNumBits() + 7) / 8);
+	}
+	AMCCharacter::ServerUpdateHands(LeftState, RightState);
+}
+
+// Count the sent hand state payload
+void AMCCharacter::UpdateHandNetStats(const float DeltaTime)
+{
+	HandNetTime += DeltaTime;
+
+	// Replicated states written by the server (every connection)
+	HandNetBits += LeftHandNetState.NumBitsWritten + RightHandNetState.NumBitsWritten;
+	INC_DWORD_STAT_BY(STAT_MCHandNetBytes, (LeftHandNetState.NumBitsWritten + RightHandNetState.NumBitsWritten + 7) / 8);
+	LeftHandNetState.NumBitsWritten = 0;
+	RightHandNetState.NumBitsWritten = 0;
+}
+
+// Get the hand state payload sent per hand and second
+float AMCCharacter::GetHandNetBytesPerSecond() const
+{
+	// Per existing hand, a missing hand only sends an empty state
+	const int32 NumHands = (LeftHand ? 1 : 0) + (RightHand ? 1 : 0);
+	return HandNetTime > 0.f && NumHands > 0 ? HandNetBits / 8.f / NumHands / HandNetTime : 0.f;
+}
+
+// Render the hands from the interpolated replicated states
+void AMCCharacter::UpdateRemoteHands(const float DeltaTime)
+{
+	if (!bRemoteHandsEnabled)
+	{
+		if (LeftHand)
+		{
+			LeftHand->EnableRemoteProxy();
+		}
+		if (RightHand)
+		{
+			RightHand->EnableRemoteProxy();
+		}
+		bRemoteHandsEnabled = true;
+	}
+
+	FMCHandNetPose Pose;
+	if (LeftHand && LeftHandBuffer.Sample(DeltaTime, RemoteHandInterpolationDelay, Pose))
+	{
+		LeftHand->ApplyRemotePose(Pose);
+	}
+	if (RightHand && RightHandBuffer.Sample(DeltaTime, RemoteHandInterpolationDelay, Pose))
+	{
+		RightHand->ApplyRemotePose(Pose);
+	}
+
+	// Objects handed over between the hands have been claimed by now, only the rest is simulated again
+	if (LeftHand)
+	{
+		LeftHand->ReleaseRemoteObject();
+	}
+	if (RightHand)
+	{
+		RightHand->ReleaseRemoteObject();
+	}
+}
+
+// Receive the hand states of the owning user
+void AMCCharacter::ServerUpdateHands_Implementation(const FMCHandNetState& InLeftState, const FMCHandNetState& InRightState)
+{
+	// Replicated to the other users, rendered on the server
+	LeftHandNetState.State = InLeftState;
+	RightHandNetState.State = InRightState;
+	LeftHandBuffer.Add(InLeftState);
+	RightHandBuffer.Add(InRightState);
+}
+
+// Validate the received hand states
+bool AMCCharacter::ServerUpdateHands_Validate(const FMCHandNetState& InLeftState, const FMCHandNetState& InRightState)
+{
+	return FMath::IsFinite(InLeftState.Timestamp) && FMath::IsFinite(InRightState.Timestamp);
+}
+
+// Left hand state received
+void AMCCharacter::OnRep_LeftHandNetState()
+{
+	LeftHandBuffer.Add(LeftHandNetState.State);
+}
+
+// Right hand state received
+void AMCCharacter::OnRep_RightHandNetState()
+{
+	RightHandBuffer.Add(RightHandNetState.State);
+}
+
+// Called every frame after the physics results are available
+void AMCCharacter::PostPhysicsTick(float DeltaTime)
+{
+	if (FrameBudgetGovernor.MarkPhysicsStepEnd(FPlatformTime::Cycles()))
+	{
+		AMCCharacter::ApplyQualityTier();
+	}
+
+	if (TrajectoryExporter.IsValid())
+	{
+		AMCCharacter::ExportTrajectorySample(bDeterministicMode ? FixedStepDeltaTime : DeltaTime);
+	}
+}
+
+// Start streaming the hand and object trajectories to file
+bool AMCCharacter::StartTrajectoryExport(const FString& InTrajectoryFile)
+{
+	AMCCharacter::FinishTrajectoryExport();
+
+	// The columns are fixed for the whole file, hands are not added or removed at runtime
+	TrajectoryExporter = MakeShareable(new FMCTrajectoryExporter());
+	TrajectoryExporter->AddColumn(TEXT("Step"), EMCTrajectoryColumnType::Int32);
+	TrajectoryExporter->AddColumn(TEXT("Time"));
+	AMCCharacter::AddHandTrajectoryColumns(LeftHand, TEXT("L."));
+	AMCCharacter::AddHandTrajectoryColumns(RightHand, TEXT("R."));
+
+	const FString Filename = FPaths::IsRelative(InTrajectoryFile) ?
+		FPaths::Combine(FPaths::ProjectDir(), InTrajectoryFile) : InTrajectoryFile;
+	if (!TrajectoryExporter->Start(Filename, TrajectoryRowsPerChunk))
+	{
+		TrajectoryExporter.Reset();
+		return false;
+	}
+
+	TrajectorySample = 0;
+	TrajectoryTime = 0.f;
+	PostPhysicsTickFunction.SetTickFunctionEnable(true);
+	return true;
+}
+
+// Write the remaining trajectory samples and close the file
+void AMCCharacter::FinishTrajectoryExport()
+{
+	if (TrajectoryExporter.IsValid())
+	{
+		TrajectoryExporter->Finish();
+		TrajectoryExporter.Reset();
+		PostPhysicsTickFunction.SetTickFunctionEnable(FrameBudgetGovernor.bEnabled);
+	}
+}
+
+// Add the trajectory columns of a hand (prefixed)
+void AMCCharacter::AddHandTrajectoryColumns(AMCHand* Hand, const FString& Prefix)
+{
+	if (!Hand)
+	{
+		return;
+	}
+
+	static const TCHAR* PoseSuffixes[] = { TEXT("PX"), TEXT("PY"), TEXT("PZ"), TEXT("QX"), TEXT("QY"), TEXT("QZ"), TEXT("QW") };
+	auto AddPoseColumns = [&](const FString& Name)
+	{
+		for (const TCHAR* Suffix : PoseSuffixes)
+		{
+			TrajectoryExporter->AddColumn(Prefix + Name + TEXT(".") + Suffix);
+		}
+	};
+
+	// World pose of the hand, component space bone poses
+	AddPoseColumns(TEXT("Hand"));
+	USkeletalMeshComponent* SkelComp = Hand->GetSkeletalMeshComponent();
+	for (int32 BoneIdx = 0; BoneIdx < SkelComp->GetNumBones(); ++BoneIdx)
+	{
+		AddPoseColumns(SkelComp->GetBoneName(BoneIdx).ToString());
+	}
+
+	// Constraint angles of every finger joint
+	for (int32 JointIdx = 0; JointIdx < MC_NUM_HAND_JOINTS; ++JointIdx)
+	{
+		const FString JointName = FString::Printf(TEXT("Joint%d."), JointIdx);
+		TrajectoryExporter->AddColumn(Prefix + JointName + TEXT("Swing1"));
+		TrajectoryExporter->AddColumn(Prefix + JointName + TEXT("Swing2"));
+		TrajectoryExporter->AddColumn(Prefix + JointName + TEXT("Twist"));
+	}
+
+	// Motion controller target, grasp state and grasped object
+	AddPoseColumns(TEXT("Target"));
+	TrajectoryExporter->AddColumn(Prefix + TEXT("GraspState"), EMCTrajectoryColumnType::Int32);
+	TrajectoryExporter->AddColumn(Prefix + TEXT("ObjectId"), EMCTrajectoryColumnType::Int32);
+	AddPoseColumns(TEXT("Object"));
+}
+
+// Copy the current hand, target and object poses into the next trajectory row
+void AMCCharacter::ExportTrajectorySample(const float DeltaTime)
+{
+	TrajectoryTime += DeltaTime;
+
+	// Ring buffer full, the sample is dropped (counted in the file footer)
+	uint32* Row = TrajectoryExporter->BeginRow();
+	if (!Row)
+	{
+		TrajectorySample++;
+		return;
+	}
+
+	FMCTrajectoryExporter::SetInt(Row, 0, TrajectorySample);
+	FMCTrajectoryExporter::SetFloat(Row, 1, TrajectoryTime);
+	int32 Column = AMCCharacter::WriteHandTrajectory(Row, 2, LeftHand, MCLeft);
+	Column = AMCCharacter::WriteHandTrajectory(Row, Column, RightHand, MCRight);
+	checkSlow(Column == TrajectoryExporter->GetNumColumns());
+
+	TrajectoryExporter->EndRow();
+	TrajectorySample++;
+}
+
+// Copy the values of a hand into the trajectory row, returns the next column
+int32 AMCCharacter::WriteHandTrajectory(uint32* Row, int32 Column, AMCHand* Hand, UMotionControllerComponent* MC) const
+{
+	if (!Hand)
+	{
+		return Column;
+	}
+
+	auto WritePose = [&](const FTransform& Pose)
+	{
+		const FVector Location = Pose.GetLocation();
+		const FQuat Rotation = Pose.GetRotation();
+		FMCTrajectoryExporter::SetFloat(Row, Column++, Location.X);
+		FMCTrajectoryExporter::SetFloat(Row, Column++, Location.Y);
+		FMCTrajectoryExporter::SetFloat(Row, Column++, Location.Z);
+		FMCTrajectoryExporter::SetFloat(Row, Column++, Rotation.X);
+		FMCTrajectoryExporter::SetFloat(Row, Column++, Rotation.Y);
+		FMCTrajectoryExporter::SetFloat(Row, Column++, Rotation.Z);
+		FMCTrajectoryExporter::SetFloat(Row, Column++, Rotation.W);
+	};
+
+	USkeletalMeshComponent* SkelComp = Hand->GetSkeletalMeshComponent();
+	WritePose(SkelComp->GetComponentTransform());
+	for (const FTransform& BonePose : SkelComp->GetComponentSpaceTransforms())
+	{
+		WritePose(BonePose);
+	}
+
+	// Angles are written in place, floats are stored with their bit pattern
+	Hand->GetJointAngles(reinterpret_cast<float*>(&Row[Column]));
+	Column += MC_NUM_HAND_JOINTS * 3;
+
+	WritePose(FTransform(MC->GetComponentQuat(), MC->GetComponentLocation()));
+
+	AStaticMeshActor* GraspedObject = Hand->GetGraspedObject();
+	FMCTrajectoryExporter::SetInt(Row, Column++, Hand->GetGraspState());
+	FMCTrajectoryExporter::SetInt(Row, Column++, GraspedObject ? (int32)GraspedObject->GetUniqueID() : -1);
+	WritePose(GraspedObject ? GraspedObject->GetActorTransform() : FTransform::Identity);
+	return Column;
+}
+
+// Register / unregister the post physics tick function as well
+void AMCCharacter::RegisterActorTickFunctions(bool bRegister)
+{
+	Super::RegisterActorTickFunctions(bRegister);
+
+	if (bRegister)
+	{
+		if (PostPhysicsTickFunction.bCanEverTick)
+		{
+			PostPhysicsTickFunction.Target = this;
+			PostPhysicsTickFunction.SetTickFunctionEnable(PostPhysicsTickFunction.bStartWithTickEnabled);
+			PostPhysicsTickFunction.RegisterTickFunction(GetLevel());
+		}
+	}
+	else if (PostPhysicsTickFunction.IsTickFunctionRegistered())
+	{
+		PostPhysicsTickFunction.UnRegisterTickFunction();
+	}
+}
+
+// Physics scene step callback, marks the physics step start
+void AMCCharacter::OnPhysSceneStep(FPhysScene* PhysScene, uint32 SceneType, float DeltaTime)
+{
+	FrameBudgetGovernor.MarkPhysicsStepStart(FPlatformTime::Cycles());
+}
+
+// Set the fixed engine time step, the physics substeps, and the random seed, load the input recording
+void AMCCharacter::SetupDeterministicMode()
+{
+	// The settings are global (engine and physics settings default object), they are restored at the end of play
+	UPhysicsSettings* PhysSettings = UPhysicsSettings::Get();
+	if (!bTimingSettingsSaved)
+	{
+		bSavedUseFixedTimeStep = FApp::UseFixedTimeStep();
+		SavedFixedDeltaTime = FApp::GetFixedDeltaTime();
+		bSavedSubstepping = PhysSettings->bSubstepping;
+		SavedMaxSubsteps = PhysSettings->MaxSubsteps;
+		SavedMaxSubstepDeltaTime = PhysSettings->MaxSubstepDeltaTime;
+		SavedMaxPhysicsDeltaTime = PhysSettings->MaxPhysicsDeltaTime;
+		bTimingSettingsSaved = true;
+	}
+
+	// Engine advances the same amount of time every frame, independent of the render rate
+	FixedStepDeltaTime = 1.f / SimulationStepHz;
+	FApp::SetUseFixedTimeStep(true);
+	FApp::SetFixedDeltaTime(FixedStepDeltaTime);
+
+	// Fixed number of physics substeps per simulation step
+	PhysSettings->bSubstepping = PhysicsSubsteps > 1;
+	PhysSettings->MaxSubsteps = PhysicsSubsteps;
+	PhysSettings->MaxSubstepDeltaTime = FixedStepDeltaTime / PhysicsSubsteps;
+	PhysSettings->MaxPhysicsDeltaTime = FMath::Max(PhysSettings->MaxPhysicsDeltaTime, FixedStepDeltaTime);
+	if (!PhysSettings->bEnableEnhancedDeterminism)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("AMCCharacter: Enhanced determinism is disabled in the physics settings, replays might diverge.."));
+	}
+
+	// Semantic event names are randomly generated
+	FMath::RandInit(RandomSeed);
+	FMath::SRandInit(RandomSeed);
+
+	SimulationStep = 0;
+	PendingInput = FMCInputFrame();
+	InputRecording.StepDeltaTime = FixedStepDeltaTime;
+	InputRecording.Frames.Empty();
+
+	if (InputMode == EMCInputMode::Replay)
+	{
+		if (InputRecording.LoadFromFile(AMCCharacter::GetInputRecordingPath()))
+		{
+			if (!FMath::IsNearlyEqual(InputRecording.StepDeltaTime, FixedStepDeltaTime))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("AMCCharacter: Input recorded with a step of %f s, replayed with %f s.."),
+					InputRecording.StepDeltaTime, FixedStepDeltaTime);
+			}
+
+			// Motion controller poses come from the recording
+			MCLeft->Deactivate();
+			MCRight->Deactivate();
+		}
+		else
+		{
+			InputMode = EMCInputMode::Live;
+		}
+	}
+}
+
+// Restore the engine time step and the physics substep settings changed by the deterministic mode
+void AMCCharacter::RestoreTimingSettings()
+{
+	if (!bTimingSettingsSaved)
+	{
+		return;
+	}
+
+	FApp::SetUseFixedTimeStep(bSavedUseFixedTimeStep);
+	FApp::SetFixedDeltaTime(SavedFixedDeltaTime);
+	UPhysicsSettings* PhysSettings = UPhysicsSettings::Get();
+	PhysSettings->bSubstepping = bSavedSubstepping;
+	PhysSettings->MaxSubsteps = SavedMaxSubsteps;
+	PhysSettings->MaxSubstepDeltaTime = SavedMaxSubstepDeltaTime;
+	PhysSettings->MaxPhysicsDeltaTime = SavedMaxPhysicsDeltaTime;
+	bTimingSettingsSaved = false;
+}
+
+// Get the absolute input recording file path
+FString AMCCharacter::GetInputRecordingPath() const
+{
+	return FPaths::IsRelative(InputRecordingFile) ? FPaths::Combine(FPaths::ProjectDir(), InputRecordingFile) : InputRecordingFile;
+}
+
+// Switch to deterministic mode and replay the input recording
+bool AMCCharacter::StartReplay(const FString& InInputRecordingFile)
+{
+	bDeterministicMode = true;
+	InputMode = EMCInputMode::Replay;
+	InputRecordingFile = InInputRecordingFile;
+	FrameBudgetGovernor.bEnabled = false;
+	AMCCharacter::SetupDeterministicMode();
+	return InputMode == EMCInputMode::Replay;
+}
+
+// Check if all the replayed input frames have been applied
+bool AMCCharacter::IsReplayFinished() const
+{
+	return InputMode == EMCInputMode::Replay && SimulationStep >= InputRecording.Frames.Num();
+}
+
+// Advance one fixed simulation step using the latched (or replayed) input
+void AMCCharacter::StepSimulation(const float StepDeltaTime)
+{
+	FMCInputFrame InputFrame;
+	if (InputMode == EMCInputMode::Replay)
+	{
+		if (!InputRecording.Frames.IsValidIndex(SimulationStep))
+		{
+			// Replay finished, keep the hands in place
+			AMCCharacter::UpdateHands(StepDeltaTime);
+			return;
+		}
+		InputFrame = InputRecording.Frames[SimulationStep];
+		SetActorLocationAndRotation(InputFrame.CharacterLocation, InputFrame.CharacterRotation);
+		MCLeft->SetWorldLocationAndRotation(InputFrame.LeftTargetLocation, InputFrame.LeftTargetRotation);
+		MCRight->SetWorldLocationAndRotation(InputFrame.RightTargetLocation, InputFrame.RightTargetRotation);
+	}
+	else
+	{
+		InputFrame = PendingInput;
+		InputFrame.CharacterLocation = GetActorLocation();
+		InputFrame.CharacterRotation = GetActorQuat();
+		InputFrame.LeftTargetLocation = MCLeft->GetComponentLocation();
+		InputFrame.LeftTargetRotation = MCLeft->GetComponentQuat();
+		InputFrame.RightTargetLocation = MCRight->GetComponentLocation();
+		InputFrame.RightTargetRotation = MCRight->GetComponentQuat();
+		if (InputMode == EMCInputMode::Record)
+		{
+			InputRecording.Frames.Add(InputFrame);
+		}
+	}
+
+	// Actions are consumed, axis values are kept until they change
+	PendingInput.Actions = MCIA_None;
+
+	AMCCharacter::ApplyInputFrame(InputFrame, StepDeltaTime);
+	SimulationStep++;
+}
+
+// Apply the input frame of a simulation step in a fixed order
+void AMCCharacter::ApplyInputFrame(const FMCInputFrame& InputFrame, const float StepDeltaTime)
+{
+	if (InputFrame.Actions & MCIA_SwitchGrasp)
+	{
+		if (RightHand)
+		{
+			RightHand->SwitchGrasp();
+		}
+		if (LeftHand)
+		{
+			LeftHand->SwitchGrasp();
+		}
+	}
+	if (InputFrame.Actions & MCIA_LeftAttach)
+	{
+		AMCCharacter::ApplyFixationGrasp(LeftHand, RightHand);
+	}
+	if (InputFrame.Actions & MCIA_RightAttach)
+	{
+		AMCCharacter::ApplyFixationGrasp(RightHand, LeftHand);
+	}
+	if ((InputFrame.Actions & MCIA_LeftDetach) && LeftHand)
+	{
+		LeftHand->DetachFixationGrasp();
+	}
+	if ((InputFrame.Actions & MCIA_RightDetach) && RightHand)
+	{
+		RightHand->DetachFixationGrasp();
+	}
+
+	if (LeftHand)
+	{
+		LeftHand->UpdateGrasp(InputFrame.LeftGrasp);
+	}
+	if (RightHand)
+	{
+		RightHand->UpdateGrasp(InputFrame.RightGrasp);
+	}
+
+	AMCCharacter::UpdateHands(StepDeltaTime);
+}
+
+// Apply the active quality tier of the frame budget governor
+void AMCCharacter::ApplyQualityTier()
+{
+	const FMCQualityTier& Tier = FrameBudgetGovernor.GetActiveTier();
+	if (LeftHand)
+	{
+		LeftHand->SetFingerDriveUpdateInterval(Tier.FingerDriveUpdateInterval);
+	}
+	if (RightHand)
+	{
+		RightHand->SetFingerDriveUpdateInterval(Tier.FingerDriveUpdateInterval);
 	}
 }
 
@@ -240,37 +1154,120 @@ FORCEINLINE void AMCCharacter::UpdateHandLocationAndRotation(
 	UMotionControllerComponent* MC,
 	const FQuat& RotOffset,
 	USkeletalMeshComponent* SkelMesh,
-	PIDController3D& PIDController,
+	AMCHand* Hand,
+	FMCPIDController3& PIDController,
+	const EMCLinearControl LinearControl,
 	const float DeltaTime)
 {
+	// Target motion estimated from the kinematic history (acceleration for the force strategy, velocity otherwise)
+	const bool bMassAware = bMassAwareControl && Hand;
+	FMCVec3 LocFeedforward;
+	FVector RotFeedforward = FVector::ZeroVector;
+	if (bMassAware && FeedforwardGain > 0.f)
+	{
+		const FMCKinematicHistory& History = Hand->GetKinematicHistory();
+		LocFeedforward = FMCControlAdapter::ToCore(LinearControl == EMCLinearControl::ForcePD ?
+			History.GetTargetLinearAcceleration(FeedforwardSamples) : History.GetTargetLinearVelocity(FeedforwardSamples)) * FeedforwardGain;
+		RotFeedforward = FMath::RadiansToDegrees(History.GetTargetAngularVelocity(FeedforwardSamples)) * FeedforwardGain;
+	}
+
 	//// Location
-	const FVector Error = MC->GetComponentLocation() - SkelMesh->GetComponentLocation();
-	const FVector LocOutput = PIDController.UpdateAsPD(Error, DeltaTime);
-	SkelMesh->AddForceToAllBodiesBelow(LocOutput, NAME_None, true, true);
-	//// Velocity based control
-	//const FVector LocOutput = PIDController.UpdateAsP(Error, DeltaTime);
-	//SkelMesh->SetAllPhysicsLinearVelocity(LocOutput);
+	const FMCVec3 Error = FMCControlAdapter::ToCore(MC->GetComponentLocation() - SkelMesh->GetComponentLocation());
+	const MCControl::ELinearStrategy Strategy = static_cast<MCControl::ELinearStrategy>(LinearControl);
+	const FMCVec3 Velocity = Strategy == MCControl::LinearImpulse
+		? FMCControlAdapter::ToCore(SkelMesh->GetPhysicsLinearVelocity()) : FMCVec3();
+	const FMCVec3 LocOutput = MCControl::UpdateLinear(PIDController, Strategy, Error, Velocity, DeltaTime);
+	switch (LinearControl)
+	{
+	case EMCLinearControl::VelocityP:
+		SkelMesh->SetAllPhysicsLinearVelocity(FMCControlAdapter::ToEngine(LocOutput + LocFeedforward));
+		break;
+	case EMCLinearControl::Impulse:
+		SkelMesh->AddImpulseToAllBodiesBelow(FMCControlAdapter::ToEngine(LocOutput + LocFeedforward), NAME_None, true, true);
+		break;
+	default:
+		if (bMassAware)
+		{
+			// Force of every body scaled with its mass, the palm body mass includes the welded object,
+			// the forces add up to the hand and carried object mass
+			for (FBodyInstance* Body : SkelMesh->Bodies)
+			{
+				if (Body && Body->IsInstanceSimulatingPhysics())
+				{
+					Body->AddForce(FMCControlAdapter::ToEngine(
+						MCControl::ScheduleForce(LocOutput, LocFeedforward, Body->GetBodyMass())), true, false);
+				}
+			}
+		}
+		else
+		{
+			SkelMesh->AddForceToAllBodiesBelow(FMCControlAdapter::ToEngine(LocOutput), NAME_None, true, true);
+		}
+		break;
+	}
 
 	//// Rotation
-	const FQuat TargetQuat = MC->GetComponentQuat() * RotOffset;
-	FQuat CurrQuat = SkelMesh->GetComponentQuat();
+	// Use the xyz part of the shortest path error quat as the rotation velocity
+	const FMCVec3 RotError = MCControl::RotationErrorVector(
+		FMCControlAdapter::ToCore(MC->GetComponentQuat() * RotOffset), FMCControlAdapter::ToCore(SkelMesh->GetComponentQuat()));
+	const FVector AngularVelocity = FMCControlAdapter::ToEngine(RotError * RotationBoost) + RotFeedforward;
+	if (bMassAware && DeltaTime > 0.f)
+	{
+		// Torque of every body scaled with its inertia tensor (acceleration change, the palm body inertia includes the
+		// welded object) reaching the palm target velocity within the step, keeps the finger velocities relative to the palm
+		const FVector AngularAcceleration = FMath::DegreesToRadians(
+			AngularVelocity - SkelMesh->GetPhysicsAngularVelocityInDegrees()) / DeltaTime;
+		for (FBodyInstance* Body : SkelMesh->Bodies)
+		{
+			if (Body && Body->IsInstanceSimulatingPhysics())
+			{
+				Body->AddTorqueInRadians(AngularAcceleration, true, true);
+			}
+		}
+	}
+	else
+	{
+		SkelMesh->SetAllPhysicsAngularVelocityInDegrees(AngularVelocity);
+	}
+}
+
+// Set the controller gains for the linear control strategy
+void AMCCharacter::SetupLinearController(FMCPIDController3& PIDController, const EMCLinearControl LinearControl)
+{
+	if (LinearControl == EMCLinearControl::ForcePD)
+	{
+		PIDController.SetValues(PGain, IGain, DGain, MaxOutput, -MaxOutput);
+	}
+	else
+	{
+		PIDController.SetValues(VelocityPGain, 0.f, 0.f, VelocityMaxOutput, -VelocityMaxOutput);
+	}
+}
 
-	// Dot product to get cos theta
-	const float CosTheta = TargetQuat | CurrQuat;
-	// Avoid taking the long path around the sphere
-	if (CosTheta < 0)
+// Switch the linear control strategy of a hand, the controller gains are set for the strategy
+void AMCCharacter::SetLinearControl(const EHandType InHandType, const EMCLinearControl InLinearControl)
+{
+	if (InHandType == EHandType::Left)
+	{
+		LeftLinearControl = InLinearControl;
+		AMCCharacter::SetupLinearController(LeftPIDController, LeftLinearControl);
+	}
+	else
 	{
-		CurrQuat *= -1.f;
+		RightLinearControl = InLinearControl;
+		AMCCharacter::SetupLinearController(RightPIDController, RightLinearControl);
 	}
-	// Use the xyz part of the quat as the rotation velocity
-	const FQuat OutputFromQuat = TargetQuat * CurrQuat.Inverse();
-	const FVector RotOutput = FVector(OutputFromQuat.X, OutputFromQuat.Y, OutputFromQuat.Z) * RotationBoost;
-	SkelMesh->SetAllPhysicsAngularVelocityInDegrees(RotOutput);
 }
 
 // Switch Grasp
 void AMCCharacter::SwitchGrasp()
 {
+	if (bDeterministicMode)
+	{
+		PendingInput.Actions |= MCIA_SwitchGrasp;
+		return;
+	}
+
 	if (RightHand)
 	{
 		RightHand->SwitchGrasp();
@@ -285,8 +1282,21 @@ void AMCCharacter::SwitchGrasp()
 // Update left hand grasp
 void AMCCharacter::GraspWithLeftHand(const float Val)
 {
+	// The gloves drive the finger joints
+	if (bUseGloveInput)
+	{
+		return;
+	}
+
+	if (bDeterministicMode)
+	{
+		PendingInput.LeftGrasp = Val;
+		return;
+	}
+
 	if (LeftHand)
 	{
+		FMCScopedPluginCost PluginCost(FrameBudgetGovernor);
 		LeftHand->UpdateGrasp(Val);
 	}
 }
@@ -294,8 +1304,21 @@ void AMCCharacter::GraspWithLeftHand(const float Val)
 // Update right hand grasp
 void AMCCharacter::GraspWithRightHand(const float Val)
 {
+	// The gloves drive the finger joints
+	if (bUseGloveInput)
+	{
+		return;
+	}
+
+	if (bDeterministicMode)
+	{
+		PendingInput.RightGrasp = Val;
+		return;
+	}
+
 	if (RightHand)
 	{
+		FMCScopedPluginCost PluginCost(FrameBudgetGovernor);
 		RightHand->UpdateGrasp(Val);
 		//RightHand->UpdateGrasp2(Val); // TODO For the realisitc grasping part
 	}
@@ -304,33 +1327,38 @@ void AMCCharacter::GraspWithRightHand(const float Val)
 // Attach to left hand
 void AMCCharacter::TryLeftFixationGrasp()
 {
-	if (bTryFixationGrasp && LeftHand)
+	if (bDeterministicMode)
 	{
-		// If one hand attachment is not possible, check for two hands
-		if (!LeftHand->TryOneHandFixationGrasp())
-		{
-			// If other hand is set and two hand grasp is enabled
-			if (bTryTwoHandsFixationGrasp && RightHand)
-			{
-				// Try grasping with two hands
-				LeftHand->TryTwoHandsFixationGrasp();
-			}
-		}
+		PendingInput.Actions |= MCIA_LeftAttach;
+		return;
 	}
+	AMCCharacter::ApplyFixationGrasp(LeftHand, RightHand);
 }
 
 // Attach to right hand
 void AMCCharacter::TryRightFixationGrasp()
 {
-	if (bTryFixationGrasp && RightHand)
+	if (bDeterministicMode)
+	{
+		PendingInput.Actions |= MCIA_RightAttach;
+		return;
+	}
+	AMCCharacter::ApplyFixationGrasp(RightHand, LeftHand);
+}
+
+// Try fixation grasp with the hand, or two hands fixation grasp with the other hand
+void AMCCharacter::ApplyFixationGrasp(AMCHand* Hand, AMCHand* InOtherHand)
+{
+	if (bTryFixationGrasp && Hand)
 	{
 		// If one hand attachment is not possible, check for two hands
-		if (!RightHand->TryOneHandFixationGrasp())
+		if (!Hand->TryOneHandFixationGrasp())
 		{
-			if (bTryTwoHandsFixationGrasp && LeftHand)
+			// If other hand is set and two hand grasp is enabled
+			if (bTryTwoHandsFixationGrasp && InOtherHand)
 			{
-				// Check if two hand fixation is possible
-				RightHand->TryTwoHandsFixationGrasp();
+				// Try grasping with two hands
+				Hand->TryTwoHandsFixationGrasp();
 			}
 		}
 	}
@@ -339,6 +1367,12 @@ void AMCCharacter::TryRightFixationGrasp()
 // Detach from left hand
 void AMCCharacter::TryLeftGraspDetach()
 {
+	if (bDeterministicMode)
+	{
+		PendingInput.Actions |= MCIA_LeftDetach;
+		return;
+	}
+
 	if (LeftHand)
 	{
 		LeftHand->DetachFixationGrasp();
@@ -348,8 +1382,30 @@ void AMCCharacter::TryLeftGraspDetach()
 // Detach from right hand
 void AMCCharacter::TryRightGraspDetach()
 {
+	if (bDeterministicMode)
+	{
+		PendingInput.Actions |= MCIA_RightDetach;
+		return;
+	}
+
 	if (RightHand)
 	{
 		RightHand->DetachFixationGrasp();
 	}
 }
+
+// Calls the post physics tick of the character
+void FMCCharacterPostPhysicsTickFunction::ExecuteTick(float DeltaTime, ELevelTick TickType,
+	ENamedThreads::Type CurrentThread, const FGraphEventRef& MyCompletionGraphEvent)
+{
+	if (Target && !Target->IsPendingKill())
+	{
+		Target->PostPhysicsTick(DeltaTime);
+	}
+}
+
+// Describe the tick function
+FString FMCCharacterPostPhysicsTickFunction::DiagnosticMessage()
+{
+	return Target ? Target->GetFullName() + TEXT("[PostPhysicsTick]") : TEXT("FMCCharacterPostPhysicsTickFunction");
+}
@@ -0,0 +1,37 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MCControlCore.h"
+
+/**
+* Conversions between the engine math types and the control core types
+*/
+struct FMCControlAdapter
+{
+	// Engine vector to core vector
+	static FORCEINLINE FMCVec3 ToCore(const FVector& V)
+	{
+		return FMCVec3(V.X, V.Y, V.Z);
+	}
+
+	// Engine quaternion to core quaternion
+	static FORCEINLINE FMCQuat ToCore(const FQuat& Q)
+	{
+		return FMCQuat(Q.X, Q.Y, Q.Z, Q.W);
+	}
+
+	// Core vector to engine vector
+	static FORCEINLINE FVector ToEngine(const FMCVec3& V)
+	{
+		return FVector(V.X, V.Y, V.Z);
+	}
+
+	// Core quaternion to engine quaternion
+	static FORCEINLINE FQuat ToEngine(const FMCQuat& Q)
+	{
+		return FQuat(Q.X, Q.Y, Q.Z, Q.W);
+	}
+};
@@ -0,0 +1,323 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCEpisodeOrchestratorCommandlet.h"
+#include "MCSemanticEventLog.h"
+#include "MCTrajectoryExporter.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFilemanager.h"
+#include "HAL/PlatformProcess.h"
+#include "HAL/PlatformMisc.h"
+#include "Misc/ConfigCacheIni.h"
+
+// Sets default values
+UMCEpisodeOrchestratorCommandlet::UMCEpisodeOrchestratorCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+	WorkerTimeout = 7200.f;
+}
+
+// Run the orchestrator
+int32 UMCEpisodeOrchestratorCommandlet::Main(const FString& Params)
+{
+	if (!FParse::Value(*Params, TEXT("MCOutput="), OutputDirectory))
+	{
+		OutputDirectory = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MCEpisodes"));
+	}
+	OutputDirectory = FPaths::ConvertRelativePathToFull(OutputDirectory);
+
+	int32 NumWorkers = FPlatformMisc::NumberOfCores();
+	FParse::Value(*Params, TEXT("Workers="), NumWorkers);
+	NumWorkers = FMath::Max(NumWorkers, 1);
+
+	if (FParse::Param(*Params, TEXT("MergeOnly")))
+	{
+		return UMCEpisodeOrchestratorCommandlet::MergeWorkerOutputs(NumWorkers) ? 0 : 1;
+	}
+
+	// The workers only run episodes if the episode runner is the game instance of the project
+	if (!UMCEpisodeOrchestratorCommandlet::IsEpisodeRunnerGameInstance())
+	{
+		UE_LOG(LogTemp, Error, TEXT("UMCEpisodeOrchestratorCommandlet: The project GameInstanceClass is not UMCEpisodeRunner, the workers would never exit! "
+			"Set [/Script/EngineSettings.GameMapsSettings] GameInstanceClass=/Script/UMCInteraction.MCEpisodeRunner in DefaultEngine.ini"));
+		return 1;
+	}
+
+	// Workers still running after the timeout (s) are terminated and count as failed
+	FParse::Value(*Params, TEXT("WorkerTimeout="), WorkerTimeout);
+
+	FString EpisodesFile;
+	TArray<FMCEpisode> Episodes;
+	if (!FParse::Value(*Params, TEXT("MCEpisodes="), EpisodesFile) ||
+		!UMCEpisodeRunner::ReadEpisodesFile(EpisodesFile, Episodes) || Episodes.Num() == 0)
+	{
+		UE_LOG(LogTemp, Error, TEXT("UMCEpisodeOrchestratorCommandlet: No episodes to run (-MCEpisodes=<Episodes.json>)!"));
+		return 1;
+	}
+
+	// Write one episode file per worker
+	TArray<TArray<FMCEpisode>> Shards;
+	UMCEpisodeOrchestratorCommandlet::ShardEpisodes(Episodes, FMath::Min(NumWorkers, Episodes.Num()), Shards);
+	TArray<FString> ShardFiles;
+	for (int32 ShardIdx = 0; ShardIdx < Shards.Num(); ++ShardIdx)
+	{
+		const FString ShardFile = FPaths::Combine(OutputDirectory, TEXT("Shards"), FString::Printf(TEXT("Shard_%d.json"), ShardIdx));
+		if (!UMCEpisodeRunner::WriteEpisodesFile(ShardFile, Shards[ShardIdx]))
+		{
+			UE_LOG(LogTemp, Error, TEXT("UMCEpisodeOrchestratorCommandlet: Could not write %s!"), *ShardFile);
+			return 1;
+		}
+		ShardFiles.Add(ShardFile);
+	}
+
+	const double StartTime = FPlatformTime::Seconds();
+	const int32 NumFailed = UMCEpisodeOrchestratorCommandlet::RunWorkers(ShardFiles);
+	UE_LOG(LogTemp, Log, TEXT("UMCEpisodeOrchestratorCommandlet: %d episodes on %d workers in %.1f s, %d workers failed"),
+		Episodes.Num(), ShardFiles.Num(), FPlatformTime::Seconds() - StartTime, NumFailed);
+
+	return UMCEpisodeOrchestratorCommandlet::MergeWorkerOutputs(ShardFiles.Num()) && NumFailed == 0 ? 0 : 1;
+}
+
+// Split the episodes into shards of similar total input length (longest episodes first, to the least loaded shard)
+void UMCEpisodeOrchestratorCommandlet::ShardEpisodes(const TArray<FMCEpisode>& Episodes, const int32 NumShards,
+	TArray<TArray<FMCEpisode>>& OutShards)
+{
+	// The input recording size is proportional to the number of simulation steps
+	TArray<TPair<int64, int32>> SizeToEpisodeIdx;
+	for (int32 EpisodeIdx = 0; EpisodeIdx < Episodes.Num(); ++EpisodeIdx)
+	{
+		const int64 Size = IFileManager::Get().FileSize(*Episodes[EpisodeIdx].InputRecordingFile);
+		SizeToEpisodeIdx.Add(TPair<int64, int32>(FMath::Max<int64>(Size, 1), EpisodeIdx));
+	}
+	SizeToEpisodeIdx.Sort([](const TPair<int64, int32>& A, const TPair<int64, int32>& B) { return A.Key > B.Key; });
+
+	OutShards.SetNum(NumShards);
+	TArray<int64> ShardLoads;
+	ShardLoads.Init(0, NumShards);
+	for (const TPair<int64, int32>& Pair : SizeToEpisodeIdx)
+	{
+		int32 MinShardIdx = 0;
+		for (int32 ShardIdx = 1; ShardIdx < NumShards; ++ShardIdx)
+		{
+			if (ShardLoads[ShardIdx] < ShardLoads[MinShardIdx])
+			{
+				MinShardIdx = ShardIdx;
+			}
+		}
+		OutShards[MinShardIdx].Add(Episodes[Pair.Value]);
+		ShardLoads[MinShardIdx] += Pair.Key;
+	}
+}
+
+// Launch the workers and wait for them to finish, returns the number of failed workers
+int32 UMCEpisodeOrchestratorCommandlet::RunWorkers(const TArray<FString>& ShardFiles)
+{
+	const FString Executable = FPlatformProcess::ExecutablePath();
+	const FString ProjectFile = FPaths::ConvertRelativePathToFull(FPaths::GetProjectFilePath());
+	const int32 NumCores = FPlatformMisc::NumberOfCores();
+
+	TArray<FProcHandle> Workers;
+	for (int32 WorkerIdx = 0; WorkerIdx < ShardFiles.Num(); ++WorkerIdx)
+	{
+		// One core per worker, game thread pinned by the runner
+		const uint64 CoreMask = 1ull << (WorkerIdx % FMath::Min(NumCores, 64));
+		const FString WorkerParams = FString::Printf(
+			TEXT("\"%s\" -game -nullrhi -unattended -nosound -nosplash -MCEpisodes=\"%s\" -MCOutput=\"%s\" -MCCoreMask=%llx -abslog=\"%s\""),
+			*ProjectFile, *ShardFiles[WorkerIdx], *UMCEpisodeOrchestratorCommandlet::GetWorkerDirectory(WorkerIdx), CoreMask,
+			*FPaths::Combine(UMCEpisodeOrchestratorCommandlet::GetWorkerDirectory(WorkerIdx), TEXT("Worker.log")));
+
+		FProcHandle Worker = FPlatformProcess::CreateProc(*Executable, *WorkerParams, false, true, true, nullptr, 0, nullptr, nullptr);
+		if (!Worker.IsValid())
+		{
+			UE_LOG(LogTemp, Error, TEXT("UMCEpisodeOrchestratorCommandlet: Could not launch worker %d!"), WorkerIdx);
+		}
+		Workers.Add(Worker);
+	}
+
+	// The workers run in parallel, they share the same deadline
+	const double Deadline = FPlatformTime::Seconds() + WorkerTimeout;
+	int32 NumFailed = 0;
+	for (int32 WorkerIdx = 0; WorkerIdx < Workers.Num(); ++WorkerIdx)
+	{
+		FProcHandle& Worker = Workers[WorkerIdx];
+		if (!Worker.IsValid())
+		{
+			NumFailed++;
+			continue;
+		}
+		while (FPlatformProcess::IsProcRunning(Worker) && (WorkerTimeout <= 0.f || FPlatformTime::Seconds() < Deadline))
+		{
+			FPlatformProcess::Sleep(0.5f);
+		}
+		if (FPlatformProcess::IsProcRunning(Worker))
+		{
+			UE_LOG(LogTemp, Error, TEXT("UMCEpisodeOrchestratorCommandlet: Worker %d still running after %.0f s, terminating it!"),
+				WorkerIdx, WorkerTimeout);
+			FPlatformProcess::TerminateProc(Worker, true);
+			FPlatformProcess::CloseProc(Worker);
+			NumFailed++;
+			continue;
+		}
+		int32 ReturnCode = 0;
+		if (!FPlatformProcess::GetProcReturnCode(Worker, &ReturnCode) || ReturnCode != 0)
+		{
+			UE_LOG(LogTemp, Error, TEXT("UMCEpisodeOrchestratorCommandlet: Worker %d exited with %d!"), WorkerIdx, ReturnCode);
+			NumFailed++;
+		}
+		FPlatformProcess::CloseProc(Worker);
+	}
+	return NumFailed;
+}
+
+// Move the worker episode outputs into the dataset directory, merge their logs and write its index
+bool UMCEpisodeOrchestratorCommandlet::MergeWorkerOutputs(const int32 NumWorkers)
+{
+	IFileManager& FileManager = IFileManager::Get();
+	const FString DatasetDirectory = FPaths::Combine(OutputDirectory, TEXT("Dataset"));
+	FileManager.MakeDirectory(*DatasetDirectory, true);
+
+	// Index entries (worker, files and metrics) and episode directories
+	TArray<FString> EpisodeEntries;
+	TArray<FString> EpisodeDirectories;
+	for (int32 WorkerIdx = 0; WorkerIdx < NumWorkers; ++WorkerIdx)
+	{
+		const FString WorkerDirectory = UMCEpisodeOrchestratorCommandlet::GetWorkerDirectory(WorkerIdx);
+		TArray<FString> EpisodeNames;
+		FileManager.FindFiles(EpisodeNames, *FPaths::Combine(WorkerDirectory, TEXT("*")), false, true);
+		EpisodeNames.Sort();
+
+		for (const FString& EpisodeName : EpisodeNames)
+		{
+			const FString SourceDirectory = FPaths::Combine(WorkerDirectory, EpisodeName);
+			const FString TargetDirectory = FPaths::Combine(DatasetDirectory, EpisodeName);
+			if (FileManager.DirectoryExists(*TargetDirectory))
+			{
+				UE_LOG(LogTemp, Warning, TEXT("UMCEpisodeOrchestratorCommandlet: Episode %s exists in multiple workers, skipping %s.."),
+					*EpisodeName, *SourceDirectory);
+				continue;
+			}
+			if (!FileManager.Move(*TargetDirectory, *SourceDirectory))
+			{
+				UE_LOG(LogTemp, Error, TEXT("UMCEpisodeOrchestratorCommandlet: Could not move %s!"), *SourceDirectory);
+				continue;
+			}
+
+			TArray<FString> Files;
+			FileManager.FindFilesRecursive(Files, *TargetDirectory, TEXT("*"), true, false);
+			FString FileList;
+			for (const FString& File : Files)
+			{
+				FString RelativeFile = File;
+				FPaths::MakePathRelativeTo(RelativeFile, *(DatasetDirectory + TEXT("/")));
+				FileList += FString::Printf(TEXT("%s\"%s\""), FileList.IsEmpty() ? TEXT("") : TEXT(", "), *RelativeFile);
+			}
+
+			FString Metrics;
+			if (!FFileHelper::LoadFileToString(Metrics, *FPaths::Combine(TargetDirectory, TEXT("Metrics.json"))))
+			{
+				Metrics = TEXT("null");
+			}
+
+			EpisodeEntries.Add(FString::Printf(TEXT("\"Name\": \"%s\", \"Worker\": %d, \"Files\": [%s], \"Metrics\": %s"),
+				*EpisodeName, WorkerIdx, *FileList, *Metrics.TrimEnd()));
+			EpisodeDirectories.Add(TargetDirectory);
+		}
+	}
+
+	// One semantic event log and one trajectory for the whole dataset, the index holds the record and row range of every episode
+	TArray<TPair<uint64, uint64>> EventRanges;
+	UMCEpisodeOrchestratorCommandlet::MergeSemanticLogs(EpisodeDirectories, FPaths::Combine(DatasetDirectory, TEXT("SemanticEvents.bin")), EventRanges);
+	TArray<FString> TrajectoryFiles;
+	for (const FString& EpisodeDirectory : EpisodeDirectories)
+	{
+		TrajectoryFiles.Add(FPaths::Combine(EpisodeDirectory, TEXT("Trajectory.mct")));
+	}
+	TArray<TPair<uint64, uint64>> RowRanges;
+	FMCTrajectoryExporter::MergeFiles(TrajectoryFiles, FPaths::Combine(DatasetDirectory, TEXT("Trajectory.mct")), RowRanges);
+
+	FString Index = TEXT("{\n\t\"SemanticEvents\": \"SemanticEvents.bin\",\n\t\"Trajectory\": \"Trajectory.mct\",\n\t\"Episodes\": [");
+	for (int32 EpisodeIdx = 0; EpisodeIdx < EpisodeEntries.Num(); ++EpisodeIdx)
+	{
+		Index += FString::Printf(TEXT("%s\n\t\t{ %s, \"Events\": [%llu, %llu], \"Rows\": [%llu, %llu] }"),
+			EpisodeIdx > 0 ? TEXT(",") : TEXT(""), *EpisodeEntries[EpisodeIdx],
+			EventRanges[EpisodeIdx].Key, EventRanges[EpisodeIdx].Value, RowRanges[EpisodeIdx].Key, RowRanges[EpisodeIdx].Value);
+	}
+	Index += TEXT("\n\t]\n}\n");
+
+	UE_LOG(LogTemp, Log, TEXT("UMCEpisodeOrchestratorCommandlet: %d episodes merged into %s"), EpisodeEntries.Num(), *DatasetDirectory);
+	return FFileHelper::SaveStringToFile(Index, *FPaths::Combine(DatasetDirectory, TEXT("Index.json")));
+}
+
+// Concatenate the episode semantic event logs, the names are merged into one table and the event ids stay unique,
+// outputs the first record and the number of records of every episode
+bool UMCEpisodeOrchestratorCommandlet::MergeSemanticLogs(const TArray<FString>& EpisodeDirectories, const FString& OutFilename,
+	TArray<TPair<uint64, uint64>>& OutRecordRanges)
+{
+	OutRecordRanges.Init(TPair<uint64, uint64>(0, 0), EpisodeDirectories.Num());
+
+	TArray<FMCSemanticEventRecord> MergedRecords;
+	TArray<FString> MergedNames;
+	TMap<FString, uint32> MergedNameIds;
+	uint32 EventIdOffset = 0;
+	for (int32 EpisodeIdx = 0; EpisodeIdx < EpisodeDirectories.Num(); ++EpisodeIdx)
+	{
+		const FString LogFile = FPaths::Combine(EpisodeDirectories[EpisodeIdx], TEXT("SemanticEvents.bin"));
+		TArray<FMCSemanticEventRecord> Records;
+		TArray<FString> Names;
+		if (!IFileManager::Get().FileExists(*LogFile) || !FMCSemanticEventLog::ReadFromFile(LogFile, Records, Names))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("UMCEpisodeOrchestratorCommandlet: No semantic event log in %s, not merged.."),
+				*EpisodeDirectories[EpisodeIdx]);
+			continue;
+		}
+
+		// Episode name index to dataset name index
+		TArray<uint32> NameIdMap;
+		for (const FString& Name : Names)
+		{
+			const uint32* MergedNameId = MergedNameIds.Find(Name);
+			NameIdMap.Add(MergedNameId ? *MergedNameId : MergedNameIds.Add(Name, MergedNames.Add(Name)));
+		}
+
+		OutRecordRanges[EpisodeIdx] = TPair<uint64, uint64>(MergedRecords.Num(), Records.Num());
+		uint32 NumEvents = 0;
+		for (FMCSemanticEventRecord Record : Records)
+		{
+			if (!NameIdMap.IsValidIndex(Record.HandId) || !NameIdMap.IsValidIndex(Record.ObjectId))
+			{
+				continue;
+			}
+			NumEvents = FMath::Max(NumEvents, Record.EventId + 1);
+			Record.EventId += EventIdOffset;
+			Record.HandId = NameIdMap[Record.HandId];
+			Record.ObjectId = NameIdMap[Record.ObjectId];
+			MergedRecords.Add(Record);
+		}
+		OutRecordRanges[EpisodeIdx].Value = MergedRecords.Num() - OutRecordRanges[EpisodeIdx].Key;
+		EventIdOffset += NumEvents;
+	}
+	return FMCSemanticEventLog::WriteToFile(OutFilename, MergedRecords, MergedNames);
+}
+
+// Check if the project game instance (the one the workers start with) is the episode runner
+bool UMCEpisodeOrchestratorCommandlet::IsEpisodeRunnerGameInstance() const
+{
+	FString GameInstanceClassPath;
+	if (!GConfig->GetString(TEXT("/Script/EngineSettings.GameMapsSettings"), TEXT("GameInstanceClass"), GameInstanceClassPath, GEngineIni))
+	{
+		return false;
+	}
+	const UClass* GameInstanceClass = StaticLoadClass(UGameInstance::StaticClass(), nullptr, *GameInstanceClassPath);
+	return GameInstanceClass && GameInstanceClass->IsChildOf(UMCEpisodeRunner::StaticClass());
+}
+
+// Output directory of a worker
+FString UMCEpisodeOrchestratorCommandlet::GetWorkerDirectory(const int32 WorkerIdx) const
+{
+	return FPaths::Combine(OutputDirectory, FString::Printf(TEXT("Worker_%d"), WorkerIdx));
+}
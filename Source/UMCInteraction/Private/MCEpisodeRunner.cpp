@@ -0,0 +1,347 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCEpisodeRunner.h"
+#include "Containers/Ticker.h"
+#include "Misc/App.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Misc/PackageName.h"
+#include "Engine/Engine.h"
+#include "Serialization/JsonReader.h"
+#include "Serialization/JsonSerializer.h"
+#include "Serialization/JsonWriter.h"
+#include "MCWorldRegistry.h"
+#include "MCCharacter.h"
+
+// Load the episode queue from the command line
+void UMCEpisodeRunner::Init()
+{
+	Super::Init();
+
+	State = ERunnerState::Idle;
+	NumEpisodesRun = 0;
+	NumEpisodesSkipped = 0;
+	EpisodeStartTime = 0.0;
+	LoadStartTime = 0.0;
+	LoadTimeout = 120.f;
+
+	FString EpisodesFile;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("MCEpisodes="), EpisodesFile))
+	{
+		// Normal game instance
+		return;
+	}
+
+	if (!FParse::Value(FCommandLine::Get(), TEXT("MCOutput="), OutputDirectory))
+	{
+		OutputDirectory = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("MCEpisodes"));
+	}
+
+	if (!UMCEpisodeRunner::LoadEpisodes(EpisodesFile))
+	{
+		FPlatformMisc::RequestExit(false);
+		return;
+	}
+
+	// Do not wait for the wall clock between frames
+	FApp::SetBenchmarking(true);
+
+	// Pin the game thread (the bottleneck) when run as a sharded worker
+	FString CoreMaskString;
+	if (FParse::Value(FCommandLine::Get(), TEXT("MCCoreMask="), CoreMaskString))
+	{
+		const uint64 CoreMask = FCString::Strtoui64(*CoreMaskString, nullptr, 16);
+		if (CoreMask != 0)
+		{
+			FPlatformProcess::SetThreadAffinityMask(CoreMask);
+		}
+	}
+
+	// A level that fails to load never calls the post load map delegate
+	FParse::Value(FCommandLine::Get(), TEXT("MCLoadTimeout="), LoadTimeout);
+	PostLoadMapHandle = FCoreUObjectDelegates::PostLoadMapWithWorld.AddUObject(this, &UMCEpisodeRunner::OnPostLoadMap);
+	TravelFailureHandle = GEngine->OnTravelFailure().AddUObject(this, &UMCEpisodeRunner::OnTravelFailure);
+	NetworkFailureHandle = GEngine->OnNetworkFailure().AddUObject(this, &UMCEpisodeRunner::OnNetworkFailure);
+	TickerHandle = FTicker::GetCoreTicker().AddTicker(FTickerDelegate::CreateUObject(this, &UMCEpisodeRunner::RunnerTick));
+
+	UE_LOG(LogTemp, Log, TEXT("UMCEpisodeRunner: %d episodes queued, output in %s"), EpisodeQueue.Num(), *OutputDirectory);
+}
+
+// Stop running episodes
+void UMCEpisodeRunner::Shutdown()
+{
+	FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+	FCoreUObjectDelegates::PostLoadMapWithWorld.Remove(PostLoadMapHandle);
+	if (GEngine)
+	{
+		GEngine->OnTravelFailure().Remove(TravelFailureHandle);
+		GEngine->OnNetworkFailure().Remove(NetworkFailureHandle);
+	}
+
+	Super::Shutdown();
+}
+
+// Load the episode queue from a json file
+bool UMCEpisodeRunner::LoadEpisodes(const FString& Filename)
+{
+	return UMCEpisodeRunner::ReadEpisodesFile(Filename, EpisodeQueue) && EpisodeQueue.Num() > 0;
+}
+
+// Read episodes from a json file, input paths are made absolute
+bool UMCEpisodeRunner::ReadEpisodesFile(const FString& Filename, TArray<FMCEpisode>& OutEpisodes)
+{
+	// Example:
+	// { "Episodes": [ { "Name": "Ep0", "Map": "/Game/Maps/Kitchen", "Input": "Inputs/Ep0.bin", "MaxSteps": 0 } ] }
+	FString JsonString;
+	if (!FFileHelper::LoadFileToString(JsonString, *Filename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UMCEpisodeRunner: Could not read %s!"), *Filename);
+		return false;
+	}
+
+	TSharedPtr<FJsonObject> JsonObject;
+	TSharedRef<TJsonReader<>> Reader = TJsonReaderFactory<>::Create(JsonString);
+	if (!FJsonSerializer::Deserialize(Reader, JsonObject) || !JsonObject.IsValid())
+	{
+		UE_LOG(LogTemp, Error, TEXT("UMCEpisodeRunner: Could not parse %s!"), *Filename);
+		return false;
+	}
+
+	const TArray<TSharedPtr<FJsonValue>>* EpisodeValues;
+	if (!JsonObject->TryGetArrayField(TEXT("Episodes"), EpisodeValues))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UMCEpisodeRunner: %s has no Episodes array!"), *Filename);
+		return false;
+	}
+
+	for (const TSharedPtr<FJsonValue>& EpisodeValue : *EpisodeValues)
+	{
+		const TSharedPtr<FJsonObject>& EpisodeObject = EpisodeValue->AsObject();
+		if (!EpisodeObject.IsValid())
+		{
+			continue;
+		}
+
+		FMCEpisode Episode;
+		Episode.Name = EpisodeObject->GetStringField(TEXT("Name"));
+		Episode.Map = EpisodeObject->GetStringField(TEXT("Map"));
+		Episode.InputRecordingFile = EpisodeObject->GetStringField(TEXT("Input"));
+		Episode.MaxSteps = 0;
+		EpisodeObject->TryGetNumberField(TEXT("MaxSteps"), Episode.MaxSteps);
+		if (Episode.Name.IsEmpty())
+		{
+			Episode.Name = FString::Printf(TEXT("Episode_%d"), OutEpisodes.Num());
+		}
+
+		// Input paths are relative to the episode file
+		if (FPaths::IsRelative(Episode.InputRecordingFile))
+		{
+			Episode.InputRecordingFile = FPaths::ConvertRelativePathToFull(
+				FPaths::Combine(FPaths::GetPath(Filename), Episode.InputRecordingFile));
+		}
+		OutEpisodes.Add(Episode);
+	}
+	return true;
+}
+
+// Write episodes to a json file
+bool UMCEpisodeRunner::WriteEpisodesFile(const FString& Filename, const TArray<FMCEpisode>& Episodes)
+{
+	TArray<TSharedPtr<FJsonValue>> EpisodeValues;
+	for (const FMCEpisode& Episode : Episodes)
+	{
+		TSharedPtr<FJsonObject> EpisodeObject = MakeShareable(new FJsonObject);
+		EpisodeObject->SetStringField(TEXT("Name"), Episode.Name);
+		EpisodeObject->SetStringField(TEXT("Map"), Episode.Map);
+		EpisodeObject->SetStringField(TEXT("Input"), Episode.InputRecordingFile);
+		EpisodeObject->SetNumberField(TEXT("MaxSteps"), Episode.MaxSteps);
+		EpisodeValues.Add(MakeShareable(new FJsonValueObject(EpisodeObject)));
+	}
+	TSharedPtr<FJsonObject> JsonObject = MakeShareable(new FJsonObject);
+	JsonObject->SetArrayField(TEXT("Episodes"), EpisodeValues);
+
+	FString JsonString;
+	TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&JsonString);
+	return FJsonSerializer::Serialize(JsonObject.ToSharedRef(), Writer) &&
+		FFileHelper::SaveStringToFile(JsonString, *Filename);
+}
+
+// Run the episodes, called every frame
+bool UMCEpisodeRunner::RunnerTick(float DeltaTime)
+{
+	if (State == ERunnerState::Idle)
+	{
+		UMCEpisodeRunner::StartNextEpisode();
+	}
+	else if (State == ERunnerState::Loading)
+	{
+		if (LoadTimeout > 0.f && FPlatformTime::Seconds() - LoadStartTime > LoadTimeout)
+		{
+			UMCEpisodeRunner::SkipEpisode(FString::Printf(TEXT("level not loaded after %.0f s"), LoadTimeout));
+		}
+	}
+	else if (State == ERunnerState::Running)
+	{
+		AMCCharacter* Character = EpisodeCharacter.Get();
+		if (!Character || Character->IsReplayFinished() ||
+			(CurrentEpisode.MaxSteps > 0 && Character->GetSimulationStep() >= CurrentEpisode.MaxSteps))
+		{
+			UMCEpisodeRunner::FinishEpisode();
+		}
+	}
+	return true;
+}
+
+// Episode level loaded, start replaying the input
+void UMCEpisodeRunner::OnPostLoadMap(UWorld* LoadedWorld)
+{
+	if (State != ERunnerState::Loading || !LoadedWorld)
+	{
+		return;
+	}
+
+	// Default map loaded after a failed travel (skipped by the failure delegate or the timeout)
+	if (FPackageName::GetShortName(LoadedWorld->GetOutermost()->GetName()) != FPackageName::GetShortName(CurrentEpisode.Map))
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UMCEpisodeRunner: %s loaded while waiting for %s, ignored.."),
+			*LoadedWorld->GetMapName(), *CurrentEpisode.Map);
+		return;
+	}
+
+	const TArray<AMCCharacter*>& Characters = FMCWorldRegistry::Get(LoadedWorld).GetCharacters();
+	if (Characters.Num() == 0 || !Characters[0]->StartReplay(CurrentEpisode.InputRecordingFile))
+	{
+		UMCEpisodeRunner::SkipEpisode(TEXT("no character could replay the input"));
+		return;
+	}
+
+	// Hand and object trajectories, and the grasp events are written next to the metrics
+	FMCWorldRegistry::Get(LoadedWorld).OpenSemanticEventLog(FPaths::ConvertRelativePathToFull(
+		FPaths::Combine(UMCEpisodeRunner::GetEpisodeDirectory(CurrentEpisode), TEXT("SemanticEvents.bin"))));
+	EpisodeCharacter = Characters[0];
+	EpisodeCharacter->StartTrajectoryExport(FPaths::ConvertRelativePathToFull(
+		FPaths::Combine(UMCEpisodeRunner::GetEpisodeDirectory(CurrentEpisode), TEXT("Trajectory.mct"))));
+	EpisodeStartTime = FPlatformTime::Seconds();
+	State = ERunnerState::Running;
+}
+
+// Load the level of the next episode, or exit if none left
+void UMCEpisodeRunner::StartNextEpisode()
+{
+	if (EpisodeQueue.Num() == 0)
+	{
+		UE_LOG(LogTemp, Log, TEXT("UMCEpisodeRunner: %d episodes run, %d skipped, exiting.."), NumEpisodesRun, NumEpisodesSkipped);
+		FTicker::GetCoreTicker().RemoveTicker(TickerHandle);
+		FPlatformMisc::RequestExit(false);
+		return;
+	}
+
+	CurrentEpisode = EpisodeQueue[0];
+	EpisodeQueue.RemoveAt(0);
+	IPlatformFile& PlatformFile = FPlatformFileManager::Get().GetPlatformFile();
+	PlatformFile.CreateDirectoryTree(*UMCEpisodeRunner::GetEpisodeDirectory(CurrentEpisode));
+
+	// The previous episode world is torn down (and its logs written) when the level changes
+	State = ERunnerState::Loading;
+	LoadStartTime = FPlatformTime::Seconds();
+	UGameplayStatics::OpenLevel(GetWorld(), FName(*CurrentEpisode.Map));
+}
+
+// Episode level could not be loaded
+void UMCEpisodeRunner::OnTravelFailure(UWorld* InWorld, ETravelFailure::Type FailureType, const FString& ErrorString)
+{
+	if (State == ERunnerState::Loading)
+	{
+		UMCEpisodeRunner::SkipEpisode(FString::Printf(TEXT("travel failure %s (%s)"),
+			ETravelFailure::ToString(FailureType), *ErrorString));
+	}
+}
+
+// Episode level could not be loaded (connection to the level failed)
+void UMCEpisodeRunner::OnNetworkFailure(UWorld* InWorld, UNetDriver* NetDriver, ENetworkFailure::Type FailureType, const FString& ErrorString)
+{
+	if (State == ERunnerState::Loading)
+	{
+		UMCEpisodeRunner::SkipEpisode(FString::Printf(TEXT("network failure %s (%s)"),
+			ENetworkFailure::ToString(FailureType), *ErrorString));
+	}
+}
+
+// Mark the current episode as skipped and continue with the next one
+void UMCEpisodeRunner::SkipEpisode(const FString& Reason)
+{
+	UE_LOG(LogTemp, Error, TEXT("UMCEpisodeRunner: Episode %s skipped, %s!"), *CurrentEpisode.Name, *Reason);
+
+	const FString Metrics = FString::Printf(TEXT(
+		"{\n"
+		"\t\"Name\": \"%s\",\n"
+		"\t\"Map\": \"%s\",\n"
+		"\t\"Input\": \"%s\",\n"
+		"\t\"Skipped\": true,\n"
+		"\t\"Reason\": \"%s\"\n"
+		"}\n"),
+		*CurrentEpisode.Name, *CurrentEpisode.Map, *CurrentEpisode.InputRecordingFile.Replace(TEXT("\\"), TEXT("/")),
+		*Reason.ReplaceCharWithEscapedChar());
+	FFileHelper::SaveStringToFile(Metrics,
+		*FPaths::Combine(UMCEpisodeRunner::GetEpisodeDirectory(CurrentEpisode), TEXT("Metrics.json")));
+
+	NumEpisodesSkipped++;
+	EpisodeCharacter.Reset();
+	State = ERunnerState::Idle;
+}
+
+// Write the metrics of the finished episode
+void UMCEpisodeRunner::FinishEpisode()
+{
+	const double WallSeconds = FPlatformTime::Seconds() - EpisodeStartTime;
+	AMCCharacter* Character = EpisodeCharacter.Get();
+	const int32 NumSteps = Character ? Character->GetSimulationStep() : 0;
+	const float SimSeconds = NumSteps * FApp::GetFixedDeltaTime();
+	const int32 LeftGrasps = (Character && Character->GetLeftHand()) ? Character->GetLeftHand()->GetNumGrasps() : 0;
+	const int32 RightGrasps = (Character && Character->GetRightHand()) ? Character->GetRightHand()->GetNumGrasps() : 0;
+	const int32 LeftContacts = (Character && Character->GetLeftHand()) ? Character->GetLeftHand()->GetNumContacts() : 0;
+	const int32 RightContacts = (Character && Character->GetRightHand()) ? Character->GetRightHand()->GetNumContacts() : 0;
+
+	const FString Metrics = FString::Printf(TEXT(
+		"{\n"
+		"\t\"Name\": \"%s\",\n"
+		"\t\"Map\": \"%s\",\n"
+		"\t\"Input\": \"%s\",\n"
+		"\t\"Steps\": %d,\n"
+		"\t\"SimSeconds\": %f,\n"
+		"\t\"WallSeconds\": %f,\n"
+		"\t\"RealTimeFactor\": %f,\n"
+		"\t\"LeftGrasps\": %d,\n"
+		"\t\"RightGrasps\": %d,\n"
+		"\t\"LeftContacts\": %d,\n"
+		"\t\"RightContacts\": %d\n"
+		"}\n"),
+		*CurrentEpisode.Name, *CurrentEpisode.Map, *CurrentEpisode.InputRecordingFile.Replace(TEXT("\\"), TEXT("/")),
+		NumSteps, SimSeconds, WallSeconds, WallSeconds > 0.0 ? SimSeconds / WallSeconds : 0.0,
+		LeftGrasps, RightGrasps, LeftContacts, RightContacts);
+	FFileHelper::SaveStringToFile(Metrics,
+		*FPaths::Combine(UMCEpisodeRunner::GetEpisodeDirectory(CurrentEpisode), TEXT("Metrics.json")));
+
+	UE_LOG(LogTemp, Log, TEXT("UMCEpisodeRunner: Episode %s finished, %d steps in %.2f s (%.1fx real time)"),
+		*CurrentEpisode.Name, NumSteps, WallSeconds, WallSeconds > 0.0 ? SimSeconds / WallSeconds : 0.0);
+
+	if (Character)
+	{
+		Character->FinishTrajectoryExport();
+		FMCWorldRegistry::Get(Character->GetWorld()).CloseSemanticEventLog();
+	}
+
+	NumEpisodesRun++;
+	EpisodeCharacter.Reset();
+	State = ERunnerState::Idle;
+}
+
+// Directory of the episode output
+FString UMCEpisodeRunner::GetEpisodeDirectory(const FMCEpisode& Episode) const
+{
+	return FPaths::Combine(OutputDirectory, Episode.Name);
+}
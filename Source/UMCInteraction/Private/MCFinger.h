@@ -31,6 +31,14 @@ enum class EFingerPart : uint8
 	Distal			UMETA(DisplayName = "Distal")
 };
 
+/** Hand joint table constants (driven parts per finger: proximal, intermediate, distal) */
+enum
+{
+	MC_NUM_FINGERS = 5,
+	MC_NUM_FINGER_JOINTS = 3,
+	MC_NUM_HAND_JOINTS = MC_NUM_FINGERS * MC_NUM_FINGER_JOINTS
+};
+
 /**
 *
 */
@@ -54,26 +62,52 @@ struct FMCFinger
 	// Map of finger part to constraint
 	TMap<EFingerPart, FConstraintInstance*> FingerPartToConstraint;
 
-	// Set finger part to constraint from bone names
+	// Get the index of the finger part in the hand joint table (INDEX_NONE if the part is not driven)
+	static int32 GetJointIndex(const EFingerType InFingerType, const EFingerPart InFingerPart)
+	{
+		if (InFingerPart == EFingerPart::Metacarpal)
+		{
+			return INDEX_NONE;
+		}
+		return (uint8)InFingerType * MC_NUM_FINGER_JOINTS + ((uint8)InFingerPart - (uint8)EFingerPart::Proximal);
+	}
+
+	// Write the finger part constraints into the hand joint table
+	void AddToJointTable(TArray<FConstraintInstance*>& OutJointTable) const
+	{
+		for (const auto& MapItr : FingerPartToConstraint)
+		{
+			const int32 JointIndex = GetJointIndex(FingerType, MapItr.Key);
+			if (OutJointTable.IsValidIndex(JointIndex))
+			{
+				OutJointTable[JointIndex] = MapItr.Value;
+			}
+		}
+	}
+
+	// Set finger part to constraint from bone names, the map stays empty if a part has no constraint
 	bool SetFingerPartsConstraints(TArray<FConstraintInstance*>& Constraints)
 	{
+		// Previous constraints (e.g. of another physics asset) are no longer valid
+		FingerPartToConstraint.Empty();
+
 		// Iterate the bone names
 		for (const auto& MapItr : FingerPartToBoneName)
 		{
-			// TODO null ptr exception if the names do not match
 			// Check if bone name match with the constraint joint name
-			FConstraintInstance* FingerPartConstraint = *Constraints.FindByPredicate(
+			FConstraintInstance* const* FingerPartConstraint = Constraints.FindByPredicate(
 				[&MapItr](FConstraintInstance* ConstrInst)
 				{return ConstrInst->JointName.ToString() == MapItr.Value;}
 			);
 			// If constraint has been found, add to map
 			if (FingerPartConstraint)
 			{
-				FingerPartToConstraint.Add(MapItr.Key, FingerPartConstraint);
+				FingerPartToConstraint.Add(MapItr.Key, *FingerPartConstraint);
 			}
 			else
 			{
 				UE_LOG(LogTemp, Error, TEXT("Finger: Bone %s has no constraint!"), *MapItr.Value);
+				FingerPartToConstraint.Empty();
 				return false;
 			}
 		}
@@ -89,16 +123,27 @@ struct FMCFinger
 	{
 		for (const auto& MapItr : FingerPartToConstraint)
 		{
-			MapItr.Value->SetAngularDriveMode(DriveMode);
-			if (DriveMode == EAngularDriveMode::TwistAndSwing)
-			{
-				MapItr.Value->SetOrientationDriveTwistAndSwing(true, true);
-			}
-			else if (DriveMode == EAngularDriveMode::SLERP)
-			{
-				MapItr.Value->SetOrientationDriveSLERP(true);
-			}			
-			MapItr.Value->SetAngularDriveParams(InSpring, InDamping, InForceLimit);
+			SetConstraintDriveMode(MapItr.Value, DriveMode, InSpring, InDamping, InForceLimit);
+		}
+	}
+
+	// Set the drive mode of a single constraint
+	static void SetConstraintDriveMode(
+		FConstraintInstance* Constraint,
+		const EAngularDriveMode::Type DriveMode,
+		const float InSpring,
+		const float InDamping,
+		const float InForceLimit)
+	{
+		Constraint->SetAngularDriveMode(DriveMode);
+		if (DriveMode == EAngularDriveMode::TwistAndSwing)
+		{
+			Constraint->SetOrientationDriveTwistAndSwing(true, true);
+		}
+		else if (DriveMode == EAngularDriveMode::SLERP)
+		{
+			Constraint->SetOrientationDriveSLERP(true);
 		}
+		Constraint->SetAngularDriveParams(InSpring, InDamping, InForceLimit);
 	}
 };
\ No newline at end of file
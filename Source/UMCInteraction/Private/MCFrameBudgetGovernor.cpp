@@ -0,0 +1,158 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCFrameBudgetGovernor.h"
+#include "HAL/PlatformTime.h"
+#include "MCStats.h"
+
+// Default constructor
+FMCFrameBudgetGovernor::FMCFrameBudgetGovernor()
+{
+	bEnabled = false;
+	FrameBudgetMs = 11.1f;
+	HandSimulationBudgetMs = 3.f;
+	HeadroomRatio = 0.75f;
+	StepDownFrames = 10;
+	StepUpFrames = 90;
+	SmoothingFactor = 0.1f;
+
+	// Full fidelity, halved finger drive rate, halved controller and quartered finger drive rate
+	Tiers.Add(FMCQualityTier(1, 1));
+	Tiers.Add(FMCQualityTier(1, 2));
+	Tiers.Add(FMCQualityTier(2, 4));
+
+	// Runtime values, reset again at Init()
+	ActiveTierIndex = 0;
+	PluginCycles = 0;
+	PhysicsStartCycles = 0;
+	LastFrameEndCycles = 0;
+	SmoothedFrameMs = 0.f;
+	SmoothedPluginMs = 0.f;
+	SmoothedPhysicsMs = 0.f;
+	OverBudgetFrames = 0;
+	HeadroomFrames = 0;
+}
+
+// Reset the measurements and start at the highest tier
+void FMCFrameBudgetGovernor::Init()
+{
+	// Make sure there is always an active tier available
+	if (Tiers.Num() == 0)
+	{
+		Tiers.Add(FMCQualityTier());
+	}
+
+	ActiveTierIndex = 0;
+	PluginCycles = 0;
+	PhysicsStartCycles = 0;
+	LastFrameEndCycles = 0;
+	SmoothedFrameMs = 0.f;
+	SmoothedPluginMs = 0.f;
+	SmoothedPhysicsMs = 0.f;
+	OverBudgetFrames = 0;
+	HeadroomFrames = 0;
+
+	SET_DWORD_STAT(STAT_MCQualityTier, ActiveTierIndex);
+}
+
+// Get the active quality tier (full fidelity defaults if there are no tiers)
+const FMCQualityTier& FMCFrameBudgetGovernor::GetActiveTier() const
+{
+	// The tiers can be edited (or cleared) after Init()
+	if (!Tiers.IsValidIndex(ActiveTierIndex))
+	{
+		static const FMCQualityTier DefaultTier;
+		return Tiers.Num() > 0 ? Tiers.Last() : DefaultTier;
+	}
+	return Tiers[ActiveTierIndex];
+}
+
+// Mark the start of the physics step, only the first (sub)step of the frame is stored
+void FMCFrameBudgetGovernor::MarkPhysicsStepStart(const uint32 Cycles)
+{
+	// The physics scene can step from the substepping thread
+	FPlatformAtomics::InterlockedCompareExchange(&PhysicsStartCycles, (int32)Cycles, 0);
+}
+
+// Mark the physics results as available, returns true if the quality tier changed
+bool FMCFrameBudgetGovernor::MarkPhysicsStepEnd(const uint32 Cycles)
+{
+	const uint32 StartCycles = (uint32)FPlatformAtomics::InterlockedExchange(&PhysicsStartCycles, 0);
+	const float PhysicsMs = StartCycles != 0 ? FPlatformTime::ToMilliseconds(Cycles - StartCycles) : 0.f;
+	const float PluginMs = FPlatformTime::ToMilliseconds(PluginCycles);
+	PluginCycles = 0;
+
+	// First frame, nothing to compare against
+	if (LastFrameEndCycles == 0)
+	{
+		LastFrameEndCycles = Cycles;
+		SmoothedPluginMs = PluginMs;
+		SmoothedPhysicsMs = PhysicsMs;
+		return false;
+	}
+	const float FrameMs = FPlatformTime::ToMilliseconds(Cycles - LastFrameEndCycles);
+	LastFrameEndCycles = Cycles;
+
+	// Exponential moving average to avoid reacting to single spikes
+	SmoothedFrameMs = FMath::Lerp(SmoothedFrameMs == 0.f ? FrameMs : SmoothedFrameMs, FrameMs, SmoothingFactor);
+	SmoothedPluginMs = FMath::Lerp(SmoothedPluginMs, PluginMs, SmoothingFactor);
+	SmoothedPhysicsMs = FMath::Lerp(SmoothedPhysicsMs, PhysicsMs, SmoothingFactor);
+
+	SET_FLOAT_STAT(STAT_MCPluginFrameMs, SmoothedPluginMs);
+	SET_FLOAT_STAT(STAT_MCPhysicsStepMs, SmoothedPhysicsMs);
+
+	return bEnabled && FMCFrameBudgetGovernor::UpdateTier();
+}
+
+// Compare the smoothed times against the budgets, returns true if the tier changed
+bool FMCFrameBudgetGovernor::UpdateTier()
+{
+	// Keep the active tier valid if the tiers were edited after Init()
+	ActiveTierIndex = FMath::Clamp(ActiveTierIndex, 0, FMath::Max(Tiers.Num() - 1, 0));
+
+	const float HandSimulationMs = SmoothedPluginMs + SmoothedPhysicsMs;
+
+	if (SmoothedFrameMs > FrameBudgetMs || HandSimulationMs > HandSimulationBudgetMs)
+	{
+		HeadroomFrames = 0;
+		OverBudgetFrames++;
+	}
+	else if (SmoothedFrameMs < FrameBudgetMs * HeadroomRatio &&
+		HandSimulationMs < HandSimulationBudgetMs * HeadroomRatio)
+	{
+		OverBudgetFrames = 0;
+		HeadroomFrames++;
+	}
+	else
+	{
+		// Within budget without headroom, keep the current tier
+		OverBudgetFrames = 0;
+		HeadroomFrames = 0;
+	}
+
+	int32 NewTierIndex = ActiveTierIndex;
+	if (OverBudgetFrames >= StepDownFrames && ActiveTierIndex < Tiers.Num() - 1)
+	{
+		NewTierIndex++;
+	}
+	else if (HeadroomFrames >= StepUpFrames && ActiveTierIndex > 0)
+	{
+		NewTierIndex--;
+	}
+
+	if (NewTierIndex == ActiveTierIndex)
+	{
+		return false;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("FMCFrameBudgetGovernor: Quality tier %d -> %d (frame %.2f ms, plugin %.2f ms, physics %.2f ms)"),
+		ActiveTierIndex, NewTierIndex, SmoothedFrameMs, SmoothedPluginMs, SmoothedPhysicsMs);
+
+	ActiveTierIndex = NewTierIndex;
+	OverBudgetFrames = 0;
+	HeadroomFrames = 0;
+
+	SET_DWORD_STAT(STAT_MCQualityTier, ActiveTierIndex);
+	INC_DWORD_STAT(STAT_MCQualityTierChanges);
+	return true;
+}
@@ -0,0 +1,202 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCGloveInput.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+// Glove recording file header
+static const uint32 MCGloveRecordingMagic = 0x4C47434D; // "MCGL"
+static const uint32 MCGloveRecordingVersion = 1;
+
+// Write the recording to a binary file
+bool FMCGloveRecording::SaveToFile(const FString& Filename) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	uint32 Magic = MCGloveRecordingMagic;
+	uint32 Version = MCGloveRecordingVersion;
+	uint32 NumAngles = MC_NUM_GLOVE_ANGLES;
+	Writer << Magic << Version << NumAngles;
+	Writer << const_cast<TArray<FMCGloveFrame>&>(Frames);
+
+	if (!FFileHelper::SaveArrayToFile(Bytes, *Filename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMCGloveRecording: Could not write %s!"), *Filename);
+		return false;
+	}
+	return true;
+}
+
+// Read the recording from a binary file
+bool FMCGloveRecording::LoadFromFile(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMCGloveRecording: Could not read %s!"), *Filename);
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	uint32 NumAngles = 0;
+	Reader << Magic << Version << NumAngles;
+	if (Magic != MCGloveRecordingMagic || Version != MCGloveRecordingVersion || NumAngles != MC_NUM_GLOVE_ANGLES)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMCGloveRecording: %s is not a supported glove recording!"), *Filename);
+		return false;
+	}
+	Reader << Frames;
+	return !Reader.IsError();
+}
+
+// Constructor
+FMCGloveStream::FMCGloveStream()
+{
+	Head = 0;
+	NumFiltered = 0;
+	FilterCutoffHz = 10.f;
+	ResampleDelay = 0.01f;
+	bRecording = false;
+	bReplaying = false;
+	ReplayIndex = 0;
+	ReplayTime = 0.0;
+}
+
+// Set the filter cutoff and the resampling delay, clears the received frames
+void FMCGloveStream::Init(const float InFilterCutoffHz, const float InResampleDelay)
+{
+	FilterCutoffHz = FMath::Max(InFilterCutoffHz, 0.f);
+	ResampleDelay = FMath::Max(InResampleDelay, 0.f);
+	PendingFrames.Empty();
+	Head = 0;
+	NumFiltered = 0;
+}
+
+// Add a frame received from the device (producer thread)
+void FMCGloveStream::AddFrame(const FMCGloveFrame& Frame)
+{
+	PendingFrames.Enqueue(Frame);
+}
+
+// Filter the new frames and interpolate the angles at the resampling time
+bool FMCGloveStream::Resample(float* OutJointAngles)
+{
+	// Filter at the glove rate, before the frames are decimated to the simulation rate
+	bool bNewFrames = false;
+	FMCGloveFrame Frame;
+	while (PendingFrames.Dequeue(Frame))
+	{
+		if (bRecording)
+		{
+			Recording.Frames.Add(Frame);
+		}
+		FMCGloveStream::AddFilteredFrame(Frame);
+		bNewFrames = true;
+	}
+
+	// The resampling time only moves with new frames, the angles would be the same
+	if (!bNewFrames || NumFiltered == 0)
+	{
+		return false;
+	}
+
+	// Newest frame at or before the resampling time (the oldest frame if all are newer)
+	const double SampleTime = FMCGloveStream::GetFilteredFrame(0).Timestamp - ResampleDelay;
+	int32 Age = 0;
+	while (Age + 1 < NumFiltered && FMCGloveStream::GetFilteredFrame(Age).Timestamp > SampleTime)
+	{
+		Age++;
+	}
+
+	const FMCGloveFrame& Older = FMCGloveStream::GetFilteredFrame(Age);
+	if (Age == 0 || Older.Timestamp >= SampleTime)
+	{
+		FMemory::Memcpy(OutJointAngles, Older.JointAngles, sizeof(Older.JointAngles));
+		return true;
+	}
+
+	const FMCGloveFrame& Newer = FMCGloveStream::GetFilteredFrame(Age - 1);
+	const float Alpha = (float)((SampleTime - Older.Timestamp) / (Newer.Timestamp - Older.Timestamp));
+	for (int32 AngleIdx = 0; AngleIdx < MC_NUM_GLOVE_ANGLES; ++AngleIdx)
+	{
+		OutJointAngles[AngleIdx] = FMath::Lerp(Older.JointAngles[AngleIdx], Newer.JointAngles[AngleIdx], Alpha);
+	}
+	return true;
+}
+
+// Keep the received frames for saving them
+void FMCGloveStream::StartRecording()
+{
+	Recording.Frames.Empty();
+	bRecording = true;
+	bReplaying = false;
+}
+
+// Write the received frames to file
+bool FMCGloveStream::SaveRecording(const FString& Filename) const
+{
+	return bRecording && Recording.SaveToFile(Filename);
+}
+
+// Replace the device with a recording
+bool FMCGloveStream::StartReplay(const FString& Filename)
+{
+	bRecording = false;
+	bReplaying = Recording.LoadFromFile(Filename);
+	ReplayIndex = 0;
+	ReplayTime = 0.0;
+	FMCGloveStream::Init(FilterCutoffHz, ResampleDelay);
+	return bReplaying;
+}
+
+// Advance the replay time, adds the frames recorded up to it
+void FMCGloveStream::AdvanceReplay(const float DeltaTime)
+{
+	if (!bReplaying || Recording.Frames.Num() == 0)
+	{
+		return;
+	}
+
+	// Frames keep their recorded spacing, relative to the first frame
+	ReplayTime += DeltaTime;
+	const double StartTimestamp = Recording.Frames[0].Timestamp;
+	while (ReplayIndex < Recording.Frames.Num() && Recording.Frames[ReplayIndex].Timestamp - StartTimestamp <= ReplayTime)
+	{
+		FMCGloveStream::AddFrame(Recording.Frames[ReplayIndex++]);
+	}
+}
+
+// Low-pass filter the frame against the previous filtered frame and add it to the history
+void FMCGloveStream::AddFilteredFrame(const FMCGloveFrame& Frame)
+{
+	if (NumFiltered == 0)
+	{
+		Filtered[Head] = Frame;
+		NumFiltered = 1;
+		return;
+	}
+
+	// Duplicated or out of order frames are dropped
+	const FMCGloveFrame& Prev = FMCGloveStream::GetFilteredFrame(0);
+	const float DeltaTime = (float)(Frame.Timestamp - Prev.Timestamp);
+	if (DeltaTime <= 0.f)
+	{
+		return;
+	}
+
+	// First order low-pass, the smoothing factor follows the (irregular) frame spacing
+	const float Alpha = FilterCutoffHz > 0.f ? 1.f - FMath::Exp(-2.f * PI * FilterCutoffHz * DeltaTime) : 1.f;
+	const int32 NewHead = (Head + 1) % MC_GLOVE_HISTORY_SIZE;
+	FMCGloveFrame& Out = Filtered[NewHead];
+	Out.Timestamp = Frame.Timestamp;
+	for (int32 AngleIdx = 0; AngleIdx < MC_NUM_GLOVE_ANGLES; ++AngleIdx)
+	{
+		Out.JointAngles[AngleIdx] = Prev.JointAngles[AngleIdx] + Alpha * (Frame.JointAngles[AngleIdx] - Prev.JointAngles[AngleIdx]);
+	}
+	Head = NewHead;
+	NumFiltered = FMath::Min(NumFiltered + 1, (int32)MC_GLOVE_HISTORY_SIZE);
+}
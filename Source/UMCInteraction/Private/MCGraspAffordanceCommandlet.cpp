@@ -0,0 +1,185 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCGraspAffordanceCommandlet.h"
+#include "AssetRegistryModule.h"
+#include "Engine/StaticMesh.h"
+#include "StaticMeshResources.h"
+#include "Misc/PackageName.h"
+#include "UObject/Package.h"
+
+// Sets default values
+UMCGraspAffordanceCommandlet::UMCGraspAffordanceCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+// Run the affordance generation
+int32 UMCGraspAffordanceCommandlet::Main(const FString& Params)
+{
+	FString Path = TEXT("/Game");
+	float MaxHandAperture = 10.f;
+	float MaxTwoHandsLength = 120.f;
+	int32 NumSlices = 8;
+	FParse::Value(*Params, TEXT("Path="), Path);
+	FParse::Value(*Params, TEXT("MaxHandAperture="), MaxHandAperture);
+	FParse::Value(*Params, TEXT("MaxTwoHandsLength="), MaxTwoHandsLength);
+	FParse::Value(*Params, TEXT("Slices="), NumSlices);
+	NumSlices = FMath::Max(NumSlices, 1);
+
+	IAssetRegistry& AssetRegistry = FModuleManager::LoadModuleChecked<FAssetRegistryModule>("AssetRegistry").Get();
+	AssetRegistry.SearchAllAssets(true);
+
+	FARFilter Filter;
+	Filter.ClassNames.Add(UStaticMesh::StaticClass()->GetFName());
+	Filter.PackagePaths.Add(FName(*Path));
+	Filter.bRecursivePaths = true;
+	TArray<FAssetData> MeshAssets;
+	AssetRegistry.GetAssets(Filter, MeshAssets);
+
+	int32 NumSaved = 0;
+	for (const FAssetData& MeshAsset : MeshAssets)
+	{
+		UStaticMesh* Mesh = Cast<UStaticMesh>(MeshAsset.GetAsset());
+		if (!Mesh || !Mesh->HasValidRenderData())
+		{
+			continue;
+		}
+
+		// Vertices of the highest level of detail
+		const FPositionVertexBuffer& PositionBuffer = Mesh->RenderData->LODResources[0].PositionVertexBuffer;
+		TArray<FVector> Vertices;
+		Vertices.SetNumUninitialized(PositionBuffer.GetNumVertices());
+		for (uint32 VertexIdx = 0; VertexIdx < PositionBuffer.GetNumVertices(); ++VertexIdx)
+		{
+			Vertices[VertexIdx] = PositionBuffer.VertexPosition(VertexIdx);
+		}
+
+		TArray<FMCGraspAffordance> Affordances;
+		UMCGraspAffordanceCommandlet::ComputeAffordances(Vertices, MaxHandAperture, MaxTwoHandsLength, NumSlices, Affordances);
+
+		// Without affordances the hands keep using the bounding box size check, only stale affordances are removed
+		const bool bHadAffordances = Mesh->GetAssetUserDataOfClass(UMCGraspAffordances::StaticClass()) != nullptr;
+		Mesh->RemoveUserDataOfClass(UMCGraspAffordances::StaticClass());
+		if (Affordances.Num() == 0 && !bHadAffordances)
+		{
+			continue;
+		}
+
+		UMCGraspAffordances* MeshAffordances = nullptr;
+		if (Affordances.Num() > 0)
+		{
+			MeshAffordances = NewObject<UMCGraspAffordances>(Mesh);
+			for (const FMCGraspAffordance& Affordance : Affordances)
+			{
+				MeshAffordances->bOneHandGraspable |= Affordance.NumHands == 1;
+				MeshAffordances->bTwoHandsGraspable |= Affordance.NumHands == 2;
+			}
+			MeshAffordances->Affordances = MoveTemp(Affordances);
+			Mesh->AddAssetUserData(MeshAffordances);
+		}
+
+		UPackage* Package = Mesh->GetOutermost();
+		const FString Filename = FPackageName::LongPackageNameToFilename(
+			Package->GetName(), FPackageName::GetAssetPackageExtension());
+		if (UPackage::SavePackage(Package, nullptr, RF_Standalone, *Filename))
+		{
+			NumSaved++;
+			UE_LOG(LogTemp, Log, TEXT("UMCGraspAffordanceCommandlet: %s, %d affordances"),
+				*Mesh->GetName(), MeshAffordances ? MeshAffordances->Affordances.Num() : 0);
+		}
+		else
+		{
+			UE_LOG(LogTemp, Error, TEXT("UMCGraspAffordanceCommandlet: Could not save %s!"), *Filename);
+		}
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("UMCGraspAffordanceCommandlet: %d of %d meshes in %s updated"), NumSaved, MeshAssets.Num(), *Path);
+	return 0;
+}
+
+// Compute the affordances from the mesh vertices (mesh space)
+void UMCGraspAffordanceCommandlet::ComputeAffordances(const TArray<FVector>& Vertices, const float MaxHandAperture,
+	const float MaxTwoHandsLength, const int32 NumSlices, TArray<FMCGraspAffordance>& OutAffordances)
+{
+	OutAffordances.Empty();
+	const FBox Bounds(Vertices);
+	if (!Bounds.IsValid)
+	{
+		return;
+	}
+
+	// Slice the mesh along its longest axis, every slice can be a grasp point (handles, bottle necks)
+	const FVector Size = Bounds.GetSize();
+	const int32 LongAxis = Size.X >= Size.Y && Size.X >= Size.Z ? 0 : (Size.Y >= Size.Z ? 1 : 2);
+	const int32 CrossAxes[2] = { (LongAxis + 1) % 3, (LongAxis + 2) % 3 };
+	const float Length = Size[LongAxis];
+	const float SliceLength = FMath::Max(Length / NumSlices, KINDA_SMALL_NUMBER);
+
+	TArray<FBox> Slices;
+	Slices.Init(FBox(ForceInit), NumSlices);
+	for (const FVector& Vertex : Vertices)
+	{
+		const int32 SliceIdx = FMath::Clamp(FMath::FloorToInt((Vertex[LongAxis] - Bounds.Min[LongAxis]) / SliceLength), 0, NumSlices - 1);
+		Slices[SliceIdx] += Vertex;
+	}
+
+	auto AxisVector = [](const int32 Axis, const float Sign)
+	{
+		FVector Vector = FVector::ZeroVector;
+		Vector[Axis] = Sign;
+		return Vector;
+	};
+
+	// One hand, close around a narrow enough cross section, approach from both sides of the other cross axis
+	for (int32 SliceIdx = 0; SliceIdx < NumSlices; ++SliceIdx)
+	{
+		const FBox& Slice = Slices[SliceIdx];
+		if (!Slice.IsValid)
+		{
+			continue;
+		}
+
+		FVector Center = Slice.GetCenter();
+		Center[LongAxis] = Bounds.Min[LongAxis] + (SliceIdx + 0.5f) * SliceLength;
+		for (int32 CrossIdx = 0; CrossIdx < 2; ++CrossIdx)
+		{
+			const float Width = Slice.GetSize()[CrossAxes[CrossIdx]];
+			if (Width > MaxHandAperture)
+			{
+				continue;
+			}
+
+			const int32 ApproachAxis = CrossAxes[1 - CrossIdx];
+			for (const float Sign : { 1.f, -1.f })
+			{
+				FMCGraspAffordance Affordance;
+				Affordance.Location = Center;
+				Affordance.ApproachAxis = AxisVector(ApproachAxis, Sign);
+				Affordance.Width = Width;
+				Affordance.NumHands = 1;
+				OutAffordances.Add(Affordance);
+			}
+		}
+	}
+
+	// Two hands, press the two ends of the longest axis towards each other
+	if (Length > MaxHandAperture && Length <= MaxTwoHandsLength)
+	{
+		for (const int32 SliceIdx : { 0, NumSlices - 1 })
+		{
+			if (Slices[SliceIdx].IsValid)
+			{
+				FMCGraspAffordance Affordance;
+				Affordance.Location = Slices[SliceIdx].GetCenter();
+				Affordance.ApproachAxis = AxisVector(LongAxis, SliceIdx == 0 ? 1.f : -1.f);
+				Affordance.Width = Length;
+				Affordance.NumHands = 2;
+				OutAffordances.Add(Affordance);
+			}
+		}
+	}
+}
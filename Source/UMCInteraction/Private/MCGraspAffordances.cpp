@@ -0,0 +1,49 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCGraspAffordances.h"
+#include "Engine/StaticMesh.h"
+
+// Sets default values
+UMCGraspAffordances::UMCGraspAffordances()
+{
+	bOneHandGraspable = false;
+	bTwoHandsGraspable = false;
+}
+
+// Get the affordances of a mesh (nullptr if not generated)
+UMCGraspAffordances* UMCGraspAffordances::Get(UStaticMesh* InMesh)
+{
+	return InMesh ? Cast<UMCGraspAffordances>(InMesh->GetAssetUserDataOfClass(UMCGraspAffordances::StaticClass())) : nullptr;
+}
+
+// Find the affordance closest to the palm (mesh space)
+int32 UMCGraspAffordances::FindNearest(const FVector& PalmLocation, const FVector& PalmApproachAxis, const int32 InNumHands,
+	const float AlignmentWeight, float* OutScore) const
+{
+	int32 NearestIdx = INDEX_NONE;
+	float NearestScore = BIG_NUMBER;
+	for (int32 AffordanceIdx = 0; AffordanceIdx < Affordances.Num(); ++AffordanceIdx)
+	{
+		const FMCGraspAffordance& Affordance = Affordances[AffordanceIdx];
+		if (Affordance.NumHands != InNumHands)
+		{
+			continue;
+		}
+
+		// An aligned approach is worth AlignmentWeight cm of distance
+		const float Score = FVector::Dist(PalmLocation, Affordance.Location) -
+			AlignmentWeight * (Affordance.ApproachAxis | PalmApproachAxis);
+		if (Score < NearestScore)
+		{
+			NearestScore = Score;
+			NearestIdx = AffordanceIdx;
+		}
+	}
+
+	if (OutScore)
+	{
+		*OutScore = NearestScore;
+	}
+	return NearestIdx;
+}
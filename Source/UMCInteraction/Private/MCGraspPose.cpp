@@ -0,0 +1,48 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCGraspPose.h"
+
+// Sets default values
+UMCGraspPose::UMCGraspPose()
+{
+	GraspType = EMCGraspType::Power;
+	JointTargets.Init(FQuat::Identity, MC_NUM_HAND_JOINTS);
+}
+
+// Make sure the table is fully sized after loading
+void UMCGraspPose::PostLoad()
+{
+	Super::PostLoad();
+
+	if (!IsValidPose())
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UMCGraspPose: %s has %d joint targets instead of %d, table resized!"),
+			*GetName(), JointTargets.Num(), (int32)MC_NUM_HAND_JOINTS);
+		UMCGraspPose::ResizeJointTargets();
+	}
+}
+
+#if WITH_EDITOR
+// Keep the table fully sized when edited
+void UMCGraspPose::PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (!IsValidPose())
+	{
+		UMCGraspPose::ResizeJointTargets();
+	}
+}
+#endif // WITH_EDITOR
+
+// Resize the table to the number of hand joints, new targets are identity
+void UMCGraspPose::ResizeJointTargets()
+{
+	const int32 NumOld = JointTargets.Num();
+	JointTargets.SetNum(MC_NUM_HAND_JOINTS);
+	for (int32 Idx = NumOld; Idx < MC_NUM_HAND_JOINTS; ++Idx)
+	{
+		JointTargets[Idx] = FQuat::Identity;
+	}
+}
@@ -0,0 +1,119 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCGripper.h"
+#include "PhysicsEngine/ConstraintInstance.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "MCStats.h"
+
+// Sets default values
+AMCGripper::AMCGripper()
+{
+	FirstJawBoneName = TEXT("jaw_l");
+	SecondJawBoneName = TEXT("jaw_r");
+	JawType = EMCGripperJawType::Prismatic;
+	bMirrorSecondJaw = true;
+	JawOpenTarget = 4.f;
+	JawClosedTarget = 0.f;
+	JawStiffness = 5000.f;
+	JawDamping = 200.f;
+	JawForceLimit = 2000.f;
+
+	FirstJawConstraint = nullptr;
+	SecondJawConstraint = nullptr;
+	LastGoal = -1.f;
+}
+
+// Move the jaws between the open and the closed position
+void AMCGripper::UpdateGrasp(const float Goal)
+{
+	GraspGoal = Goal;
+
+	// The jaws keep their last target while an object is attached, by this gripper alone or together with the other hand
+	if (AMCGripper::GetGraspState() != NOT_GRASPING || Goal == LastGoal)
+	{
+		return;
+	}
+	LastGoal = Goal;
+
+	SCOPE_CYCLE_COUNTER(STAT_MCFingerDrives);
+
+	const float Target = FMath::Lerp(JawOpenTarget, JawClosedTarget, Goal);
+	if (FirstJawConstraint)
+	{
+		AMCGripper::SetJawTarget(FirstJawConstraint, Target);
+	}
+	if (SecondJawConstraint)
+	{
+		AMCGripper::SetJawTarget(SecondJawConstraint, bMirrorSecondJaw ? -Target : Target);
+	}
+}
+
+// Setup the jaw drives instead of the finger drives
+void AMCGripper::SetupAngularDriveValues(EAngularDriveMode::Type DriveMode)
+{
+	USkeletalMeshComponent* const SkelMeshComp = GetSkeletalMeshComponent();
+
+	// No finger joints, the hand joint table stays empty
+	FirstJawConstraint = SkelMeshComp->FindConstraintInstance(FirstJawBoneName);
+	SecondJawConstraint = SkelMeshComp->FindConstraintInstance(SecondJawBoneName);
+	if (!AMCGripper::SetupJawDrive(FirstJawConstraint) || !AMCGripper::SetupJawDrive(SecondJawConstraint))
+	{
+		UE_LOG(LogTemp, Error, TEXT("AMCGripper: %s jaw constraints %s / %s not found!"),
+			*GetName(), *FirstJawBoneName.ToString(), *SecondJawBoneName.ToString());
+	}
+
+	// Start opened
+	LastGoal = -1.f;
+	AMCGripper::UpdateGrasp(0.f);
+}
+
+// Setup the drive of a jaw constraint
+bool AMCGripper::SetupJawDrive(FConstraintInstance* JawConstraint)
+{
+	if (!JawConstraint)
+	{
+		return false;
+	}
+
+	// The jaw always touches the palm
+	JawConstraint->SetDisableCollision(true);
+
+	const float Range = FMath::Max(FMath::Abs(JawOpenTarget), FMath::Abs(JawClosedTarget));
+	if (JawType == EMCGripperJawType::Prismatic)
+	{
+		// Slide along the constraint X axis only
+		JawConstraint->SetLinearXLimit(ELinearConstraintMotion::LCM_Limited, Range);
+		JawConstraint->SetLinearYLimit(ELinearConstraintMotion::LCM_Locked, 0.f);
+		JawConstraint->SetLinearZLimit(ELinearConstraintMotion::LCM_Locked, 0.f);
+		JawConstraint->SetAngularSwing1Limit(EAngularConstraintMotion::ACM_Locked, 0.f);
+		JawConstraint->SetAngularSwing2Limit(EAngularConstraintMotion::ACM_Locked, 0.f);
+		JawConstraint->SetAngularTwistLimit(EAngularConstraintMotion::ACM_Locked, 0.f);
+		JawConstraint->SetLinearPositionDrive(true, false, false);
+		JawConstraint->SetLinearDriveParams(JawStiffness, JawDamping, JawForceLimit);
+	}
+	else
+	{
+		// Rotate around the constraint twist axis only
+		JawConstraint->SetAngularSwing1Limit(EAngularConstraintMotion::ACM_Locked, 0.f);
+		JawConstraint->SetAngularSwing2Limit(EAngularConstraintMotion::ACM_Locked, 0.f);
+		JawConstraint->SetAngularTwistLimit(EAngularConstraintMotion::ACM_Limited, Range);
+		JawConstraint->SetAngularDriveMode(EAngularDriveMode::TwistAndSwing);
+		JawConstraint->SetOrientationDriveTwistAndSwing(true, false);
+		JawConstraint->SetAngularDriveParams(JawStiffness, JawDamping, JawForceLimit);
+	}
+	return true;
+}
+
+// Set the target of a jaw constraint
+void AMCGripper::SetJawTarget(FConstraintInstance* JawConstraint, const float Target)
+{
+	if (JawType == EMCGripperJawType::Prismatic)
+	{
+		JawConstraint->SetLinearPositionTarget(FVector(Target, 0.f, 0.f));
+	}
+	else
+	{
+		JawConstraint->SetAngularOrientationTarget(FQuat(FRotator(0.f, 0.f, Target)));
+	}
+}
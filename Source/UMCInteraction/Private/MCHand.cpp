@@ -4,22 +4,55 @@
 #include "MCHand.h"
 #include "PhysicsEngine/ConstraintInstance.h"
 #include "Components/SkeletalMeshComponent.h"
-#include "EngineUtils.h"
+#include "Engine/CollisionProfile.h"
+#include "MCWorldRegistry.h"
 #include "TagStatics.h"
 #include "SLUtils.h"
+#include "MCStats.h"
 
 // Sets default values
 AMCHand::AMCHand()
 {
 	// Set this character to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
+	// Hands are simulated (or rendered) on every machine, the character replicates their state
+	bReplicates = false;
 
 	// Fixation grasp parameters	
 	bFixationGraspEnabled = true;
+	bWeldFingersWhileGrasped = true;
+	ReleaseVelocitySamples = 5;
+	bSnapToAffordance = true;
+	PalmApproachAxis = FVector::ForwardVector;
+	AffordanceAlignmentWeight = 5.f;
+	bPredictGraspIntent = true;
+	GraspIntentLookAhead = 0.1f;
+	GraspIntentVelocitySamples = 4;
+	GraspIntentSwitchMargin = 1.f;
+	bFingersWelded = false;
+	WeldedJointMask = 0;
+	NumGrasps = 0;
+	NumHandovers = 0;
 	bTwoHandsFixationGraspEnabled = true;
 	bMovementMimickingHand = false;
 	bGraspHeld = false;
 	bReadyForTwoHandsGrasp = false;
+	FingerDriveUpdateInterval = 1;
+	FingerDriveUpdateCounter = 0;
+	JointContactMask = 0;
+	FrozenJointMask = 0;
+	BoundJointMask = 0;
+	AppliedJointTargetMask = 0;
+	FMemory::Memzero(FrozenJointGoals);
+
+	// Grasp pose defaults, uniform curl of every joint if no grasp poses are set
+	OpenPose = nullptr;
+	ActiveGraspPoseIndex = 0;
+	JointTable.Init(nullptr, MC_NUM_HAND_JOINTS);
+	DefaultOpenTargets.Init(FQuat::Identity, MC_NUM_HAND_JOINTS);
+	DefaultClosedTargets.Init(FQuat(FRotator(0.f, 0.f, 100.f)), MC_NUM_HAND_JOINTS);
+	OpenTargets = &DefaultOpenTargets;
+	ClosedTargets = &DefaultClosedTargets;
 	OneHandFixationMaximumMass = 5.f;
 	OneHandFixationMaximumLength = 50.f;
 	TwoHandsFixationMaximumMass = 15.f;
@@ -29,22 +62,50 @@ AMCHand::AMCHand()
 	FixationGraspArea = CreateDefaultSubobject<USphereComponent>(TEXT("FixationGraspArea"));
 	FixationGraspArea->SetupAttachment(GetRootComponent());
 	FixationGraspArea->InitSphereRadius(3.f);
+	GraspableChannels.Add(ECC_WorldDynamic);
+	GraspableChannels.Add(ECC_PhysicsBody);
 
 	// Set default as left hand
 	HandType = EHandType::Left;
+	HandTopology = EMCHandTopology::FiveFingers;
+	HandRig = nullptr;
+	bUseReducedPhysicsAsset = false;
+	SemLogRuntimeManager = nullptr;
+	bGraspEventRecorded = false;
+	GraspGoal = 0.f;
+	bRemoteProxy = false;
+	RemoteAttachedObject = nullptr;
+	RemoteReleasedObject = nullptr;
+	OtherHand = nullptr;
+	OneHandGraspedObject = nullptr;
+	TwoHandsGraspableObject = nullptr;
+	TwoHandsGraspedObject = nullptr;
 
 	// Set skeletal mesh default physics related values
 	USkeletalMeshComponent* const SkelComp = GetSkeletalMeshComponent();
 	SkelComp->SetSimulatePhysics(true);
 	SkelComp->SetEnableGravity(false);
-	SkelComp->SetCollisionProfileName(TEXT("BlockAll"));
+	// Hand bodies only block what they can physically interact with (no traces, no character capsule)
+	SkelComp->SetCollisionEnabled(ECollisionEnabled::QueryAndPhysics);
+	SkelComp->SetCollisionObjectType(ECC_PhysicsBody);
+	SkelComp->SetCollisionResponseToAllChannels(ECR_Block);
+	SkelComp->SetCollisionResponseToChannel(ECC_Visibility, ECR_Ignore);
+	SkelComp->SetCollisionResponseToChannel(ECC_Camera, ECR_Ignore);
+	SkelComp->SetCollisionResponseToChannel(ECC_Pawn, ECR_Ignore);
+	HandCollisionProfileName = TEXT("MCHand");
+	bDisableFingerJointCollision = true;
+	NumContacts = 0;
+	LoadMass = 0.f;
 	SkelComp->bGenerateOverlapEvents = true;
+	SkelComp->SetNotifyRigidBodyCollision(true);
 
 	// Angular drive default values
 	AngularDriveMode = EAngularDriveMode::SLERP;
 	Spring = 9000.0f;
 	Damping = 1000.0f;
 	ForceLimit = 0.0f;
+	JointTargetTolerance = 0.1f;
+	FrozenJointReleaseMargin = 0.05f;
 
 	// Set fingers and their bone names default values
 	AMCHand::SetupHandDefaultValues(HandType);
@@ -58,12 +119,10 @@ void AMCHand::BeginPlay()
 {
 	Super::BeginPlay();
 
-	// Get the semantic log runtime manager from the world
-	for (TActorIterator<ASLRuntimeManager>RMItr(GetWorld()); RMItr; ++RMItr)
-	{
-		SemLogRuntimeManager = *RMItr;
-		break;
-	}
+	// Get the semantic log runtime manager from the world registry (the world is scanned only once)
+	FMCWorldRegistry& WorldRegistry = FMCWorldRegistry::Get(GetWorld());
+	SemLogRuntimeManager = WorldRegistry.GetSemLogRuntimeManager();
+	WorldRegistry.RegisterHand(this);
 
 	// Disable tick as default
 	SetActorTickEnabled(false);
@@ -72,8 +131,27 @@ void AMCHand::BeginPlay()
 	FixationGraspArea->OnComponentBeginOverlap.AddDynamic(this, &AMCHand::OnFixationGraspAreaBeginOverlap);
 	FixationGraspArea->OnComponentEndOverlap.AddDynamic(this, &AMCHand::OnFixationGraspAreaEndOverlap);
 
-	// Setup the values for controlling the hand fingers
-	AMCHand::SetupAngularDriveValues(AngularDriveMode);
+	// Simulate the simple interaction shapes
+	if (bUseReducedPhysicsAsset && HandRig && HandRig->ReducedPhysicsAsset)
+	{
+		GetSkeletalMeshComponent()->SetPhysicsAsset(HandRig->ReducedPhysicsAsset, true);
+	}
+
+	// Setup the values for controlling the hand fingers (or the joints of the hand variant)
+	SetupAngularDriveValues(AngularDriveMode);
+
+	// Prune the collision pairs that never matter for the interaction
+	AMCHand::SetupCollision();
+
+	// Track the finger segment contacts
+	AMCHand::SetupBoneToJointIndex();
+	GetSkeletalMeshComponent()->OnComponentHit.AddDynamic(this, &AMCHand::OnHandHit);
+
+	// Set the joint targets tables of the open and the first grasp pose
+	GraspPoses.RemoveAll([](UMCGraspPose* Pose) { return Pose == nullptr || !Pose->IsValidPose(); });
+	OpenTargets = (OpenPose && OpenPose->IsValidPose()) ? &OpenPose->JointTargets : &DefaultOpenTargets;
+	ActiveGraspPoseIndex = 0;
+	ClosedTargets = GraspPoses.Num() > 0 ? &GraspPoses[0]->JointTargets : &DefaultClosedTargets;
 
 	// Set hand semantic logging (SL) individual name
 	int32 TagIndex = FTagStatics::GetTagTypeIndex(Tags, "SemLog");
@@ -86,6 +164,14 @@ void AMCHand::BeginPlay()
 	}
 }
 
+// Called when the game ends or when destroyed
+void AMCHand::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	FMCWorldRegistry::Get(GetWorld()).UnregisterHand(this);
+
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame, used for motion control
 void AMCHand::Tick(float DeltaTime)
 {
@@ -130,6 +216,12 @@ void AMCHand::PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChang
 		AMCHand::SetupHandDefaultValues(HandType);
 	}
 
+	// If the hand topology has been changed, use its default drive mode
+	if ((PropertyName == GET_MEMBER_NAME_CHECKED(AMCHand, HandTopology)))
+	{
+		AngularDriveMode = MCGetHandTopologyDriveMode(HandTopology);
+	}
+
 	// If the skeletal mesh has been changed
 	if ((PropertyName == GET_MEMBER_NAME_CHECKED(AMCHand, GetSkeletalMeshComponent())))
 	{
@@ -161,6 +253,10 @@ void AMCHand::OnFixationGraspAreaEndOverlap(class UPrimitiveComponent* HitComp,
 {
 	// If present, remove from the graspable objects
 	OneHandGraspableObjects.Remove(Cast<AStaticMeshActor>(OtherActor));
+	if (OtherActor == GraspIntent.Object)
+	{
+		GraspIntent = FMCGraspIntent();
+	}
 
 	// If it is a two hands graspable object, clear pointer, reset flags
 	if (TwoHandsGraspableObject)
@@ -173,61 +269,210 @@ void AMCHand::OnFixationGraspAreaEndOverlap(class UPrimitiveComponent* HitComp,
 // Update the grasp pose
 void AMCHand::UpdateGrasp(const float Goal)
 {
-		if (!OneHandGraspedObject)
+	GraspGoal = Goal;
+
+	// Fingers are locked onto the palm during the held grasp
+	if (bFingersWelded)
+	{
+		return;
+	}
+
+	// Skip finger drive updates depending on the active quality tier
+	if (++FingerDriveUpdateCounter < FingerDriveUpdateInterval)
+	{
+		return;
+	}
+	FingerDriveUpdateCounter = 0;
+
+	SCOPE_CYCLE_COUNTER(STAT_MCFingerDrives);
+
+	// The topology is selected once, the joint loops are unrolled for it
+	if (!OneHandGraspedObject)
+	{
+		MCDispatchHandTopology(HandTopology, [this, Goal](auto Topology)
+		{
+			AMCHand::UpdateFingerDrives<decltype(Topology)>(Goal);
+		});
+	}
+	else if (!bGraspHeld)
+	{
+		MCDispatchHandTopology(HandTopology, [this](auto Topology)
+		{
+			AMCHand::MaintainFingerPositions<decltype(Topology)>();
+		});
+	}
+}
+
+// Blend the finger drive targets between the open and the active grasp pose, skip the frozen joints
+template<typename TopologyType>
+void AMCHand::UpdateFingerDrives(const float Goal)
+{
+	// Freeze the joints whose segments touched something, avoids driving the fingers into the contact
+	const uint32 NewContactMask = JointContactMask & ~FrozenJointMask;
+	JointContactMask = 0;
+	if (NewContactMask)
+	{
+		AMCHand::FreezeJoints<TopologyType>(NewContactMask, Goal);
+	}
+
+	// Release the frozen joints when the hand opens again, with a margin to avoid freezing and releasing every
+	// update around the contact goal (clearing the bit of a free joint has no effect)
+	if (FrozenJointMask)
+	{
+		uint32 ReleasedMask = 0;
+		TopologyType::ForEachJoint([this, Goal, &ReleasedMask](const int32 JointIdx)
 		{
-			for (const auto& ConstrMapItr : Thumb.FingerPartToConstraint)
-			{
-				ConstrMapItr.Value->SetAngularOrientationTarget(FQuat(FRotator(0.f, 0.f, Goal * 100.f)));
-			}
-			for (const auto& ConstrMapItr : Index.FingerPartToConstraint)
-			{
-				ConstrMapItr.Value->SetAngularOrientationTarget(FQuat(FRotator(0.f, 0.f, Goal * 100.f)));
-			}
-			for (const auto& ConstrMapItr : Middle.FingerPartToConstraint)
-			{
-				ConstrMapItr.Value->SetAngularOrientationTarget(FQuat(FRotator(0.f, 0.f, Goal * 100.f)));
-			}
-			for (const auto& ConstrMapItr : Ring.FingerPartToConstraint)
-			{
-				ConstrMapItr.Value->SetAngularOrientationTarget(FQuat(FRotator(0.f, 0.f, Goal * 100.f)));
-			}
-			for (const auto& ConstrMapItr : Pinky.FingerPartToConstraint)
-			{
-				ConstrMapItr.Value->SetAngularOrientationTarget(FQuat(FRotator(0.f, 0.f, Goal * 100.f)));
-			}
+			ReleasedMask |= ((uint32)(Goal < FrozenJointGoals[JointIdx] - FrozenJointReleaseMargin) << JointIdx) & FrozenJointMask;
+		});
+		if (ReleasedMask)
+		{
+			FrozenJointMask &= ~ReleasedMask;
+			AMCHand::ReleaseContacts(ReleasedMask);
 		}
-		else if (!bGraspHeld)
+	}
+
+	// Blend between the open and the active grasp pose in one pass over the joints
+	AppliedJointTargetMask = 0;
+	const TArray<FQuat>& Open = *OpenTargets;
+	const TArray<FQuat>& Closed = *ClosedTargets;
+	const uint32 DriveMask = BoundJointMask & ~FrozenJointMask;
+	TopologyType::ForEachJoint([this, &Open, &Closed, DriveMask, Goal](const int32 JointIdx)
+	{
+		if (DriveMask & (1u << JointIdx))
+		{
+			JointTable[JointIdx]->SetAngularOrientationTarget(FQuat::Slerp(Open[JointIdx], Closed[JointIdx], Goal));
+		}
+	});
+}
+
+// Drive every finger joint to its own angles
+void AMCHand::UpdateJointTargets(const float* JointAngles)
+{
+	// Fingers are locked onto the palm during the held grasp
+	if (bFingersWelded)
+	{
+		return;
+	}
+
+	SCOPE_CYCLE_COUNTER(STAT_MCFingerDrives);
+
+	MCDispatchHandTopology(HandTopology, [this, JointAngles](auto Topology)
+	{
+		AMCHand::ApplyJointTargets<decltype(Topology)>(JointAngles);
+	});
+}
+
+// Set the joint angle targets in one pass over the joints, skip the joints whose target did not change
+template<typename TopologyType>
+void AMCHand::ApplyJointTargets(const float* JointAngles)
+{
+	// Same angle to target mapping as the current joint orientations (see ReadJointOrientations)
+	const float MinDot = FMath::Cos(FMath::DegreesToRadians(JointTargetTolerance) * 0.5f);
+	TopologyType::ForEachJoint([this, JointAngles, MinDot](const int32 JointIdx)
+	{
+		if (!(BoundJointMask & (1u << JointIdx)))
+		{
+			return;
+		}
+		const float* Angles = &JointAngles[JointIdx * 3];
+		const FQuat Target(FRotator(
+			FMath::RadiansToDegrees(Angles[1]),
+			FMath::RadiansToDegrees(Angles[0]),
+			FMath::RadiansToDegrees(Angles[2])));
+		if ((AppliedJointTargetMask & (1u << JointIdx)) && FMath::Abs(AppliedJointTargets[JointIdx] | Target) >= MinDot)
+		{
+			return;
+		}
+		JointTable[JointIdx]->SetAngularOrientationTarget(Target);
+		AppliedJointTargets[JointIdx] = Target;
+		AppliedJointTargetMask |= 1u << JointIdx;
+	});
+}
+
+// Finger segment contact, marks the joint of the segment as touching
+void AMCHand::OnHandHit(UPrimitiveComponent* HitComp, AActor* OtherActor,
+	UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit)
+{
+	if (OtherActor != this)
+	{
+		// Hits are reported every step while touching, only the first one of a segment and component is a new contact
+		const int32* JointIdx = BoneToJointIndex.Find(Hit.MyBoneName);
+		bool bAlreadyTouching = false;
+		ActiveContacts.Add(FMCHandContact(OtherComp, JointIdx ? *JointIdx : INDEX_NONE), &bAlreadyTouching);
+		if (bAlreadyTouching)
 		{
-			AMCHand::MaintainFingerPositions();
+			return;
 		}
+
+		NumContacts++;
+		INC_DWORD_STAT(STAT_MCHandContacts);
+		if (JointIdx)
+		{
+			JointContactMask |= 1u << *JointIdx;
+		}
+	}
 }
 
-// Switch the grasp pose
+// Forget the contacts of the released joints (bit per joint, the palm contacts are forgotten once every joint is free)
+void AMCHand::ReleaseContacts(const uint32 InJointMask)
+{
+	const bool bAllReleased = FrozenJointMask == 0;
+	for (auto ContactIt = ActiveContacts.CreateIterator(); ContactIt; ++ContactIt)
+	{
+		const int32 JointIdx = ContactIt->JointIdx;
+		if (JointIdx == INDEX_NONE ? bAllReleased : (InJointMask & (1u << JointIdx)) != 0)
+		{
+			ContactIt.RemoveCurrent();
+		}
+	}
+}
+
+// Switch the grasp pose, cycle through the grasp poses
 void AMCHand::SwitchGrasp()
 {
+	if (GraspPoses.Num() > 0)
+	{
+		ActiveGraspPoseIndex = (ActiveGraspPoseIndex + 1) % GraspPoses.Num();
+		ClosedTargets = &GraspPoses[ActiveGraspPoseIndex]->JointTargets;
+	}
 }
 
 // Fixation grasp via attachment of the object to the hand
 bool AMCHand::TryOneHandFixationGrasp()
 {
+	// Objects held by other hands do not generate overlaps, they are handed over directly if they are the closest
+	if (!OneHandGraspedObject && AMCHand::TryHandoverFixationGrasp())
+	{
+		return true;
+	}
+
 	// If no current grasp is active and there is at least one graspable object
 	if ((!OneHandGraspedObject) && (OneHandGraspableObjects.Num() > 0))
 	{
-		// Get the object to be grasped from the pool of objects
-		OneHandGraspedObject = OneHandGraspableObjects.Pop();
+		// Grasp the predicted target, its grasp data has been looked up while the hand approached
+		int32 ObjectIdx = GraspIntent.Object ? OneHandGraspableObjects.Find(GraspIntent.Object) : INDEX_NONE;
+		if (ObjectIdx == INDEX_NONE)
+		{
+			// Get the object to be grasped from the pool of objects
+			ObjectIdx = AMCHand::SelectOneHandGraspableObject();
+			AMCHand::StageGraspIntent(OneHandGraspableObjects[ObjectIdx]);
+		}
+		OneHandGraspedObject = OneHandGraspableObjects[ObjectIdx];
+		OneHandGraspableObjects.RemoveAt(ObjectIdx);
 	
-		// TODO bug report, overlaps flicker when object is attached to hand, this prevents directly attaching objects from one hand to another
-		//if (OneHandGraspedObject->GetAttachParentActor() && OneHandGraspedObject->GetAttachParentActor()->IsA(AMCHand::StaticClass()))
-		//{
-		//	// Detach from other hand
-		//	AMCHand* OtherHand = Cast<AMCHand>(OneHandGraspedObject->GetAttachParentActor());
-		//	OtherHand->TryDetachFixationGrasp();
-		//}
+		// The object mass is no longer available once it is welded to the hand
+		LoadMass = GraspIntent.Mass;
 
 		// Disable physics on the object and attach it to the hand
 		OneHandGraspedObject->GetStaticMeshComponent()->SetSimulatePhysics(false);
 		OneHandGraspedObject->GetStaticMeshComponent()->bGenerateOverlapEvents = false;
 
+		// Grasp the object at its precomputed affordance instead of the current relative pose
+		if (bSnapToAffordance && GraspIntent.bHasAffordance)
+		{
+			AMCHand::SnapToAffordance(OneHandGraspedObject, GraspIntent.Affordance);
+		}
+
 		/*OneHandGraspedObject->AttachToComponent(GetRootComponent(), FAttachmentTransformRules(
 			EAttachmentRule::KeepWorld, EAttachmentRule::KeepWorld, EAttachmentRule::KeepWorld, true));*/
 		OneHandGraspedObject->AttachToActor(this, FAttachmentTransformRules(
@@ -238,6 +483,10 @@ bool AMCHand::TryOneHandFixationGrasp()
 		
 		// Start grasp event
 		AMCHand::StartGraspEvent(OneHandGraspedObject);
+		GraspIntent = FMCGraspIntent();
+
+		// Fingers pose does not matter during the grasp
+		AMCHand::WeldFingers();
 		
 		// Successful grasp
 		return true;
@@ -245,6 +494,94 @@ bool AMCHand::TryOneHandFixationGrasp()
 	return false;
 }
 
+// Take over the object fixation grasped by the other hand of the user if it is in reach and no free object is closer, the object stays kinematic
+bool AMCHand::TryHandoverFixationGrasp()
+{
+	if (!bFixationGraspEnabled || bRemoteProxy || AMCHand::GetGraspState() != NOT_GRASPING)
+	{
+		return false;
+	}
+
+	// Only the paired hand gives objects, and only while it actually holds the object alone
+	AMCHand* const GivingHand = OtherHand;
+	if (!GivingHand || GivingHand->bRemoteProxy || !GivingHand->OneHandGraspedObject ||
+		GivingHand->GetGraspState() != ONE_HAND_GRASPING ||
+		GivingHand->OneHandGraspedObject->GetAttachParentActor() != GivingHand ||
+		GivingHand->LoadMass >= OneHandFixationMaximumMass)
+	{
+		return false;
+	}
+
+	// The held object has to be inside the fixation grasp area (its overlap events are disabled)
+	const FVector AreaLocation = FixationGraspArea->GetComponentLocation();
+	const FBox HeldBounds = GivingHand->OneHandGraspedObject->GetStaticMeshComponent()->Bounds.GetBox();
+	const float HeldDistSquared = FVector::DistSquared(AreaLocation, HeldBounds.GetClosestPointTo(AreaLocation));
+	if (HeldDistSquared > FMath::Square(FixationGraspArea->GetScaledSphereRadius()))
+	{
+		return false;
+	}
+
+	// Free objects in reach (the predicted target among them) are grasped instead, unless the held object is closer
+	for (AStaticMeshActor* const Object : OneHandGraspableObjects)
+	{
+		const FBox Bounds = Object->GetStaticMeshComponent()->Bounds.GetBox();
+		if (FVector::DistSquared(AreaLocation, Bounds.GetClosestPointTo(AreaLocation)) <= HeldDistSquared)
+		{
+			return false;
+		}
+	}
+
+	// The carried mass moves with the object, it is not available while the object is welded
+	LoadMass = GivingHand->LoadMass;
+	OneHandGraspedObject = GivingHand->ReleaseForHandover();
+	OneHandGraspableObjects.Remove(OneHandGraspedObject);
+	GraspIntent = FMCGraspIntent();
+
+	// Grasp the object at its precomputed affordance instead of the current relative pose
+	FMCGraspAffordance Affordance;
+	float AffordanceScore;
+	if (bSnapToAffordance && AMCHand::FindGraspAffordance(OneHandGraspedObject, 1, Affordance, AffordanceScore))
+	{
+		AMCHand::SnapToAffordance(OneHandGraspedObject, Affordance);
+	}
+
+	// Re-parent the object, it keeps simulation and overlap events disabled
+	OneHandGraspedObject->AttachToActor(this, FAttachmentTransformRules(
+		EAttachmentRule::KeepWorld, EAttachmentRule::KeepWorld, EAttachmentRule::KeepWorld, true));
+
+	// Disable overlap checks for the fixation grasp area during active grasping
+	FixationGraspArea->bGenerateOverlapEvents = false;
+
+	// The grasp event of the giving hand finishes at the same time
+	AMCHand::StartGraspEvent(OneHandGraspedObject);
+	NumHandovers++;
+
+	// Fingers pose does not matter during the grasp
+	AMCHand::WeldFingers();
+	return true;
+}
+
+// Give the one hand grasped object to another hand, it is detached without enabling its physics
+AStaticMeshActor* AMCHand::ReleaseForHandover()
+{
+	AStaticMeshActor* const ReleasedObject = OneHandGraspedObject;
+	if (!ReleasedObject)
+	{
+		return nullptr;
+	}
+
+	// Finish grasp event
+	AMCHand::FinishGraspEvent(ReleasedObject);
+
+	// Release grasp position, the object is re-parented by the taking hand
+	FixationGraspArea->bGenerateOverlapEvents = true;
+	bGraspHeld = false;
+	AMCHand::UnweldFingers();
+	LoadMass = 0.f;
+	OneHandGraspedObject = nullptr;
+	return ReleasedObject;
+}
+
 // Fixation grasp of two hands attachment
 bool AMCHand::TryTwoHandsFixationGrasp()
 {
@@ -260,14 +597,35 @@ bool AMCHand::TryTwoHandsFixationGrasp()
 		// Check that both hands are in contact with the same object
 		if (TwoHandsGraspableObject && OtherHand->GetTwoHandsGraspableObject())
 		{
+			// With precomputed affordances the hands have to hold the two different ends of the object
+			FMCGraspAffordance Affordance;
+			FMCGraspAffordance OtherAffordance;
+			float AffordanceScore;
+			const bool bHasAffordances =
+				AMCHand::FindGraspAffordance(TwoHandsGraspableObject, 2, Affordance, AffordanceScore) &&
+				OtherHand->FindGraspAffordance(TwoHandsGraspableObject, 2, OtherAffordance, AffordanceScore);
+			if (bHasAffordances && Affordance.Location.Equals(OtherAffordance.Location))
+			{
+				return false;
+			}
+
 			// Set the grasped object, and clear the graspable one
 			TwoHandsGraspedObject = TwoHandsGraspableObject;
 			TwoHandsGraspableObject = nullptr;
 
+			// The object is carried by this hand, the other one is only mimicking
+			LoadMass = TwoHandsGraspedObject->GetStaticMeshComponent()->GetMass();
+
 			// Disable physics on the object and attach it to the hand
 			TwoHandsGraspedObject->GetStaticMeshComponent()->SetSimulatePhysics(false);
 			TwoHandsGraspedObject->GetStaticMeshComponent()->bGenerateOverlapEvents = false;
 
+			// Grasp the object at its precomputed ends instead of the current relative pose
+			if (bSnapToAffordance && bHasAffordances)
+			{
+				AMCHand::SnapToTwoHandsAffordances(TwoHandsGraspedObject, Affordance, OtherAffordance);
+			}
+
 			TwoHandsGraspedObject->AttachToComponent(GetRootComponent(), FAttachmentTransformRules(
 				EAttachmentRule::KeepWorld, EAttachmentRule::KeepWorld, EAttachmentRule::KeepWorld, true));
 			
@@ -281,6 +639,9 @@ bool AMCHand::TryTwoHandsFixationGrasp()
 			// Set other hands grasp as well
 			OtherHand->TwoHandsFixationGraspFromOther();
 
+			// Fingers pose does not matter during the grasp
+			AMCHand::WeldFingers();
+
 			return true;
 		}
 	}
@@ -302,6 +663,9 @@ void AMCHand::TwoHandsFixationGraspFromOther()
 
 	// Disable overlaps of the fixation grasp area during the active grasp
 	FixationGraspArea->bGenerateOverlapEvents = false;
+
+	// Fingers pose does not matter during the grasp
+	AMCHand::WeldFingers();
 }
 
 // Detach fixation grasp from hand(s)
@@ -315,6 +679,8 @@ bool AMCHand::DetachFixationGrasp()
 
 	// Release grasp position
 	bGraspHeld = false;
+	AMCHand::UnweldFingers();
+	LoadMass = 0.f;
 
 	if (OneHandGraspedObject)
 	{
@@ -328,7 +694,7 @@ bool AMCHand::DetachFixationGrasp()
 		// Enable physics with and apply current hand velocity, clear pointer to object
 		OneHandGraspedObject->GetStaticMeshComponent()->SetSimulatePhysics(true);
 		OneHandGraspedObject->GetStaticMeshComponent()->bGenerateOverlapEvents = true;
-		OneHandGraspedObject->GetStaticMeshComponent()->SetPhysicsLinearVelocity(GetVelocity());
+		AMCHand::ApplyReleaseVelocity(OneHandGraspedObject);
 		OneHandGraspedObject = nullptr;
 		return true;
 	}
@@ -344,7 +710,7 @@ bool AMCHand::DetachFixationGrasp()
 
 		// Enable physics with and apply current hand velocity, clear pointer to object
 		TwoHandsGraspedObject->GetStaticMeshComponent()->SetSimulatePhysics(true);
-		TwoHandsGraspedObject->GetStaticMeshComponent()->SetPhysicsLinearVelocity(GetVelocity());
+		AMCHand::ApplyReleaseVelocity(TwoHandsGraspedObject);
 		TwoHandsGraspedObject->GetStaticMeshComponent()->bGenerateOverlapEvents = true;
 		TwoHandsGraspedObject = nullptr;		
 
@@ -369,7 +735,11 @@ bool AMCHand::DetachFixationGrasp()
 bool AMCHand::DetachTwoHandFixationGraspFromOther()
 {
 	// Re-enable overlaps for the fixation grasp area
-	FixationGraspArea->bGenerateOverlapEvents = true;	
+	FixationGraspArea->bGenerateOverlapEvents = true;
+
+	// Release grasp position
+	AMCHand::UnweldFingers();
+	LoadMass = 0.f;
 
 	// Check grasp type of the hand (attachment or movement mimicking)
 	if (TwoHandsGraspedObject)
@@ -380,7 +750,7 @@ bool AMCHand::DetachTwoHandFixationGraspFromOther()
 
 		// Enable physics with and apply current hand velocity, clear pointer to object
 		TwoHandsGraspedObject->GetStaticMeshComponent()->SetSimulatePhysics(true);
-		TwoHandsGraspedObject->GetStaticMeshComponent()->SetPhysicsLinearVelocity(GetVelocity());
+		AMCHand::ApplyReleaseVelocity(TwoHandsGraspedObject);
 		TwoHandsGraspedObject->GetStaticMeshComponent()->bGenerateOverlapEvents = true;
 		TwoHandsGraspedObject = nullptr;
 		return true;
@@ -407,9 +777,381 @@ void AMCHand::SetOtherHand(AMCHand* InOtherHand)
 	OtherHand = InOtherHand;
 }
 
+// Set the number of grasp updates between two finger drive target updates
+void AMCHand::SetFingerDriveUpdateInterval(const int32 InInterval)
+{
+	FingerDriveUpdateInterval = FMath::Max(InInterval, 1);
+	FingerDriveUpdateCounter = 0;
+}
+
+// Get the fixation grasp state of the hand
+uint8 AMCHand::GetGraspState() const
+{
+	if (OneHandGraspedObject)
+	{
+		return ONE_HAND_GRASPING;
+	}
+	else if (TwoHandsGraspedObject)
+	{
+		return TWO_HANDS_GRASPING;
+	}
+	else if (bMovementMimickingHand)
+	{
+		return TWO_HANDS_MIMICKING;
+	}
+	return NOT_GRASPING;
+}
+
+// Write the swing 1, swing 2 and twist angles (radians) of every joint
+void AMCHand::GetJointAngles(float* OutAngles) const
+{
+	// Joints outside of the topology or without a constraint stay zero
+	FMemory::Memzero(OutAngles, sizeof(float) * MC_NUM_HAND_JOINTS * 3);
+	MCDispatchHandTopology(HandTopology, [this, OutAngles](auto Topology)
+	{
+		decltype(Topology)::ForEachJoint([this, OutAngles](const int32 JointIdx)
+		{
+			if (BoundJointMask & (1u << JointIdx))
+			{
+				const FConstraintInstance* Constraint = JointTable[JointIdx];
+				OutAngles[JointIdx * 3] = Constraint->GetCurrentSwing1();
+				OutAngles[JointIdx * 3 + 1] = Constraint->GetCurrentSwing2();
+				OutAngles[JointIdx * 3 + 2] = Constraint->GetCurrentTwist();
+			}
+		});
+	});
+}
+
+// Render the hand of another user from its replicated states
+void AMCHand::EnableRemoteProxy()
+{
+	if (bRemoteProxy)
+	{
+		return;
+	}
+	bRemoteProxy = true;
+
+	// The other user's machine simulates the interaction, nothing is touched or grasped here
+	USkeletalMeshComponent* const SkelMeshComp = GetSkeletalMeshComponent();
+	FixationGraspArea->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	SkelMeshComp->SetCollisionResponseToAllChannels(ECR_Ignore);
+	SkelMeshComp->SetNotifyRigidBodyCollision(false);
+
+	// The palm follows the replicated pose, the finger bodies follow their drives
+	if (FBodyInstance* RootBody = SkelMeshComp->GetBodyInstance())
+	{
+		RootBody->SetInstanceSimulatePhysics(false);
+	}
+}
+
+// Move the palm to the replicated pose, drive the fingers and attach the replicated fixation grasped object
+void AMCHand::ApplyRemotePose(const FMCHandNetPose& InPose)
+{
+	USkeletalMeshComponent* const SkelMeshComp = GetSkeletalMeshComponent();
+	SkelMeshComp->SetWorldLocationAndRotation(InPose.Palm.GetLocation(), InPose.Palm.GetRotation());
+
+	if (InPose.bHasJointAngles)
+	{
+		AMCHand::UpdateJointTargets(InPose.JointAngles);
+	}
+	else
+	{
+		UpdateGrasp(InPose.Grasp);
+	}
+
+	AStaticMeshActor* const AttachedObject = Cast<AStaticMeshActor>(InPose.AttachedObject);
+	if (AttachedObject == RemoteAttachedObject)
+	{
+		return;
+	}
+
+	// Dropped after all hands attached their objects (ReleaseRemoteObject), a handed over object is never simulated in between
+	if (RemoteAttachedObject)
+	{
+		RemoteReleasedObject = RemoteAttachedObject;
+	}
+	if (AttachedObject)
+	{
+		// Same relative pose as on the machine of the other user
+		AttachedObject->GetStaticMeshComponent()->SetSimulatePhysics(false);
+		AttachedObject->SetActorTransform(InPose.AttachedRelativePose * InPose.Palm, false, nullptr, ETeleportType::TeleportPhysics);
+		AttachedObject->AttachToComponent(SkelMeshComp, FAttachmentTransformRules::KeepWorldTransform);
+	}
+	RemoteAttachedObject = AttachedObject;
+}
+
+// Drop the object no longer grasped in the replicated state, unless another hand took it over
+void AMCHand::ReleaseRemoteObject()
+{
+	// Objects taken over by another hand are already re-parented
+	if (RemoteReleasedObject && RemoteReleasedObject->GetAttachParentActor() == this)
+	{
+		RemoteReleasedObject->DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+		RemoteReleasedObject->GetStaticMeshComponent()->SetSimulatePhysics(true);
+	}
+	RemoteReleasedObject = nullptr;
+}
+
+// Switch the physics asset of the hand (not while grasping), the finger joints are set up again
+bool AMCHand::SwitchPhysicsAsset(UPhysicsAsset* InPhysicsAsset)
+{
+	USkeletalMeshComponent* const SkelComp = GetSkeletalMeshComponent();
+	if (!InPhysicsAsset || SkelComp->GetPhysicsAsset() == InPhysicsAsset)
+	{
+		return InPhysicsAsset != nullptr;
+	}
+
+	if (AMCHand::GetGraspState() != NOT_GRASPING)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("AMCHand: %s cannot switch the physics asset while grasping!"), *GetName());
+		return false;
+	}
+
+	// The bodies and constraints are recreated, the joint table and the frozen joints are invalid
+	JointTable.Init(nullptr, MC_NUM_HAND_JOINTS);
+	BoundJointMask = 0;
+	JointContactMask = 0;
+	FrozenJointMask = 0;
+	ActiveContacts.Empty();
+	bGraspHeld = false;
+	SkelComp->SetPhysicsAsset(InPhysicsAsset, true);
+	SkelComp->SetSimulatePhysics(true);
+	SkelComp->SetEnableGravity(false);
+
+	SetupAngularDriveValues(AngularDriveMode);
+	AMCHand::SetupCollision();
+	return true;
+}
+
+// Switch between the detailed and the reduced physics asset of the hand rig
+bool AMCHand::SetUseReducedPhysicsAsset(const bool bReduced)
+{
+	if (!HandRig || (bReduced && !HandRig->ReducedPhysicsAsset))
+	{
+		return false;
+	}
+
+	if (AMCHand::SwitchPhysicsAsset(bReduced ? HandRig->ReducedPhysicsAsset : HandRig->PhysicsAsset))
+	{
+		bUseReducedPhysicsAsset = bReduced;
+		return true;
+	}
+	return false;
+}
+
+// Find the precomputed affordance of the object closest to the palm
+bool AMCHand::FindGraspAffordance(AStaticMeshActor* InObject, const int32 InNumHands,
+	FMCGraspAffordance& OutAffordance, float& OutScore) const
+{
+	return AMCHand::FindGraspAffordance(InObject, InNumHands, FixationGraspArea->GetComponentLocation(),
+		GetSkeletalMeshComponent()->GetComponentQuat(), OutAffordance, OutScore);
+}
+
+// Find the precomputed affordance of the object closest to the given grasp location and palm rotation
+bool AMCHand::FindGraspAffordance(AStaticMeshActor* InObject, const int32 InNumHands, const FVector& InGraspLocation,
+	const FQuat& InPalmRotation, FMCGraspAffordance& OutAffordance, float& OutScore) const
+{
+	UStaticMeshComponent* const SMComp = InObject->GetStaticMeshComponent();
+	const UMCGraspAffordances* Affordances = UMCGraspAffordances::Get(SMComp->GetStaticMesh());
+	if (!Affordances)
+	{
+		return false;
+	}
+
+	// Search in mesh space, only the palm is transformed
+	const FTransform& MeshToWorld = SMComp->GetComponentTransform();
+	const FVector PalmLocation = MeshToWorld.InverseTransformPosition(InGraspLocation);
+	const FVector PalmApproach = MeshToWorld.InverseTransformVectorNoScale(
+		InPalmRotation.RotateVector(PalmApproachAxis.GetSafeNormal()));
+	const int32 AffordanceIdx = Affordances->FindNearest(
+		PalmLocation, PalmApproach, InNumHands, AffordanceAlignmentWeight, &OutScore);
+	if (AffordanceIdx == INDEX_NONE)
+	{
+		return false;
+	}
+	OutAffordance = Affordances->Affordances[AffordanceIdx];
+	return true;
+}
+
+// Pick the one hand graspable object with the best affordance (the closest object if none have affordances)
+int32 AMCHand::SelectOneHandGraspableObject() const
+{
+	const FVector PalmLocation = FixationGraspArea->GetComponentLocation();
+	int32 BestIdx = OneHandGraspableObjects.Num() - 1;
+	float BestScore = BIG_NUMBER;
+	for (int32 ObjectIdx = 0; ObjectIdx < OneHandGraspableObjects.Num(); ++ObjectIdx)
+	{
+		AStaticMeshActor* const Object = OneHandGraspableObjects[ObjectIdx];
+		FMCGraspAffordance Affordance;
+		float Score;
+		if (!AMCHand::FindGraspAffordance(Object, 1, Affordance, Score))
+		{
+			Score = FVector::Dist(PalmLocation, Object->GetActorLocation());
+		}
+		if (Score < BestScore)
+		{
+			BestScore = Score;
+			BestIdx = ObjectIdx;
+		}
+	}
+	return BestIdx;
+}
+
+// Move the object so that the affordance grasp point is in the palm, approached along the palm axis
+void AMCHand::SnapToAffordance(AStaticMeshActor* InObject, const FMCGraspAffordance& InAffordance) const
+{
+	const FTransform& MeshToWorld = InObject->GetStaticMeshComponent()->GetComponentTransform();
+	const FVector WorldApproach = MeshToWorld.TransformVectorNoScale(InAffordance.ApproachAxis);
+	const FVector PalmApproach = GetSkeletalMeshComponent()->GetComponentQuat().RotateVector(PalmApproachAxis.GetSafeNormal());
+
+	// Smallest rotation aligning the approach axis with the palm, then move the grasp point into the palm
+	const FQuat NewRotation = FQuat::FindBetweenNormals(WorldApproach, PalmApproach) * MeshToWorld.GetRotation();
+	const FVector NewLocation = FixationGraspArea->GetComponentLocation() -
+		NewRotation.RotateVector(MeshToWorld.GetScale3D() * InAffordance.Location);
+	InObject->SetActorLocationAndRotation(NewLocation, NewRotation, false, nullptr, ETeleportType::TeleportPhysics);
+}
+
+// Move the object so that its two hand affordance ends are centered between the palms, aligned with them
+void AMCHand::SnapToTwoHandsAffordances(AStaticMeshActor* InObject, const FMCGraspAffordance& InAffordance,
+	const FMCGraspAffordance& InOtherAffordance) const
+{
+	const FTransform& MeshToWorld = InObject->GetStaticMeshComponent()->GetComponentTransform();
+	const FVector Scale = MeshToWorld.GetScale3D();
+	const FVector PalmLocation = FixationGraspArea->GetComponentLocation();
+	const FVector OtherPalmLocation = OtherHand->FixationGraspArea->GetComponentLocation();
+
+	// Smallest rotation aligning the end to end axis with the palm to palm axis, then center the ends between the palms
+	const FVector WorldEndAxis = MeshToWorld.TransformVectorNoScale(Scale * (InOtherAffordance.Location - InAffordance.Location));
+	const FQuat NewRotation = FQuat::FindBetweenNormals(WorldEndAxis.GetSafeNormal(),
+		(OtherPalmLocation - PalmLocation).GetSafeNormal()) * MeshToWorld.GetRotation();
+	const FVector NewLocation = 0.5f * (PalmLocation + OtherPalmLocation) -
+		NewRotation.RotateVector(Scale * 0.5f * (InAffordance.Location + InOtherAffordance.Location));
+	InObject->SetActorLocationAndRotation(NewLocation, NewRotation, false, nullptr, ETeleportType::TeleportPhysics);
+}
+
+// Store the current palm pose and the motion controller target pose in the kinematic history
+void AMCHand::RecordKinematics(const FTransform& TargetPose)
+{
+	KinematicHistory.Add(GetWorld()->GetTimeSeconds(), GetSkeletalMeshComponent()->GetComponentTransform(), TargetPose);
+}
+
+// Predict the likely one hand grasp target from the palm approach and stage its grasp data
+void AMCHand::UpdateGraspIntent()
+{
+	if (!bPredictGraspIntent || !bFixationGraspEnabled || bRemoteProxy || OneHandGraspedObject || OneHandGraspableObjects.Num() == 0)
+	{
+		GraspIntent = FMCGraspIntent();
+		return;
+	}
+
+	// Palm extrapolated along its approach, objects the hand moves and turns towards score better
+	const FTransform& PalmPose = GetSkeletalMeshComponent()->GetComponentTransform();
+	const FTransform PredictedPalmPose = KinematicHistory.Num() > 0 ?
+		KinematicHistory.PredictPalmPose(GraspIntentLookAhead, GraspIntentVelocitySamples) : PalmPose;
+	const FVector PredictedGraspLocation = PredictedPalmPose.TransformPosition(
+		PalmPose.InverseTransformPosition(FixationGraspArea->GetComponentLocation()));
+
+	AStaticMeshActor* BestObject = nullptr;
+	float BestScore = BIG_NUMBER;
+	float StagedScore = BIG_NUMBER;
+	for (AStaticMeshActor* const Object : OneHandGraspableObjects)
+	{
+		FMCGraspAffordance Affordance;
+		float Score;
+		if (!AMCHand::FindGraspAffordance(Object, 1, PredictedGraspLocation, PredictedPalmPose.GetRotation(), Affordance, Score))
+		{
+			Score = FVector::Dist(PredictedGraspLocation, Object->GetActorLocation());
+		}
+		if (Object == GraspIntent.Object)
+		{
+			StagedScore = Score;
+		}
+		if (Score < BestScore)
+		{
+			BestScore = Score;
+			BestObject = Object;
+		}
+	}
+
+	// Keep the staged target unless another object is clearly more likely
+	if (StagedScore < BestScore + GraspIntentSwitchMargin)
+	{
+		BestObject = GraspIntent.Object;
+	}
+
+	if (BestObject != GraspIntent.Object)
+	{
+		AMCHand::StageGraspIntent(BestObject);
+	}
+	else if (bSnapToAffordance)
+	{
+		// The affordance follows the palm, it is the one snapped to if the grasp is triggered now
+		float AffordanceScore;
+		GraspIntent.bHasAffordance = AMCHand::FindGraspAffordance(GraspIntent.Object, 1, GraspIntent.Affordance, AffordanceScore);
+	}
+}
+
+// Look up the grasp data of the object
+void AMCHand::StageGraspIntent(AStaticMeshActor* InObject)
+{
+	GraspIntent = FMCGraspIntent();
+	GraspIntent.Object = InObject;
+	if (!InObject)
+	{
+		return;
+	}
+
+	GraspIntent.Mass = InObject->GetStaticMeshComponent()->GetMass();
+
+	float AffordanceScore;
+	GraspIntent.bHasAffordance = bSnapToAffordance &&
+		AMCHand::FindGraspAffordance(InObject, 1, GraspIntent.Affordance, AffordanceScore);
+
+	// Individual names of the grasp event record
+	FMCSemanticEventLog* EventLog = FMCWorldRegistry::Get(GetWorld()).GetSemanticEventLog();
+	const int32 TagIndex = FTagStatics::GetTagTypeIndex(InObject->Tags, "SemLog");
+	if (EventLog && TagIndex != INDEX_NONE)
+	{
+		const FOwlIndividualName ObjectIndividual("log",
+			FTagStatics::GetKeyValue(InObject->Tags[TagIndex], "Class"),
+			FTagStatics::GetKeyValue(InObject->Tags[TagIndex], "Id"));
+		GraspIntent.HandNameId = EventLog->GetNameId(HandIndividual.GetName());
+		GraspIntent.ObjectNameId = EventLog->GetNameId(ObjectIndividual.GetName());
+		GraspIntent.bHasNameIds = true;
+	}
+}
+
+// Throw the released object with the filtered palm velocities
+void AMCHand::ApplyReleaseVelocity(AStaticMeshActor* ReleasedObject) const
+{
+	const FVector AngularVelocity = KinematicHistory.GetPalmAngularVelocity(ReleaseVelocitySamples);
+	const FVector PalmToObject = ReleasedObject->GetActorLocation() - GetSkeletalMeshComponent()->GetComponentLocation();
+
+	// The object keeps the velocity of its point on the rotating palm
+	UStaticMeshComponent* ObjectMesh = ReleasedObject->GetStaticMeshComponent();
+	ObjectMesh->SetPhysicsLinearVelocity(
+		KinematicHistory.GetPalmLinearVelocity(ReleaseVelocitySamples) + (AngularVelocity ^ PalmToObject));
+	ObjectMesh->SetPhysicsAngularVelocityInDegrees(FMath::RadiansToDegrees(AngularVelocity));
+}
+
 // Start grasp event
 bool AMCHand::StartGraspEvent(AActor* OtherActor)
 {
+	NumGrasps++;
+
+	// Names of the predicted target have been looked up before the grasp
+	if (OtherActor == GraspIntent.Object && GraspIntent.bHasNameIds)
+	{
+		FMCSemanticEventLog* EventLog = FMCWorldRegistry::Get(GetWorld()).GetSemanticEventLog();
+		if (EventLog)
+		{
+			GraspEventRecord = EventLog->StartGraspEvent(GetWorld()->GetTimeSeconds(),
+				GraspIntent.HandNameId, GraspIntent.ObjectNameId, OtherActor == OneHandGraspedObject ? 1 : 2);
+			bGraspEventRecorded = true;
+			return true;
+		}
+	}
+
 	// Check if actor has a semantic description
 	int32 TagIndex = FTagStatics::GetTagTypeIndex(OtherActor->Tags, "SemLog");
 
@@ -436,6 +1178,18 @@ bool AMCHand::StartGraspEvent(AActor* OtherActor)
 
 		// Create contact event and other actor individual
 		const FOwlIndividualName OtherIndividual("log", OtherActorClass, OtherActorId);
+
+		// Binary semantic event log, the OWL event is created offline
+		FMCSemanticEventLog* EventLog = FMCWorldRegistry::Get(GetWorld()).GetSemanticEventLog();
+		if (EventLog)
+		{
+			GraspEventRecord = EventLog->StartGraspEvent(GetWorld()->GetTimeSeconds(),
+				EventLog->GetNameId(HandIndividual.GetName()), EventLog->GetNameId(OtherIndividual.GetName()),
+				OtherActor == OneHandGraspedObject ? 1 : 2);
+			bGraspEventRecorded = true;
+			return true;
+		}
+
 		const FOwlIndividualName GraspingIndividual("log", "GraspingSomething", FSLUtils::GenerateRandomFString(4));
 		// Owl prefixed names
 		const FOwlPrefixName RdfType("rdf", "type");
@@ -463,7 +1217,7 @@ bool AMCHand::StartGraspEvent(AActor* OtherActor)
 			OwlNamedIndividual, RdfAbout, GraspingIndividual, Properties));
 
 		// Start the event with the given properties
-		return SemLogRuntimeManager->StartEvent(GraspEvent);
+		return SemLogRuntimeManager && SemLogRuntimeManager->StartEvent(GraspEvent);
 	}
 	return false;
 }
@@ -471,8 +1225,21 @@ bool AMCHand::StartGraspEvent(AActor* OtherActor)
 // Finish grasp event
 bool AMCHand::FinishGraspEvent(AActor* OtherActor)
 {
+	// Check if event started in the binary semantic event log
+	if (bGraspEventRecorded)
+	{
+		bGraspEventRecorded = false;
+		FMCSemanticEventLog* EventLog = FMCWorldRegistry::Get(GetWorld()).GetSemanticEventLog();
+		if (EventLog)
+		{
+			EventLog->FinishGraspEvent(GraspEventRecord, GetWorld()->GetTimeSeconds());
+			return true;
+		}
+		return false;
+	}
+
 	// Check if event started
-	if (GraspEvent.IsValid())
+	if (GraspEvent.IsValid() && SemLogRuntimeManager)
 	{
 		return SemLogRuntimeManager->FinishEvent(GraspEvent);
 		// Clear event
@@ -492,6 +1259,22 @@ uint8 AMCHand::CheckObjectGraspableType(AActor* InActor)
 		UStaticMeshComponent* const SMComp = SMActor->GetStaticMeshComponent();
 		if (SMComp && SMActor->IsRootComponentMovable() && SMComp->IsSimulatingPhysics())
 		{
+			// Precomputed affordances replace the bounding box length check (empty assets fall back to it)
+			const UMCGraspAffordances* Affordances = UMCGraspAffordances::Get(SMComp->GetStaticMesh());
+			if (Affordances && Affordances->Affordances.Num() > 0)
+			{
+				const float Mass = SMComp->GetMass();
+				if (Affordances->bOneHandGraspable && Mass < OneHandFixationMaximumMass)
+				{
+					return ONE_HAND_GRASPABLE;
+				}
+				else if (Affordances->bTwoHandsGraspable && Mass < TwoHandsFixationMaximumMass)
+				{
+					return TWO_HANDS_GRASPABLE;
+				}
+				return NOT_GRASPABLE;
+			}
+
 			if (SMComp->GetMass() < OneHandFixationMaximumMass &&
 				SMActor->GetComponentsBoundingBox().GetSize().Size() < OneHandFixationMaximumLength)
 			{
@@ -511,47 +1294,85 @@ uint8 AMCHand::CheckObjectGraspableType(AActor* InActor)
 }
 
 // Hold grasp in the current position
+template<typename TopologyType>
 void AMCHand::MaintainFingerPositions()
 {
-	//for (const auto& ConstrMapItr : Thumb.FingerPartToConstraint)
-	//{
-	//	ConstrMapItr.Value->SetAngularOrientationTarget(FQuat(FRotator(
-	//		ConstrMapItr.Value->GetCurrentSwing2(),
-	//		ConstrMapItr.Value->GetCurrentSwing1(),
-	//		ConstrMapItr.Value->GetCurrentTwist())));
-	//}
-	//for (const auto& ConstrMapItr : Index.FingerPartToConstraint)
-	//{
-	//	ConstrMapItr.Value->SetAngularOrientationTarget(FQuat(FRotator(
-	//		ConstrMapItr.Value->GetCurrentSwing2(),
-	//		ConstrMapItr.Value->GetCurrentSwing1(),
-	//		ConstrMapItr.Value->GetCurrentTwist())));
-	//}
-	//for (const auto& ConstrMapItr : Middle.FingerPartToConstraint)
-	//{
-	//	ConstrMapItr.Value->SetAngularOrientationTarget(FQuat(FRotator(
-	//		ConstrMapItr.Value->GetCurrentSwing2(),
-	//		ConstrMapItr.Value->GetCurrentSwing1(),
-	//		ConstrMapItr.Value->GetCurrentTwist())));
-	//}
-	//for (const auto& ConstrMapItr : Ring.FingerPartToConstraint)
-	//{
-	//	ConstrMapItr.Value->SetAngularOrientationTarget(FQuat(FRotator(
-	//		ConstrMapItr.Value->GetCurrentSwing2(),
-	//		ConstrMapItr.Value->GetCurrentSwing1(),
-	//		ConstrMapItr.Value->GetCurrentTwist())));
-	//}
-	//for (const auto& ConstrMapItr : Pinky.FingerPartToConstraint)
-	//{
-	//	ConstrMapItr.Value->SetAngularOrientationTarget(FQuat(FRotator(
-	//		ConstrMapItr.Value->GetCurrentSwing2(),
-	//		ConstrMapItr.Value->GetCurrentSwing1(),
-	//		ConstrMapItr.Value->GetCurrentTwist())));
-	//}
+	AMCHand::ReadJointOrientations<TopologyType>();
+	TopologyType::ForEachJoint([this](const int32 JointIdx)
+	{
+		if (BoundJointMask & (1u << JointIdx))
+		{
+			JointTable[JointIdx]->SetAngularOrientationTarget(JointOrientations[JointIdx]);
+		}
+	});
+	AppliedJointTargetMask = 0;
 
 	bGraspHeld = true;
 }
 
+// Map the finger segment bones to their joint index (used by the hit callback)
+void AMCHand::SetupBoneToJointIndex()
+{
+	BoneToJointIndex.Empty(MC_NUM_HAND_JOINTS);
+	for (int32 JointIdx = 0; JointIdx < MC_NUM_HAND_JOINTS; ++JointIdx)
+	{
+		if (FConstraintInstance* Constraint = JointTable[JointIdx])
+		{
+			// The first constraint bone is the child, i.e. the finger segment moved by the joint
+			BoneToJointIndex.Add(Constraint->ConstraintBone1, JointIdx);
+		}
+	}
+}
+
+// Read the current orientation of every joint in one pass
+template<typename TopologyType>
+void AMCHand::ReadJointOrientations()
+{
+	TopologyType::ForEachJoint([this](const int32 JointIdx)
+	{
+		if (BoundJointMask & (1u << JointIdx))
+		{
+			const FConstraintInstance* Constraint = JointTable[JointIdx];
+			JointOrientations[JointIdx] = FQuat(FRotator(
+				FMath::RadiansToDegrees(Constraint->GetCurrentSwing2()),
+				FMath::RadiansToDegrees(Constraint->GetCurrentSwing1()),
+				FMath::RadiansToDegrees(Constraint->GetCurrentTwist())));
+		}
+		else
+		{
+			JointOrientations[JointIdx] = FQuat::Identity;
+		}
+	});
+}
+
+// Freeze the targets of the joints (and their parent joints) at the current orientation
+template<typename TopologyType>
+void AMCHand::FreezeJoints(const uint32 InJointMask, const float Goal)
+{
+	// Closing a parent joint would push the touching segment further into the contact,
+	// the parent chain mask is selected by the joint bit (all or none of its bits)
+	uint32 FreezeMask = 0;
+	TopologyType::ForEachJoint([&FreezeMask, InJointMask](const int32 JointIdx)
+	{
+		FreezeMask |= TopologyType::GetParentChainMask(JointIdx) & (0u - ((InJointMask >> JointIdx) & 1u));
+	});
+	FreezeMask &= ~FrozenJointMask;
+
+	AMCHand::ReadJointOrientations<TopologyType>();
+	TopologyType::ForEachJoint([this, FreezeMask, Goal](const int32 JointIdx)
+	{
+		if (FreezeMask & (1u << JointIdx))
+		{
+			if (BoundJointMask & (1u << JointIdx))
+			{
+				JointTable[JointIdx]->SetAngularOrientationTarget(JointOrientations[JointIdx]);
+			}
+			FrozenJointGoals[JointIdx] = Goal;
+		}
+	});
+	FrozenJointMask |= FreezeMask;
+}
+
 // Setup hand default values
 void AMCHand::SetupHandDefaultValues(EHandType InHandType)
 {
@@ -634,24 +1455,195 @@ void AMCHand::SetupSkeletalDefaultValues(USkeletalMeshComponent* InSkeletalMeshC
 void AMCHand::SetupAngularDriveValues(EAngularDriveMode::Type DriveMode)
 {
 	USkeletalMeshComponent* const SkelMeshComp = GetSkeletalMeshComponent();
-	if (Thumb.SetFingerPartsConstraints(SkelMeshComp->Constraints))
+
+	// Copy the prebuilt constraint index table of the rig, avoids bone name matching at spawn
+	bool bJointTableCopied = false;
+	if (HandRig)
 	{
-		Thumb.SetFingerDriveMode(DriveMode, Spring, Damping, ForceLimit);
+		bJointTableCopied = HandRig->CopyJointTable(SkelMeshComp, JointTable);
+		if (bJointTableCopied)
+		{
+			AngularDriveMode = HandRig->AngularDriveMode;
+			Spring = HandRig->Spring;
+			Damping = HandRig->Damping;
+			ForceLimit = HandRig->ForceLimit;
+			DriveMode = AngularDriveMode;
+		}
+		else
+		{
+			UE_LOG(LogTemp, Warning, TEXT("AMCHand: %s hand rig cannot be used, falling back to the finger bone names.."), *GetName());
+		}
 	}
-	if (Index.SetFingerPartsConstraints(SkelMeshComp->Constraints))
+
+	// The finger constraints of a previous physics asset are no longer valid
+	FMCFinger* const Fingers[MC_NUM_FINGERS] = { &Thumb, &Index, &Middle, &Ring, &Pinky };
+	for (FMCFinger* Finger : Fingers)
 	{
-		Index.SetFingerDriveMode(DriveMode, Spring, Damping, ForceLimit);
+		Finger->FingerPartToConstraint.Empty();
 	}
-	if (Middle.SetFingerPartsConstraints(SkelMeshComp->Constraints))
+
+	MCDispatchHandTopology(HandTopology, [&](auto Topology)
 	{
-		Middle.SetFingerDriveMode(DriveMode, Spring, Damping, ForceLimit);
+		typedef decltype(Topology) TopologyType;
+		if (!bJointTableCopied)
+		{
+			// Flatten the constraints of the fingers of the topology into the hand joint table,
+			// fingers with missing constraints are neither driven nor tracked
+			JointTable.Init(nullptr, MC_NUM_HAND_JOINTS);
+			TMCUnroll<TopologyType::NumFingers>::Loop([&](const int32 FingerIdx)
+			{
+				if (Fingers[FingerIdx]->SetFingerPartsConstraints(SkelMeshComp->Constraints))
+				{
+					Fingers[FingerIdx]->AddToJointTable(JointTable);
+				}
+				else
+				{
+					UE_LOG(LogTemp, Warning, TEXT("AMCHand: %s finger %d has missing constraints, it is not driven.."), *GetName(), FingerIdx);
+				}
+			});
+		}
+		AMCHand::SetupJointDrives<TopologyType>(DriveMode);
+	});
+}
+
+// Set the drive mode of the joints and mark the joint table entries used by the topology
+template<typename TopologyType>
+void AMCHand::SetupJointDrives(const EAngularDriveMode::Type DriveMode)
+{
+	// Joints outside of the topology are neither driven nor tracked
+	for (int32 JointIdx = 0; JointIdx < JointTable.Num(); ++JointIdx)
+	{
+		if (!(TopologyType::GetJointMask() & (1u << JointIdx)))
+		{
+			JointTable[JointIdx] = nullptr;
+		}
 	}
-	if (Ring.SetFingerPartsConstraints(SkelMeshComp->Constraints))
+
+	BoundJointMask = 0;
+	AppliedJointTargetMask = 0;
+	TopologyType::ForEachJoint([this, DriveMode](const int32 JointIdx)
 	{
-		Ring.SetFingerDriveMode(DriveMode, Spring, Damping, ForceLimit);
+		if (FConstraintInstance* Constraint = JointTable[JointIdx])
+		{
+			FMCFinger::SetConstraintDriveMode(Constraint, DriveMode, Spring, Damping, ForceLimit);
+			BoundJointMask |= 1u << JointIdx;
+		}
+	});
+}
+
+// Apply the collision profile, the fixation grasp area channels, and disable the finger joint collisions
+void AMCHand::SetupCollision()
+{
+	// Project specific profile (Config/DefaultEngine.ini), otherwise the constructor defaults are kept
+	FCollisionResponseTemplate ProfileTemplate;
+	if (!HandCollisionProfileName.IsNone() &&
+		UCollisionProfile::Get()->GetProfileTemplate(HandCollisionProfileName, ProfileTemplate))
+	{
+		GetSkeletalMeshComponent()->SetCollisionProfileName(HandCollisionProfileName);
+	}
+
+	// The fixation grasp area is only used for overlap queries against graspable objects
+	FixationGraspArea->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+	FixationGraspArea->SetCollisionResponseToAllChannels(ECR_Ignore);
+	for (const ECollisionChannel Channel : GraspableChannels)
+	{
+		FixationGraspArea->SetCollisionResponseToChannel(Channel, ECR_Overlap);
 	}
-	if (Pinky.SetFingerPartsConstraints(SkelMeshComp->Constraints))
+
+	// Bodies connected by a finger joint (palm - proximal, proximal - intermediate, intermediate - distal) always touch
+	if (bDisableFingerJointCollision)
 	{
-		Pinky.SetFingerDriveMode(DriveMode, Spring, Damping, ForceLimit);
+		for (FConstraintInstance* Constraint : JointTable)
+		{
+			if (Constraint)
+			{
+				Constraint->SetDisableCollision(true);
+			}
+		}
 	}
 }
+
+// Lock the finger constraints in their current pose and disable their drives (held grasp)
+void AMCHand::WeldFingers()
+{
+	if (!bWeldFingersWhileGrasped || bFingersWelded)
+	{
+		return;
+	}
+
+	USkeletalMeshComponent* const SkelMeshComp = GetSkeletalMeshComponent();
+	WeldedJointMask = 0;
+	for (int32 JointIdx = 0; JointIdx < MC_NUM_HAND_JOINTS; ++JointIdx)
+	{
+		FConstraintInstance* Constraint = JointTable[JointIdx];
+		if (!Constraint)
+		{
+			continue;
+		}
+		FBodyInstance* ChildBody = SkelMeshComp->GetBodyInstance(Constraint->ConstraintBone1);
+		FBodyInstance* ParentBody = SkelMeshComp->GetBodyInstance(Constraint->ConstraintBone2);
+		if (!ChildBody || !ParentBody)
+		{
+			continue;
+		}
+
+		// Store the original frame and limits
+		FMCJointWeldState& WeldState = JointWeldStates[JointIdx];
+		WeldState.ParentFrame = Constraint->GetRefFrame(EConstraintFrame::Frame2);
+		WeldState.Swing1Motion = Constraint->GetAngularSwing1Motion();
+		WeldState.Swing1Limit = Constraint->GetAngularSwing1Limit();
+		WeldState.Swing2Motion = Constraint->GetAngularSwing2Motion();
+		WeldState.Swing2Limit = Constraint->GetAngularSwing2Limit();
+		WeldState.TwistMotion = Constraint->GetAngularTwistMotion();
+		WeldState.TwistLimit = Constraint->GetAngularTwistLimit();
+
+		// Move the parent frame onto the current child frame, the current pose becomes the locked pose (no pop)
+		const FTransform ChildFrameWorld = Constraint->GetRefFrame(EConstraintFrame::Frame1) * ChildBody->GetUnrealWorldTransform();
+		Constraint->SetRefFrame(EConstraintFrame::Frame2, ChildFrameWorld.GetRelativeTransform(ParentBody->GetUnrealWorldTransform()));
+		Constraint->SetAngularSwing1Limit(EAngularConstraintMotion::ACM_Locked, 0.f);
+		Constraint->SetAngularSwing2Limit(EAngularConstraintMotion::ACM_Locked, 0.f);
+		Constraint->SetAngularTwistLimit(EAngularConstraintMotion::ACM_Locked, 0.f);
+
+		// Nothing left to drive
+		Constraint->SetOrientationDriveSLERP(false);
+		Constraint->SetOrientationDriveTwistAndSwing(false, false);
+		WeldedJointMask |= 1u << JointIdx;
+	}
+	bFingersWelded = true;
+}
+
+// Restore the finger constraints articulation, the drives hold the current pose
+void AMCHand::UnweldFingers()
+{
+	if (!bFingersWelded)
+	{
+		return;
+	}
+
+	// Joints skipped by the weld (missing bodies) were never changed
+	for (int32 JointIdx = 0; JointIdx < MC_NUM_HAND_JOINTS; ++JointIdx)
+	{
+		FConstraintInstance* Constraint = JointTable[JointIdx];
+		if (!Constraint || !(WeldedJointMask & (1u << JointIdx)))
+		{
+			continue;
+		}
+		const FMCJointWeldState& WeldState = JointWeldStates[JointIdx];
+		Constraint->SetRefFrame(EConstraintFrame::Frame2, WeldState.ParentFrame);
+		Constraint->SetAngularSwing1Limit(WeldState.Swing1Motion, WeldState.Swing1Limit);
+		Constraint->SetAngularSwing2Limit(WeldState.Swing2Motion, WeldState.Swing2Limit);
+		Constraint->SetAngularTwistLimit(WeldState.TwistMotion, WeldState.TwistLimit);
+		FMCFinger::SetConstraintDriveMode(Constraint, AngularDriveMode, Spring, Damping, ForceLimit);
+	}
+	WeldedJointMask = 0;
+	bFingersWelded = false;
+
+	// The bodies did not move relative to each other, drive them to where they are
+	MCDispatchHandTopology(HandTopology, [this](auto Topology)
+	{
+		AMCHand::MaintainFingerPositions<decltype(Topology)>();
+	});
+	bGraspHeld = false;
+	FrozenJointMask = 0;
+	ActiveContacts.Empty();
+}
@@ -0,0 +1,364 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCHandNetState.h"
+#include "GameFramework/Actor.h"
+
+namespace
+{
+	// Largest absolute value of the three smallest components of a unit quaternion
+	const float MCSmallestThreeRange = 0.70710678f;
+
+	// Maximum value of a smallest three component
+	const uint32 MCSmallestThreeMax = (1u << 10) - 1;
+
+	// Maximum value of a quantized joint angle
+	const uint32 MCAngleMax = (1u << MC_HAND_NET_ANGLE_BITS) - 1;
+
+	// Quantize a location (cm) to mm
+	void QuantizeLocation(const FVector& InLocation, int32* OutLocation)
+	{
+		OutLocation[0] = FMath::RoundToInt(InLocation.X * 10.f);
+		OutLocation[1] = FMath::RoundToInt(InLocation.Y * 10.f);
+		OutLocation[2] = FMath::RoundToInt(InLocation.Z * 10.f);
+	}
+
+	// Dequantize a location (mm) to cm
+	FVector DequantizeLocation(const int32* InLocation)
+	{
+		return FVector(InLocation[0], InLocation[1], InLocation[2]) * 0.1f;
+	}
+
+	// Quantize a joint angle (radians)
+	uint16 QuantizeAngle(const float InAngle)
+	{
+		const float Normalized = (FMath::Clamp(InAngle, -PI, PI) + PI) / (2.f * PI);
+		return (uint16)FMath::RoundToInt(Normalized * MCAngleMax);
+	}
+
+	// Dequantize a joint angle (radians)
+	float DequantizeAngle(const uint16 InAngle)
+	{
+		return (float)InAngle / MCAngleMax * 2.f * PI - PI;
+	}
+
+	// Serialize a signed value as zigzag packed integer, small magnitudes take one byte
+	void SerializeSignedPacked(FArchive& Ar, int32& Value)
+	{
+		uint32 Packed = ((uint32)Value << 1) ^ (uint32)(Value >> 31);
+		Ar.SerializeIntPacked(Packed);
+		if (Ar.IsLoading())
+		{
+			Value = (int32)(Packed >> 1) ^ -(int32)(Packed & 1);
+		}
+	}
+}
+
+// Default constructor
+FMCHandNetState::FMCHandNetState()
+{
+	FMCHandNetState::Quantize(0.f, FTransform::Identity, 0.f, nullptr, 0, nullptr, FTransform::Identity);
+}
+
+// Quantize the hand state, the joint angles are optional
+void FMCHandNetState::Quantize(const float InTimestamp, const FTransform& Palm, const float InGrasp, const float* InJointAngles,
+	const uint8 InGraspState, AActor* InAttachedObject, const FTransform& InAttachedRelativePose)
+{
+	Timestamp = InTimestamp;
+	QuantizeLocation(Palm.GetLocation(), Location);
+	Rotation = FMCHandNetState::QuantizeRotation(Palm.GetRotation());
+	Grasp = (uint8)FMath::RoundToInt(FMath::Clamp(InGrasp, 0.f, 1.f) * 255.f);
+	Flags = InJointAngles ? MCHN_HasJointAngles : 0;
+	for (int32 AngleIdx = 0; AngleIdx < MC_NUM_HAND_JOINTS * 3; ++AngleIdx)
+	{
+		JointAngles[AngleIdx] = QuantizeAngle(InJointAngles ? InJointAngles[AngleIdx] : 0.f);
+	}
+
+	// The relative pose is only kept while an object is attached, it does not change during the grasp
+	GraspState = InGraspState;
+	AttachedObject = InAttachedObject;
+	QuantizeLocation(InAttachedObject ? InAttachedRelativePose.GetLocation() : FVector::ZeroVector, AttachedLocation);
+	AttachedRotation = FMCHandNetState::QuantizeRotation(InAttachedObject ? InAttachedRelativePose.GetRotation() : FQuat::Identity);
+}
+
+// Dequantize the hand state
+void FMCHandNetState::Dequantize(FMCHandNetPose& OutPose) const
+{
+	OutPose.Palm = FTransform(FMCHandNetState::DequantizeRotation(Rotation), DequantizeLocation(Location));
+	OutPose.Grasp = Grasp / 255.f;
+	OutPose.bHasJointAngles = (Flags & MCHN_HasJointAngles) != 0;
+	for (int32 AngleIdx = 0; AngleIdx < MC_NUM_HAND_JOINTS * 3; ++AngleIdx)
+	{
+		OutPose.JointAngles[AngleIdx] = DequantizeAngle(JointAngles[AngleIdx]);
+	}
+	OutPose.GraspState = GraspState;
+	OutPose.AttachedObject = AttachedObject.Get();
+	OutPose.AttachedRelativePose = FTransform(FMCHandNetState::DequantizeRotation(AttachedRotation), DequantizeLocation(AttachedLocation));
+}
+
+// Get the field groups that differ from the base state
+uint32 FMCHandNetState::GetChangedFields(const FMCHandNetState& Base) const
+{
+	uint32 Fields = 0;
+	if (FMemory::Memcmp(Location, Base.Location, sizeof(Location)) != 0)
+	{
+		Fields |= MCHN_Location;
+	}
+	if (Rotation != Base.Rotation)
+	{
+		Fields |= MCHN_Rotation;
+	}
+	if (Grasp != Base.Grasp || Flags != Base.Flags)
+	{
+		Fields |= MCHN_Grasp;
+	}
+	if (FMemory::Memcmp(JointAngles, Base.JointAngles, sizeof(JointAngles)) != 0)
+	{
+		Fields |= MCHN_JointAngles;
+	}
+	if (GraspState != Base.GraspState || AttachedObject != Base.AttachedObject ||
+		FMemory::Memcmp(AttachedLocation, Base.AttachedLocation, sizeof(AttachedLocation)) != 0 ||
+		AttachedRotation != Base.AttachedRotation)
+	{
+		Fields |= MCHN_Attachment;
+	}
+	return Fields;
+}
+
+// Get the changed joints (bit per joint)
+uint32 FMCHandNetState::GetChangedJoints(const FMCHandNetState& Base) const
+{
+	uint32 Joints = 0;
+	for (int32 JointIdx = 0; JointIdx < MC_NUM_HAND_JOINTS; ++JointIdx)
+	{
+		const int32 AngleIdx = JointIdx * 3;
+		if (JointAngles[AngleIdx] != Base.JointAngles[AngleIdx] ||
+			JointAngles[AngleIdx + 1] != Base.JointAngles[AngleIdx + 1] ||
+			JointAngles[AngleIdx + 2] != Base.JointAngles[AngleIdx + 2])
+		{
+			Joints |= 1u << JointIdx;
+		}
+	}
+	return Joints;
+}
+
+// Write the fields that differ from the base state, or read them (the other fields keep their values)
+void FMCHandNetState::SerializeFields(FArchive& Ar, UPackageMap* Map, const FMCHandNetState& Base)
+{
+	uint32 Fields = Ar.IsSaving() ? FMCHandNetState::GetChangedFields(Base) : 0;
+	Ar.SerializeInt(Fields, MCHN_AllFields + 1);
+	Ar << Timestamp;
+
+	if (Fields & MCHN_Location)
+	{
+		SerializeSignedPacked(Ar, Location[0]);
+		SerializeSignedPacked(Ar, Location[1]);
+		SerializeSignedPacked(Ar, Location[2]);
+	}
+	if (Fields & MCHN_Rotation)
+	{
+		Ar << Rotation;
+	}
+	if (Fields & MCHN_Grasp)
+	{
+		Ar << Grasp << Flags;
+	}
+	if (Fields & MCHN_JointAngles)
+	{
+		// Only the joints that moved
+		uint32 Joints = Ar.IsSaving() ? FMCHandNetState::GetChangedJoints(Base) : 0;
+		Ar.SerializeInt(Joints, 1u << MC_NUM_HAND_JOINTS);
+		for (int32 JointIdx = 0; JointIdx < MC_NUM_HAND_JOINTS; ++JointIdx)
+		{
+			if (Joints & (1u << JointIdx))
+			{
+				for (int32 AngleIdx = JointIdx * 3; AngleIdx < JointIdx * 3 + 3; ++AngleIdx)
+				{
+					uint32 Angle = JointAngles[AngleIdx];
+					Ar.SerializeInt(Angle, MCAngleMax + 1);
+					JointAngles[AngleIdx] = (uint16)Angle;
+				}
+			}
+		}
+	}
+	if (Fields & MCHN_Attachment)
+	{
+		Ar << GraspState;
+		UObject* Object = AttachedObject.Get();
+		if (Map)
+		{
+			Map->SerializeObject(Ar, AActor::StaticClass(), Object);
+		}
+		AttachedObject = Cast<AActor>(Object);
+		SerializeSignedPacked(Ar, AttachedLocation[0]);
+		SerializeSignedPacked(Ar, AttachedLocation[1]);
+		SerializeSignedPacked(Ar, AttachedLocation[2]);
+		Ar << AttachedRotation;
+	}
+}
+
+// Serialize the whole state (server RPC)
+bool FMCHandNetState::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	// Fields at their default values are left out
+	static const FMCHandNetState DefaultState;
+	FMCHandNetState::SerializeFields(Ar, Map, DefaultState);
+	bOutSuccess = !Ar.IsError();
+	return true;
+}
+
+// Quantize a rotation to its smallest three components
+uint32 FMCHandNetState::QuantizeRotation(const FQuat& InRotation)
+{
+	const FQuat Normalized = InRotation.GetNormalized();
+	const float Components[4] = { Normalized.X, Normalized.Y, Normalized.Z, Normalized.W };
+
+	// The largest component is left out, recomputed from the unit length (q and -q are the same rotation)
+	uint32 Largest = 0;
+	for (uint32 Idx = 1; Idx < 4; ++Idx)
+	{
+		if (FMath::Abs(Components[Idx]) > FMath::Abs(Components[Largest]))
+		{
+			Largest = Idx;
+		}
+	}
+	const float Sign = Components[Largest] < 0.f ? -1.f : 1.f;
+
+	uint32 Result = Largest;
+	for (uint32 Idx = 0; Idx < 4; ++Idx)
+	{
+		if (Idx != Largest)
+		{
+			const float Value = FMath::Clamp((Components[Idx] * Sign + MCSmallestThreeRange) / (2.f * MCSmallestThreeRange), 0.f, 1.f);
+			Result = (Result << 10) | (uint32)FMath::RoundToInt(Value * MCSmallestThreeMax);
+		}
+	}
+	return Result;
+}
+
+// Dequantize a smallest three rotation
+FQuat FMCHandNetState::DequantizeRotation(const uint32 InRotation)
+{
+	const uint32 Largest = InRotation >> 30;
+	float Components[4];
+	float SumSquared = 0.f;
+	int32 Shift = 20;
+	for (uint32 Idx = 0; Idx < 4; ++Idx)
+	{
+		if (Idx != Largest)
+		{
+			const float Value = (float)((InRotation >> Shift) & MCSmallestThreeMax) / MCSmallestThreeMax;
+			Components[Idx] = Value * 2.f * MCSmallestThreeRange - MCSmallestThreeRange;
+			SumSquared += Components[Idx] * Components[Idx];
+			Shift -= 10;
+		}
+	}
+	Components[Largest] = FMath::Sqrt(FMath::Max(0.f, 1.f - SumSquared));
+	return FQuat(Components[0], Components[1], Components[2], Components[3]);
+}
+
+// Write the fields changed since the base state of the connection, or read them
+bool FMCHandReplicatedState::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+	if (DeltaParms.Writer)
+	{
+		// Nothing to send if the connection already has the state, everything is sent the first time
+		static const FMCHandNetState DefaultState;
+		const FMCHandNetDeltaState* OldState = static_cast<FMCHandNetDeltaState*>(DeltaParms.OldState);
+		const FMCHandNetState& Base = OldState ? OldState->State : DefaultState;
+		if (OldState && State.GetChangedFields(Base) == 0)
+		{
+			return false;
+		}
+		*DeltaParms.NewState = MakeShareable(new FMCHandNetDeltaState(State));
+
+		FBitWriter& Writer = *DeltaParms.Writer;
+		const int64 StartBits = Writer.GetNumBits();
+		State.SerializeFields(Writer, DeltaParms.Map, Base);
+		NumBitsWritten += (uint32)(Writer.GetNumBits() - StartBits);
+		return true;
+	}
+
+	if (DeltaParms.Reader)
+	{
+		// The received fields are applied on the last received state
+		State.SerializeFields(*DeltaParms.Reader, DeltaParms.Map, State);
+		return !DeltaParms.Reader->IsError();
+	}
+	return true;
+}
+
+// Constructor
+FMCHandInterpolationBuffer::FMCHandInterpolationBuffer()
+{
+	FMCHandInterpolationBuffer::Reset();
+}
+
+// Remove all states
+void FMCHandInterpolationBuffer::Reset()
+{
+	Head = 0;
+	NumStates = 0;
+	RenderTime = 0.f;
+}
+
+// Add a received state, states older than the newest one are dropped
+void FMCHandInterpolationBuffer::Add(const FMCHandNetState& InState)
+{
+	if (NumStates > 0 && InState.Timestamp <= FMCHandInterpolationBuffer::GetState(0).Timestamp)
+	{
+		return;
+	}
+	Head = (Head + 1) % MC_HAND_NET_BUFFER_SIZE;
+	States[Head] = InState;
+	NumStates = FMath::Min(NumStates + 1, (int32)MC_HAND_NET_BUFFER_SIZE);
+}
+
+// Advance the render time and interpolate the pose at it
+bool FMCHandInterpolationBuffer::Sample(const float DeltaTime, const float Delay, FMCHandNetPose& OutPose)
+{
+	if (NumStates == 0)
+	{
+		return false;
+	}
+
+	// Hold the newest state when no new states arrive, catch up if the render time fell behind (start, stall, burst)
+	const float NewestTime = FMCHandInterpolationBuffer::GetState(0).Timestamp;
+	RenderTime = FMath::Min(RenderTime + DeltaTime, NewestTime);
+	if (NewestTime - Delay - RenderTime > Delay)
+	{
+		RenderTime = NewestTime - Delay;
+	}
+
+	// Newest state at or before the render time (the oldest state if all are newer)
+	int32 Age = 0;
+	while (Age + 1 < NumStates && FMCHandInterpolationBuffer::GetState(Age).Timestamp > RenderTime)
+	{
+		Age++;
+	}
+
+	const FMCHandNetState& Older = FMCHandInterpolationBuffer::GetState(Age);
+	Older.Dequantize(OutPose);
+	if (Age == 0 || Older.Timestamp >= RenderTime)
+	{
+		return true;
+	}
+
+	// The fixation grasp of the older state is kept until the newer state is reached
+	FMCHandNetPose NewerPose;
+	const FMCHandNetState& Newer = FMCHandInterpolationBuffer::GetState(Age - 1);
+	Newer.Dequantize(NewerPose);
+	const float Alpha = (RenderTime - Older.Timestamp) / (Newer.Timestamp - Older.Timestamp);
+	OutPose.Palm = FTransform(
+		FQuat::Slerp(OutPose.Palm.GetRotation(), NewerPose.Palm.GetRotation(), Alpha),
+		FMath::Lerp(OutPose.Palm.GetLocation(), NewerPose.Palm.GetLocation(), Alpha));
+	OutPose.Grasp = FMath::Lerp(OutPose.Grasp, NewerPose.Grasp, Alpha);
+	if (OutPose.bHasJointAngles && NewerPose.bHasJointAngles)
+	{
+		for (int32 AngleIdx = 0; AngleIdx < MC_NUM_HAND_JOINTS * 3; ++AngleIdx)
+		{
+			OutPose.JointAngles[AngleIdx] = FMath::Lerp(OutPose.JointAngles[AngleIdx], NewerPose.JointAngles[AngleIdx], Alpha);
+		}
+	}
+	return true;
+}
@@ -0,0 +1,295 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCHandRig.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "PhysicsEngine/PhysicsConstraintTemplate.h"
+#include "PhysicsEngine/SkeletalBodySetup.h"
+#if WITH_EDITOR
+#include "AssetRegistryModule.h"
+#include "Misc/PackageName.h"
+#endif // WITH_EDITOR
+
+// Sets default values
+UMCHandRig::UMCHandRig()
+{
+	PhysicsAsset = nullptr;
+	ReducedPhysicsAsset = nullptr;
+	JointNames.Init(NAME_None, MC_NUM_HAND_JOINTS);
+	ConstraintIndices.Init(INDEX_NONE, MC_NUM_HAND_JOINTS);
+	bResolved = false;
+
+	// Same defaults as the hand
+	AngularDriveMode = EAngularDriveMode::SLERP;
+	Spring = 9000.0f;
+	Damping = 1000.0f;
+	ForceLimit = 0.0f;
+
+	bDisableFingerSelfCollision = true;
+}
+
+// Write the self collision matrix into the physics asset
+void UMCHandRig::ApplySelfCollisionMatrix()
+{
+#if WITH_EDITOR
+	if (!UMCHandRig::ResolveConstraintIndices())
+	{
+		UE_LOG(LogTemp, Error, TEXT("UMCHandRig: %s constraints are not resolved, self collision matrix not applied!"), *GetName());
+		return;
+	}
+
+	PhysicsAsset->Modify();
+	int32 NumDisabledPairs = 0;
+	auto DisableCollision = [&](const FName& BodyA, const FName& BodyB)
+	{
+		const int32 BodyIndexA = PhysicsAsset->FindBodyIndex(BodyA);
+		const int32 BodyIndexB = PhysicsAsset->FindBodyIndex(BodyB);
+		if (BodyIndexA != INDEX_NONE && BodyIndexB != INDEX_NONE && BodyIndexA != BodyIndexB)
+		{
+			PhysicsAsset->DisableCollision(BodyIndexA, BodyIndexB);
+			NumDisabledPairs++;
+		}
+	};
+
+	if (bDisableFingerSelfCollision)
+	{
+		for (int32 FingerIdx = 0; FingerIdx < MC_NUM_FINGERS; ++FingerIdx)
+		{
+			// Child bodies of the finger joints (phalanges), the parent of the first joint is the palm
+			TArray<FName, TInlineAllocator<MC_NUM_FINGER_JOINTS>> Phalanges;
+			for (int32 PartIdx = 0; PartIdx < MC_NUM_FINGER_JOINTS; ++PartIdx)
+			{
+				const int32 ConstraintIdx = ConstraintIndices[FingerIdx * MC_NUM_FINGER_JOINTS + PartIdx];
+				if (PhysicsAsset->ConstraintSetup.IsValidIndex(ConstraintIdx))
+				{
+					const FConstraintInstance& Constraint = PhysicsAsset->ConstraintSetup[ConstraintIdx]->DefaultInstance;
+					DisableCollision(Constraint.ConstraintBone1, Constraint.ConstraintBone2);
+					Phalanges.AddUnique(Constraint.ConstraintBone1);
+				}
+			}
+
+			// Non adjacent phalanges of the same finger
+			for (int32 IdxA = 0; IdxA < Phalanges.Num(); ++IdxA)
+			{
+				for (int32 IdxB = IdxA + 2; IdxB < Phalanges.Num(); ++IdxB)
+				{
+					DisableCollision(Phalanges[IdxA], Phalanges[IdxB]);
+				}
+			}
+		}
+	}
+
+	for (const FMCBodyPair& Pair : DisabledCollisionPairs)
+	{
+		DisableCollision(Pair.BodyA, Pair.BodyB);
+	}
+
+	PhysicsAsset->MarkPackageDirty();
+	UE_LOG(LogTemp, Log, TEXT("UMCHandRig: %d body pairs of %s excluded from collision"), NumDisabledPairs, *PhysicsAsset->GetName());
+#endif // WITH_EDITOR
+}
+
+// Create a copy of the physics asset with a capsule per phalanx and a box per other body, logs the cost of both
+void UMCHandRig::GenerateReducedPhysicsAsset()
+{
+#if WITH_EDITOR
+	if (!UMCHandRig::ResolveConstraintIndices())
+	{
+		UE_LOG(LogTemp, Error, TEXT("UMCHandRig: %s constraints are not resolved, reduced physics asset not generated!"), *GetName());
+		return;
+	}
+
+	// Phalanges are the child bodies of the finger joints
+	TSet<FName> Phalanges;
+	for (const int32 ConstraintIdx : ConstraintIndices)
+	{
+		if (PhysicsAsset->ConstraintSetup.IsValidIndex(ConstraintIdx))
+		{
+			Phalanges.Add(PhysicsAsset->ConstraintSetup[ConstraintIdx]->DefaultInstance.ConstraintBone1);
+		}
+	}
+
+	// Copy next to the detailed asset, bodies and constraints keep their order (the rig indices stay valid)
+	const FString PackageName = FPackageName::GetLongPackagePath(PhysicsAsset->GetOutermost()->GetName()) +
+		TEXT("/") + PhysicsAsset->GetName() + TEXT("_Reduced");
+	UPackage* Package = CreatePackage(nullptr, *PackageName);
+	UPhysicsAsset* ReducedAsset = DuplicateObject<UPhysicsAsset>(PhysicsAsset, Package, *FPackageName::GetShortName(PackageName));
+	ReducedAsset->SetFlags(RF_Public | RF_Standalone);
+
+	for (USkeletalBodySetup* BodySetup : ReducedAsset->SkeletalBodySetups)
+	{
+		// Bounds of the detailed shapes in bone space
+		const FBox Bounds = BodySetup->AggGeom.CalcAABB(FTransform::Identity);
+		if (!Bounds.IsValid)
+		{
+			continue;
+		}
+		const FVector Center = Bounds.GetCenter();
+		const FVector Extent = Bounds.GetExtent();
+		BodySetup->AggGeom.EmptyElements();
+
+		if (Phalanges.Contains(BodySetup->BoneName))
+		{
+			// Capsule along the longest bounds axis
+			FKSphylElem Capsule;
+			Capsule.Center = Center;
+			const int32 LongAxis = Extent.X >= Extent.Y && Extent.X >= Extent.Z ? 0 : (Extent.Y >= Extent.Z ? 1 : 2);
+			if (LongAxis == 0)
+			{
+				Capsule.Rotation = FRotator(90.f, 0.f, 0.f);
+				Capsule.Radius = (Extent.Y + Extent.Z) * 0.5f;
+			}
+			else if (LongAxis == 1)
+			{
+				Capsule.Rotation = FRotator(0.f, 0.f, 90.f);
+				Capsule.Radius = (Extent.X + Extent.Z) * 0.5f;
+			}
+			else
+			{
+				Capsule.Rotation = FRotator::ZeroRotator;
+				Capsule.Radius = (Extent.X + Extent.Y) * 0.5f;
+			}
+			Capsule.Length = FMath::Max(2.f * (Extent[LongAxis] - Capsule.Radius), 0.f);
+			BodySetup->AggGeom.SphylElems.Add(Capsule);
+		}
+		else
+		{
+			// Palm (and any other body) as a box
+			FKBoxElem Box(2.f * Extent.X, 2.f * Extent.Y, 2.f * Extent.Z);
+			Box.Center = Center;
+			BodySetup->AggGeom.BoxElems.Add(Box);
+		}
+
+		BodySetup->InvalidatePhysicsData();
+		BodySetup->CreatePhysicsMeshes();
+	}
+
+	FAssetRegistryModule::AssetCreated(ReducedAsset);
+	ReducedAsset->MarkPackageDirty();
+
+	Modify();
+	ReducedPhysicsAsset = ReducedAsset;
+
+	UE_LOG(LogTemp, Log, TEXT("UMCHandRig: Reduced physics asset %s generated\n\tBefore: %s\n\tAfter:  %s"), *PackageName,
+		*UMCHandRig::GetCollisionCostReport(PhysicsAsset), *UMCHandRig::GetCollisionCostReport(ReducedAsset));
+#endif // WITH_EDITOR
+}
+
+// Copy the prebuilt constraint index table into the hand joint table
+bool UMCHandRig::CopyJointTable(USkeletalMeshComponent* SkelComp, TArray<FConstraintInstance*>& OutJointTable) const
+{
+	if (!bResolved)
+	{
+		UE_LOG(LogTemp, Error, TEXT("UMCHandRig: %s constraint indices are not resolved!"), *GetName());
+		return false;
+	}
+
+	// The reduced asset is a copy of the physics asset, the constraint indices are the same
+	const UPhysicsAsset* ComponentPhysicsAsset = SkelComp->GetPhysicsAsset();
+	if (!ComponentPhysicsAsset || (ComponentPhysicsAsset != PhysicsAsset && ComponentPhysicsAsset != ReducedPhysicsAsset))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UMCHandRig: %s does not match the physics asset of %s!"),
+			*GetName(), *SkelComp->GetOwner()->GetName());
+		return false;
+	}
+
+	// The component constraints are instantiated in the order of the physics asset constraint setup
+	OutJointTable.Init(nullptr, MC_NUM_HAND_JOINTS);
+	for (int32 JointIdx = 0; JointIdx < MC_NUM_HAND_JOINTS; ++JointIdx)
+	{
+		const int32 ConstraintIdx = ConstraintIndices[JointIdx];
+		if (SkelComp->Constraints.IsValidIndex(ConstraintIdx))
+		{
+			OutJointTable[JointIdx] = SkelComp->Constraints[ConstraintIdx];
+			checkSlow(OutJointTable[JointIdx]->JointName == JointNames[JointIdx]);
+		}
+	}
+	return true;
+}
+
+#if WITH_EDITOR
+// Resolve and validate the constraint indices against the physics asset
+bool UMCHandRig::ResolveConstraintIndices()
+{
+	ConstraintIndices.Init(INDEX_NONE, MC_NUM_HAND_JOINTS);
+	bResolved = false;
+
+	if (!PhysicsAsset)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("UMCHandRig: %s has no physics asset set!"), *GetName());
+		return false;
+	}
+
+	bool bAllJointsFound = true;
+	for (int32 JointIdx = 0; JointIdx < JointNames.Num() && JointIdx < MC_NUM_HAND_JOINTS; ++JointIdx)
+	{
+		// Rigs with less fingers or finger parts leave the joint name empty
+		if (JointNames[JointIdx].IsNone())
+		{
+			continue;
+		}
+
+		const int32 ConstraintIdx = PhysicsAsset->FindConstraintIndex(JointNames[JointIdx]);
+		if (ConstraintIdx == INDEX_NONE)
+		{
+			UE_LOG(LogTemp, Error, TEXT("UMCHandRig: %s joint %s has no constraint in %s!"),
+				*GetName(), *JointNames[JointIdx].ToString(), *PhysicsAsset->GetName());
+			bAllJointsFound = false;
+			continue;
+		}
+		ConstraintIndices[JointIdx] = ConstraintIdx;
+	}
+
+	bResolved = bAllJointsFound;
+	return bResolved;
+}
+
+// Resolve the indices when edited
+void UMCHandRig::PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	if (JointNames.Num() != MC_NUM_HAND_JOINTS)
+	{
+		JointNames.SetNum(MC_NUM_HAND_JOINTS);
+	}
+	UMCHandRig::ResolveConstraintIndices();
+}
+
+// Resolve the indices before saving / cooking
+void UMCHandRig::PreSave(const class ITargetPlatform* TargetPlatform)
+{
+	Super::PreSave(TargetPlatform);
+
+	UMCHandRig::ResolveConstraintIndices();
+}
+
+// Describe the collision cost of a physics asset (bodies, shapes, convex vertices, colliding body pairs)
+FString UMCHandRig::GetCollisionCostReport(const UPhysicsAsset* InPhysicsAsset)
+{
+	int32 NumSpheres = 0;
+	int32 NumBoxes = 0;
+	int32 NumCapsules = 0;
+	int32 NumConvexes = 0;
+	int32 NumConvexVertices = 0;
+	for (const USkeletalBodySetup* BodySetup : InPhysicsAsset->SkeletalBodySetups)
+	{
+		NumSpheres += BodySetup->AggGeom.SphereElems.Num();
+		NumBoxes += BodySetup->AggGeom.BoxElems.Num();
+		NumCapsules += BodySetup->AggGeom.SphylElems.Num();
+		NumConvexes += BodySetup->AggGeom.ConvexElems.Num();
+		for (const FKConvexElem& Convex : BodySetup->AggGeom.ConvexElems)
+		{
+			NumConvexVertices += Convex.VertexData.Num();
+		}
+	}
+
+	// Body pairs the narrow phase can test (the disable table holds the excluded pairs)
+	const int32 NumBodies = InPhysicsAsset->SkeletalBodySetups.Num();
+	const int32 NumCollidingPairs = NumBodies * (NumBodies - 1) / 2 - InPhysicsAsset->CollisionDisableTable.Num();
+
+	return FString::Printf(TEXT("%d bodies, %d constraints, %d colliding body pairs, shapes: %d spheres, %d boxes, %d capsules, %d convexes (%d vertices)"),
+		NumBodies, InPhysicsAsset->ConstraintSetup.Num(), NumCollidingPairs,
+		NumSpheres, NumBoxes, NumCapsules, NumConvexes, NumConvexVertices);
+}
+#endif // WITH_EDITOR
@@ -0,0 +1,131 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "PhysicsEngine/ConstraintDrives.h"
+#include "MCFinger.h"
+#include "MCHandTopology.generated.h"
+
+/** Enum indicating the finger topology of the hand rig */
+UENUM(BlueprintType)
+enum class EMCHandTopology : uint8
+{
+	FiveFingers		UMETA(DisplayName = "Five Fingers (5x3)"),
+	ThreeFingers	UMETA(DisplayName = "Three Fingers (3x3)"),
+	TwoFingers		UMETA(DisplayName = "Two Fingers (2x3)")
+};
+
+/**
+* Calls the function with the indices 0 .. Count - 1, unrolled at compile time
+*/
+template<int32 Count>
+struct TMCUnroll
+{
+	template<typename FuncType>
+	static FORCEINLINE void Loop(FuncType&& Func)
+	{
+		TMCUnroll<Count - 1>::Loop(Func);
+		Func(Count - 1);
+	}
+};
+
+/** End of the unrolled loop */
+template<>
+struct TMCUnroll<0>
+{
+	template<typename FuncType>
+	static FORCEINLINE void Loop(FuncType&& Func)
+	{}
+};
+
+/**
+* Compile time hand topology, the fingers are the first entries of EFingerType
+* and use the first parts of the hand joint table row (see FMCFinger::GetJointIndex)
+*/
+template<int32 InNumFingers, int32 InNumFingerJoints, EAngularDriveMode::Type InDriveMode>
+struct TMCHandTopology
+{
+	static_assert(InNumFingers > 0 && InNumFingers <= MC_NUM_FINGERS, "Unsupported number of fingers");
+	static_assert(InNumFingerJoints > 0 && InNumFingerJoints <= MC_NUM_FINGER_JOINTS, "Unsupported number of finger joints");
+	static_assert(MC_NUM_HAND_JOINTS <= 32, "Joint masks are 32 bit");
+
+	// Number of fingers
+	static constexpr int32 NumFingers = InNumFingers;
+
+	// Driven parts per finger
+	static constexpr int32 NumFingerJoints = InNumFingerJoints;
+
+	// Number of driven joints
+	static constexpr int32 NumJoints = InNumFingers * InNumFingerJoints;
+
+	// Default drive mode of the finger joints
+	static constexpr EAngularDriveMode::Type DriveMode = InDriveMode;
+
+	// Bit mask of the joint table entries used by the topology
+	static constexpr uint32 GetJointMask(const int32 FingerIdx = 0)
+	{
+		return FingerIdx < NumFingers
+			? (((1u << NumFingerJoints) - 1) << (FingerIdx * MC_NUM_FINGER_JOINTS)) | GetJointMask(FingerIdx + 1)
+			: 0u;
+	}
+
+	// Bit mask of the joint and of its parent joints in the same finger
+	static constexpr uint32 GetParentChainMask(const int32 JointIdx)
+	{
+		return ((2u << JointIdx) - 1) & ~((1u << ((JointIdx / MC_NUM_FINGER_JOINTS) * MC_NUM_FINGER_JOINTS)) - 1);
+	}
+
+	// Call the function with the joint table index of every joint, unrolled at compile time
+	template<typename FuncType>
+	static FORCEINLINE void ForEachJoint(FuncType&& Func)
+	{
+		TMCUnroll<NumFingers>::Loop([&Func](const int32 FingerIdx)
+		{
+			TMCUnroll<NumFingerJoints>::Loop([&Func, FingerIdx](const int32 PartIdx)
+			{
+				Func(FingerIdx * MC_NUM_FINGER_JOINTS + PartIdx);
+			});
+		});
+	}
+};
+
+/** Human hand rig */
+typedef TMCHandTopology<5, 3, EAngularDriveMode::SLERP> FMCFiveFingerTopology;
+
+/** Three finger (thumb, index, middle) rig */
+typedef TMCHandTopology<3, 3, EAngularDriveMode::SLERP> FMCThreeFingerTopology;
+
+/** Two finger (thumb, index) pinch rig */
+typedef TMCHandTopology<2, 3, EAngularDriveMode::TwistAndSwing> FMCTwoFingerTopology;
+
+/**
+* Call the function with an instance of the topology type, one switch per call instead of per joint
+*/
+template<typename FuncType>
+FORCEINLINE void MCDispatchHandTopology(const EMCHandTopology Topology, FuncType&& Func)
+{
+	switch (Topology)
+	{
+	case EMCHandTopology::ThreeFingers:
+		Func(FMCThreeFingerTopology());
+		break;
+	case EMCHandTopology::TwoFingers:
+		Func(FMCTwoFingerTopology());
+		break;
+	default:
+		Func(FMCFiveFingerTopology());
+		break;
+	}
+}
+
+/**
+* Get the default drive mode of the topology
+*/
+FORCEINLINE EAngularDriveMode::Type MCGetHandTopologyDriveMode(const EMCHandTopology Topology)
+{
+	EAngularDriveMode::Type DriveMode = EAngularDriveMode::SLERP;
+	MCDispatchHandTopology(Topology, [&DriveMode](auto InTopology) { DriveMode = decltype(InTopology)::DriveMode; });
+	return DriveMode;
+}
@@ -0,0 +1,54 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCInputFrame.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryWriter.h"
+#include "Serialization/MemoryReader.h"
+
+// Input recording file header
+static const uint32 MCInputRecordingMagic = 0x4D43494E; // "MCIN"
+static const uint32 MCInputRecordingVersion = 1;
+
+// Write the recording to a binary file
+bool FMCInputRecording::SaveToFile(const FString& Filename) const
+{
+	TArray<uint8> Bytes;
+	FMemoryWriter Writer(Bytes);
+	uint32 Magic = MCInputRecordingMagic;
+	uint32 Version = MCInputRecordingVersion;
+	float DeltaTime = StepDeltaTime;
+	Writer << Magic << Version << DeltaTime;
+	Writer << const_cast<TArray<FMCInputFrame>&>(Frames);
+
+	if (!FFileHelper::SaveArrayToFile(Bytes, *Filename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMCInputRecording: Could not write %s!"), *Filename);
+		return false;
+	}
+	return true;
+}
+
+// Read the recording from a binary file
+bool FMCInputRecording::LoadFromFile(const FString& Filename)
+{
+	TArray<uint8> Bytes;
+	if (!FFileHelper::LoadFileToArray(Bytes, *Filename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMCInputRecording: Could not read %s!"), *Filename);
+		return false;
+	}
+
+	FMemoryReader Reader(Bytes);
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	Reader << Magic << Version;
+	if (Magic != MCInputRecordingMagic || Version != MCInputRecordingVersion)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMCInputRecording: %s is not a supported input recording!"), *Filename);
+		return false;
+	}
+	Reader << StepDeltaTime;
+	Reader << Frames;
+	return !Reader.IsError();
+}
@@ -0,0 +1,133 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCKinematicHistory.h"
+
+// Constructor
+FMCKinematicHistory::FMCKinematicHistory()
+{
+	FMCKinematicHistory::Reset();
+}
+
+// Remove all samples
+void FMCKinematicHistory::Reset()
+{
+	Head = MC_KINEMATIC_HISTORY_SIZE - 1;
+	NumSamples = 0;
+}
+
+// Add a sample, overwrites the oldest one when full
+void FMCKinematicHistory::Add(const float Time, const FTransform& PalmPose, const FTransform& TargetPose)
+{
+	// Several updates at the same time would give infinite velocities
+	if (NumSamples > 0 && Time <= Samples[Head].Time)
+	{
+		return;
+	}
+
+	Head = (Head + 1) % MC_KINEMATIC_HISTORY_SIZE;
+	FMCKinematicSample& Sample = Samples[Head];
+	Sample.Time = Time;
+	Sample.PalmLocation = PalmPose.GetLocation();
+	Sample.PalmRotation = PalmPose.GetRotation();
+	Sample.TargetLocation = TargetPose.GetLocation();
+	Sample.TargetRotation = TargetPose.GetRotation();
+	NumSamples = FMath::Min(NumSamples + 1, (int32)MC_KINEMATIC_HISTORY_SIZE);
+}
+
+// Extrapolate the palm pose with the estimated velocities
+FTransform FMCKinematicHistory::PredictPalmPose(const float DeltaTime, const int32 InNumSamples) const
+{
+	if (NumSamples == 0)
+	{
+		return FTransform::Identity;
+	}
+
+	const FMCKinematicSample& Newest = FMCKinematicHistory::GetSample(0);
+	const FVector AngularVelocity = FMCKinematicHistory::GetPalmAngularVelocity(InNumSamples);
+	const float Angle = AngularVelocity.Size() * DeltaTime;
+	const FQuat DeltaRotation = Angle > KINDA_SMALL_NUMBER ?
+		FQuat(AngularVelocity.GetUnsafeNormal(), Angle) : FQuat::Identity;
+
+	return FTransform(DeltaRotation * Newest.PalmRotation,
+		Newest.PalmLocation + FMCKinematicHistory::GetPalmLinearVelocity(InNumSamples) * DeltaTime);
+}
+
+// Target linear acceleration (cm/s^2), change between the velocities of two consecutive sample windows
+FVector FMCKinematicHistory::GetTargetLinearAcceleration(const int32 InNumSamples) const
+{
+	if (InNumSamples < 2 || NumSamples < 2 * InNumSamples)
+	{
+		return FVector::ZeroVector;
+	}
+
+	const FVector NewVelocity = FMCKinematicHistory::FitLinearVelocity(&FMCKinematicSample::TargetLocation, InNumSamples);
+	const FVector OldVelocity = FMCKinematicHistory::FitLinearVelocity(&FMCKinematicSample::TargetLocation, InNumSamples, InNumSamples);
+
+	// Time between the window centers
+	const float TimeSpan = 0.5f * (FMCKinematicHistory::GetSample(0).Time + FMCKinematicHistory::GetSample(InNumSamples - 1).Time) -
+		0.5f * (FMCKinematicHistory::GetSample(InNumSamples).Time + FMCKinematicHistory::GetSample(2 * InNumSamples - 1).Time);
+	return TimeSpan > SMALL_NUMBER ? (NewVelocity - OldVelocity) / TimeSpan : FVector::ZeroVector;
+}
+
+// Least squares slope of a location over the newest samples (starting at the given age)
+FVector FMCKinematicHistory::FitLinearVelocity(FVector FMCKinematicSample::*Location, const int32 InNumSamples, const int32 FirstAge) const
+{
+	const int32 Count = FMath::Min(InNumSamples, NumSamples - FirstAge);
+	if (Count < 2)
+	{
+		return FVector::ZeroVector;
+	}
+
+	// Times relative to the newest sample of the window keep the float precision
+	const float NewestTime = FMCKinematicHistory::GetSample(FirstAge).Time;
+	float MeanTime = 0.f;
+	FVector MeanLocation = FVector::ZeroVector;
+	for (int32 Age = FirstAge; Age < FirstAge + Count; ++Age)
+	{
+		const FMCKinematicSample& Sample = FMCKinematicHistory::GetSample(Age);
+		MeanTime += Sample.Time - NewestTime;
+		MeanLocation += Sample.*Location;
+	}
+	MeanTime /= Count;
+	MeanLocation /= Count;
+
+	float TimeVariance = 0.f;
+	FVector Covariance = FVector::ZeroVector;
+	for (int32 Age = FirstAge; Age < FirstAge + Count; ++Age)
+	{
+		const FMCKinematicSample& Sample = FMCKinematicHistory::GetSample(Age);
+		const float TimeOffset = Sample.Time - NewestTime - MeanTime;
+		TimeVariance += TimeOffset * TimeOffset;
+		Covariance += (Sample.*Location - MeanLocation) * TimeOffset;
+	}
+	return TimeVariance > SMALL_NUMBER ? Covariance / TimeVariance : FVector::ZeroVector;
+}
+
+// Summed rotation between the newest samples divided by their time span
+FVector FMCKinematicHistory::MeanAngularVelocity(FQuat FMCKinematicSample::*Rotation, const int32 InNumSamples) const
+{
+	const int32 Count = FMath::Min(InNumSamples, NumSamples);
+	if (Count < 2)
+	{
+		return FVector::ZeroVector;
+	}
+
+	// Rotations between consecutive samples are small, the shortest path is always taken
+	FVector RotationSum = FVector::ZeroVector;
+	for (int32 Age = 0; Age < Count - 1; ++Age)
+	{
+		FQuat Delta = FMCKinematicHistory::GetSample(Age).*Rotation * (FMCKinematicHistory::GetSample(Age + 1).*Rotation).Inverse();
+		if (Delta.W < 0.f)
+		{
+			Delta *= -1.f;
+		}
+		FVector Axis;
+		float Angle;
+		Delta.ToAxisAndAngle(Axis, Angle);
+		RotationSum += Axis * Angle;
+	}
+
+	const float TimeSpan = FMCKinematicHistory::GetSample(0).Time - FMCKinematicHistory::GetSample(Count - 1).Time;
+	return TimeSpan > SMALL_NUMBER ? RotationSum / TimeSpan : FVector::ZeroVector;
+}
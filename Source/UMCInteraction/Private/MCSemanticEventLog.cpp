@@ -0,0 +1,179 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCSemanticEventLog.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Serialization/MemoryReader.h"
+
+// Constructor
+FMCSemanticEventLog::FMCSemanticEventLog()
+{
+	FileWriter = nullptr;
+	NumRecords = 0;
+	NumEvents = 0;
+}
+
+// Destructor, closes the file
+FMCSemanticEventLog::~FMCSemanticEventLog()
+{
+	FMCSemanticEventLog::Close();
+}
+
+// Create the log file
+bool FMCSemanticEventLog::Open(const FString& Filename)
+{
+	FMCSemanticEventLog::Close();
+
+	FileWriter = IFileManager::Get().CreateFileWriter(*Filename);
+	if (!FileWriter)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMCSemanticEventLog: Could not create %s !"), *Filename);
+		return false;
+	}
+
+	NameIds.Empty();
+	Names.Empty();
+	NumRecords = 0;
+	NumEvents = 0;
+
+	uint32 Magic = MC_SEMANTIC_LOG_MAGIC;
+	uint32 Version = MC_SEMANTIC_LOG_VERSION;
+	uint32 RecordSize = sizeof(FMCSemanticEventRecord);
+	*FileWriter << Magic << Version << RecordSize;
+	return true;
+}
+
+// Write the name table and close the file
+void FMCSemanticEventLog::Close()
+{
+	if (!FileWriter)
+	{
+		return;
+	}
+
+	uint64 NameTableOffset = FileWriter->Tell();
+	*FileWriter << Names;
+	uint32 Magic = MC_SEMANTIC_LOG_MAGIC;
+	*FileWriter << NameTableOffset << NumRecords << Magic;
+	FileWriter->Close();
+	delete FileWriter;
+	FileWriter = nullptr;
+}
+
+// Get the index of an individual name, added to the name table on first use
+uint32 FMCSemanticEventLog::GetNameId(const FString& Name)
+{
+	if (const uint32* NameId = NameIds.Find(Name))
+	{
+		return *NameId;
+	}
+	const uint32 NameId = Names.Add(Name);
+	NameIds.Add(Name, NameId);
+	return NameId;
+}
+
+// Write a grasp start record, returns it (with a new event id) for finishing the event
+FMCSemanticEventRecord FMCSemanticEventLog::StartGraspEvent(
+	const double Timestamp, const uint32 HandId, const uint32 ObjectId, const uint8 NumHands)
+{
+	FMCSemanticEventRecord Record;
+	FMemory::Memzero(Record);
+	Record.Timestamp = Timestamp;
+	Record.EventId = NumEvents++;
+	Record.HandId = HandId;
+	Record.ObjectId = ObjectId;
+	Record.EventType = MCSE_GraspStart;
+	Record.NumHands = NumHands;
+
+	if (FileWriter)
+	{
+		FileWriter->Serialize(&Record, sizeof(Record));
+		NumRecords++;
+	}
+	return Record;
+}
+
+// Write the finish record of a started grasp event
+void FMCSemanticEventLog::FinishGraspEvent(const FMCSemanticEventRecord& StartRecord, const double Timestamp)
+{
+	if (FileWriter)
+	{
+		FMCSemanticEventRecord Record = StartRecord;
+		Record.Timestamp = Timestamp;
+		Record.EventType = MCSE_GraspFinish;
+		FileWriter->Serialize(&Record, sizeof(Record));
+		NumRecords++;
+	}
+}
+
+// Read the records and the name table of a log file
+bool FMCSemanticEventLog::ReadFromFile(const FString& Filename, TArray<FMCSemanticEventRecord>& OutRecords, TArray<FString>& OutNames)
+{
+	TArray<uint8> Data;
+	if (!FFileHelper::LoadFileToArray(Data, *Filename))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMCSemanticEventLog: Could not read %s !"), *Filename);
+		return false;
+	}
+
+	// Header and footer sizes
+	const int64 HeaderSize = 3 * sizeof(uint32);
+	const int64 FooterSize = sizeof(uint64) + 2 * sizeof(uint32);
+	const uint32* Header = reinterpret_cast<const uint32*>(Data.GetData());
+	if (Data.Num() < HeaderSize + FooterSize || Header[0] != MC_SEMANTIC_LOG_MAGIC ||
+		Header[1] != MC_SEMANTIC_LOG_VERSION || Header[2] != sizeof(FMCSemanticEventRecord))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMCSemanticEventLog: %s is not a semantic event log (or has not been closed) !"), *Filename);
+		return false;
+	}
+
+	uint64 NameTableOffset;
+	uint32 NumRecords;
+	uint32 Magic;
+	FMemory::Memcpy(&NameTableOffset, &Data[Data.Num() - FooterSize], sizeof(uint64));
+	FMemory::Memcpy(&NumRecords, &Data[Data.Num() - FooterSize + sizeof(uint64)], sizeof(uint32));
+	FMemory::Memcpy(&Magic, &Data[Data.Num() - sizeof(uint32)], sizeof(uint32));
+	if (Magic != MC_SEMANTIC_LOG_MAGIC ||
+		NameTableOffset != HeaderSize + (uint64)NumRecords * sizeof(FMCSemanticEventRecord))
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMCSemanticEventLog: %s has an invalid footer !"), *Filename);
+		return false;
+	}
+
+	OutRecords.SetNumUninitialized(NumRecords);
+	FMemory::Memcpy(OutRecords.GetData(), &Data[HeaderSize], NumRecords * sizeof(FMCSemanticEventRecord));
+
+	TArray<uint8> NameTable(&Data[NameTableOffset], Data.Num() - FooterSize - NameTableOffset);
+	FMemoryReader NameReader(NameTable);
+	NameReader << OutNames;
+	return !NameReader.IsError();
+}
+
+// Write the records and the name table as a log file (e.g. logs merged offline)
+bool FMCSemanticEventLog::WriteToFile(const FString& Filename, const TArray<FMCSemanticEventRecord>& Records, const TArray<FString>& Names)
+{
+	FArchive* Writer = IFileManager::Get().CreateFileWriter(*Filename);
+	if (!Writer)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMCSemanticEventLog: Could not create %s !"), *Filename);
+		return false;
+	}
+
+	// Same layout as a log written at runtime
+	uint32 Magic = MC_SEMANTIC_LOG_MAGIC;
+	uint32 Version = MC_SEMANTIC_LOG_VERSION;
+	uint32 RecordSize = sizeof(FMCSemanticEventRecord);
+	*Writer << Magic << Version << RecordSize;
+	Writer->Serialize(const_cast<FMCSemanticEventRecord*>(Records.GetData()), Records.Num() * sizeof(FMCSemanticEventRecord));
+
+	uint64 NameTableOffset = Writer->Tell();
+	TArray<FString> NameTable = Names;
+	uint32 NumRecords = Records.Num();
+	*Writer << NameTable;
+	*Writer << NameTableOffset << NumRecords << Magic;
+	const bool bSuccess = !Writer->IsError();
+	Writer->Close();
+	delete Writer;
+	return bSuccess;
+}
@@ -0,0 +1,148 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCSemanticLogConverterCommandlet.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "SLUtils.h"
+
+// Sets default values
+UMCSemanticLogConverterCommandlet::UMCSemanticLogConverterCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+// Run the converter
+int32 UMCSemanticLogConverterCommandlet::Main(const FString& Params)
+{
+	FString LogFile;
+	if (!FParse::Value(*Params, TEXT("Log="), LogFile))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UMCSemanticLogConverterCommandlet: No log file (-Log=<SemanticEvents.bin>)!"));
+		return 1;
+	}
+
+	FString OwlFile;
+	if (!FParse::Value(*Params, TEXT("Owl="), OwlFile))
+	{
+		OwlFile = FPaths::ChangeExtension(LogFile, TEXT("owl"));
+	}
+
+	TArray<FMCSemanticEventRecord> Records;
+	TArray<FString> Names;
+	if (!FMCSemanticEventLog::ReadFromFile(LogFile, Records, Names))
+	{
+		return 1;
+	}
+
+	if (!FFileHelper::SaveStringToFile(UMCSemanticLogConverterCommandlet::ConvertToOwl(Records, Names), *OwlFile))
+	{
+		UE_LOG(LogTemp, Error, TEXT("UMCSemanticLogConverterCommandlet: Could not write %s!"), *OwlFile);
+		return 1;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("UMCSemanticLogConverterCommandlet: %d records converted to %s"), Records.Num(), *OwlFile);
+	return 0;
+}
+
+// Convert the records to an OWL document
+FString UMCSemanticLogConverterCommandlet::ConvertToOwl(const TArray<FMCSemanticEventRecord>& Records, const TArray<FString>& Names)
+{
+	// Example of a grasp event represented in OWL (see AMCHand::StartGraspEvent):
+	/********************************************************************
+	<owl:NamedIndividual rdf:about="&log;GraspingSomething_S1dz">
+		<rdf:type rdf:resource="&knowrob;GraspingSomething"/>
+		<knowrob:taskContext rdf:datatype="&xsd;string">Grasp-Bowl3_9w2Y-LeftHand_BRmZ</knowrob:taskContext>
+		<knowrob:startTime rdf:resource="&log;timepoint_22.053652"/>
+		<knowrob:objectActedOn rdf:resource="&log;Bowl3_9w2Y"/>
+		<knowrob:performedBy rdf:resource="&log;LeftHand_BRmZ"/>
+		<knowrob:endTime rdf:resource="&log;timepoint_32.28545"/>
+	</owl:NamedIndividual>
+	*********************************************************************/
+
+	// Start and finish times of the events, events still running at the end of the log finish with the last record
+	TMap<uint32, const FMCSemanticEventRecord*> StartRecords;
+	TMap<uint32, double> FinishTimes;
+	TArray<uint32> EventOrder;
+	double LastTimestamp = 0.0;
+	for (const FMCSemanticEventRecord& Record : Records)
+	{
+		if (!Names.IsValidIndex(Record.HandId) || !Names.IsValidIndex(Record.ObjectId))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("UMCSemanticLogConverterCommandlet: Record of event %d has invalid names, skipping.."),
+				Record.EventId);
+			continue;
+		}
+
+		if (Record.EventType == MCSE_GraspStart)
+		{
+			StartRecords.Add(Record.EventId, &Record);
+			EventOrder.Add(Record.EventId);
+		}
+		else if (Record.EventType == MCSE_GraspFinish)
+		{
+			FinishTimes.Add(Record.EventId, Record.Timestamp);
+		}
+		LastTimestamp = FMath::Max(LastTimestamp, Record.Timestamp);
+	}
+
+	FString Owl = TEXT(
+		"<?xml version=\"1.0\" encoding=\"utf-8\"?>\n"
+		"<!DOCTYPE rdf:RDF [\n"
+		"\t<!ENTITY rdf \"http://www.w3.org/1999/02/22-rdf-syntax-ns#\">\n"
+		"\t<!ENTITY rdfs \"http://www.w3.org/2000/01/rdf-schema#\">\n"
+		"\t<!ENTITY owl \"http://www.w3.org/2002/07/owl#\">\n"
+		"\t<!ENTITY xsd \"http://www.w3.org/2001/XMLSchema#\">\n"
+		"\t<!ENTITY knowrob \"http://knowrob.org/kb/knowrob.owl#\">\n"
+		"\t<!ENTITY log \"http://knowrob.org/kb/unreal_log.owl#\">\n"
+		"]>\n"
+		"<rdf:RDF xmlns:rdf=\"http://www.w3.org/1999/02/22-rdf-syntax-ns#\"\n"
+		"\txmlns:rdfs=\"http://www.w3.org/2000/01/rdf-schema#\"\n"
+		"\txmlns:owl=\"http://www.w3.org/2002/07/owl#\"\n"
+		"\txmlns:xsd=\"http://www.w3.org/2001/XMLSchema#\"\n"
+		"\txmlns:knowrob=\"http://knowrob.org/kb/knowrob.owl#\"\n"
+		"\txmlns=\"http://knowrob.org/kb/unreal_log.owl#\"\n"
+		"\txml:base=\"http://knowrob.org/kb/unreal_log.owl#\">\n"
+		"\t<owl:Ontology rdf:about=\"http://knowrob.org/kb/unreal_log.owl#\">\n"
+		"\t\t<owl:imports rdf:resource=\"package://knowrob_common/owl/knowrob.owl\"/>\n"
+		"\t</owl:Ontology>\n");
+
+	TSet<FString> Timepoints;
+	for (const uint32 EventId : EventOrder)
+	{
+		const FMCSemanticEventRecord* StartRecord = StartRecords[EventId];
+		const double* FinishTime = FinishTimes.Find(EventId);
+		const FString& Hand = Names[StartRecord->HandId];
+		const FString& Object = Names[StartRecord->ObjectId];
+		const FString StartTimepoint = TEXT("timepoint_") + FString::SanitizeFloat(StartRecord->Timestamp);
+		const FString EndTimepoint = TEXT("timepoint_") + FString::SanitizeFloat(FinishTime ? *FinishTime : LastTimestamp);
+		Timepoints.Add(StartTimepoint);
+		Timepoints.Add(EndTimepoint);
+
+		Owl += FString::Printf(TEXT(
+			"\t<owl:NamedIndividual rdf:about=\"&log;GraspingSomething_%s\">\n"
+			"\t\t<rdf:type rdf:resource=\"&knowrob;GraspingSomething\"/>\n"
+			"\t\t<knowrob:taskContext rdf:datatype=\"&xsd;string\">Grasp-%s-%s</knowrob:taskContext>\n"
+			"\t\t<knowrob:startTime rdf:resource=\"&log;%s\"/>\n"
+			"\t\t<knowrob:objectActedOn rdf:resource=\"&log;%s\"/>\n"
+			"\t\t<knowrob:performedBy rdf:resource=\"&log;%s\"/>\n"
+			"\t\t<knowrob:endTime rdf:resource=\"&log;%s\"/>\n"
+			"\t</owl:NamedIndividual>\n"),
+			*FSLUtils::GenerateRandomFString(4), *Object, *Hand, *StartTimepoint, *Object, *Hand, *EndTimepoint);
+	}
+
+	// Timepoint individuals
+	for (const FString& Timepoint : Timepoints)
+	{
+		Owl += FString::Printf(TEXT(
+			"\t<owl:NamedIndividual rdf:about=\"&log;%s\">\n"
+			"\t\t<rdf:type rdf:resource=\"&knowrob;TimePoint\"/>\n"
+			"\t</owl:NamedIndividual>\n"), *Timepoint);
+	}
+
+	Owl += TEXT("</rdf:RDF>\n");
+	return Owl;
+}
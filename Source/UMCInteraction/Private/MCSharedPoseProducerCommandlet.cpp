@@ -0,0 +1,88 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCSharedPoseProducerCommandlet.h"
+#include "HAL/PlatformProcess.h"
+
+// Sets default values
+UMCSharedPoseProducerCommandlet::UMCSharedPoseProducerCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+// Run the producer
+int32 UMCSharedPoseProducerCommandlet::Main(const FString& Params)
+{
+	FString Name = TEXT("MCTrackerPoses");
+	FParse::Value(*Params, TEXT("Name="), Name);
+	float Hz = 90.f;
+	FParse::Value(*Params, TEXT("Hz="), Hz);
+	float Duration = 0.f;
+	FParse::Value(*Params, TEXT("Duration="), Duration);
+	if (Hz <= 0.f)
+	{
+		UE_LOG(LogTemp, Error, TEXT("UMCSharedPoseProducerCommandlet: Invalid rate %f Hz!"), Hz);
+		return 1;
+	}
+
+	FMCSharedPoseRing Ring;
+	if (!Ring.CreateForWriting(Name))
+	{
+		return 1;
+	}
+	UE_LOG(LogTemp, Log, TEXT("UMCSharedPoseProducerCommandlet: Publishing to %s at %.1f Hz%s"),
+		*Name, Hz, Duration > 0.f ? *FString::Printf(TEXT(" for %.1f s"), Duration) : TEXT(" (until stopped)"));
+
+	// Fixed rate, the next sample time does not drift with the sleep accuracy
+	const double Period = 1.0 / Hz;
+	const double StartTime = FPlatformTime::Seconds();
+	double NextTime = StartTime;
+	while (Duration <= 0.f || NextTime - StartTime < Duration)
+	{
+		const double SleepTime = NextTime - FPlatformTime::Seconds();
+		if (SleepTime > 0.0)
+		{
+			FPlatformProcess::Sleep((float)SleepTime);
+		}
+		Ring.Write(UMCSharedPoseProducerCommandlet::GetSample(NextTime - StartTime));
+		NextTime += Period;
+	}
+
+	UE_LOG(LogTemp, Log, TEXT("UMCSharedPoseProducerCommandlet: %llu samples published"), Ring.GetWriteIndex());
+	return 0;
+}
+
+// Get the synthetic sample at the given time
+FMCSharedPoseSample UMCSharedPoseProducerCommandlet::GetSample(const double Time)
+{
+	FMCSharedPoseSample Sample;
+	FMemory::Memzero(Sample);
+	Sample.Timestamp = Time;
+
+	// Hands in front of the origin (same rest poses as without VR), moving on opposite circles
+	const float Angle = (float)Time;
+	const float Curl = 0.5f - 0.5f * FMath::Cos(0.5f * Angle);
+	auto SetHandPose = [Angle, Curl](FMCSharedHandPose& HandPose, const FVector& Center, const float Direction)
+	{
+		const FVector Location = Center + FVector(0.f, FMath::Cos(Angle) * 10.f * Direction, FMath::Sin(Angle) * 10.f);
+		const FQuat Rotation(FVector::ForwardVector, 0.25f * FMath::Sin(Angle) * Direction);
+		HandPose.Location[0] = Location.X;
+		HandPose.Location[1] = Location.Y;
+		HandPose.Location[2] = Location.Z;
+		HandPose.Rotation[0] = Rotation.X;
+		HandPose.Rotation[1] = Rotation.Y;
+		HandPose.Rotation[2] = Rotation.Z;
+		HandPose.Rotation[3] = Rotation.W;
+		HandPose.Flags = MCSP_Valid | MCSP_HasFingers;
+		for (int32 FingerIdx = 0; FingerIdx < MC_NUM_FINGERS; ++FingerIdx)
+		{
+			HandPose.FingerCurl[FingerIdx] = Curl;
+		}
+	};
+	SetHandPose(Sample.Left, FVector(75.f, -30.f, 30.f), -1.f);
+	SetHandPose(Sample.Right, FVector(75.f, 30.f, 30.f), 1.f);
+	return Sample;
+}
@@ -0,0 +1,164 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCSharedPoseRing.h"
+#include "HAL/PlatformMisc.h"
+
+/** Number of attempts of reading a slot the producer is writing to */
+static const int32 MCSharedPoseReadAttempts = 4;
+
+// Constructor
+FMCSharedPoseRing::FMCSharedPoseRing()
+{
+	Region = nullptr;
+	Header = nullptr;
+	LastReadIndex = 0;
+	NumDropped = 0;
+}
+
+// Destructor, unmaps the region
+FMCSharedPoseRing::~FMCSharedPoseRing()
+{
+	FMCSharedPoseRing::Close();
+}
+
+// Map an existing region for reading
+bool FMCSharedPoseRing::OpenForReading(const FString& Name)
+{
+	if (!FMCSharedPoseRing::Map(Name, false))
+	{
+		return false;
+	}
+
+	// The producer writes the magic last, after the rest of the header
+	if (Header->Magic != MC_SHARED_POSE_MAGIC ||
+		Header->Version != MC_SHARED_POSE_VERSION ||
+		Header->HeaderSize != sizeof(FMCSharedPoseHeader) ||
+		Header->SlotSize != sizeof(FMCSharedPoseSlot) ||
+		Header->RingSize != MC_SHARED_POSE_RING_SIZE)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMCSharedPoseRing: %s has an unknown layout (version %u, expected %d)!"),
+			*Name, Header->Version, (int32)MC_SHARED_POSE_VERSION);
+		FMCSharedPoseRing::Close();
+		return false;
+	}
+
+	// Only samples published from now on are read
+	LastReadIndex = Header->WriteIndex;
+	NumDropped = 0;
+	return true;
+}
+
+// Create (or map) the region for writing and initialize the header
+bool FMCSharedPoseRing::CreateForWriting(const FString& Name)
+{
+	if (!FMCSharedPoseRing::Map(Name, true))
+	{
+		return false;
+	}
+
+	FMemory::Memzero(Header, FMCSharedPoseRing::GetRegionSize());
+	Header->Version = MC_SHARED_POSE_VERSION;
+	Header->HeaderSize = sizeof(FMCSharedPoseHeader);
+	Header->SlotSize = sizeof(FMCSharedPoseSlot);
+	Header->RingSize = MC_SHARED_POSE_RING_SIZE;
+	FPlatformMisc::MemoryBarrier();
+	Header->Magic = MC_SHARED_POSE_MAGIC;
+	return true;
+}
+
+// Unmap the region
+void FMCSharedPoseRing::Close()
+{
+	if (Region)
+	{
+		FPlatformMemory::UnmapNamedSharedMemoryRegion(Region);
+	}
+	Region = nullptr;
+	Header = nullptr;
+}
+
+// Copy the newest sample if it was not read before, never blocks
+bool FMCSharedPoseRing::ReadLatest(FMCSharedPoseSample& OutSample)
+{
+	if (!Header)
+	{
+		return false;
+	}
+
+	for (int32 Attempt = 0; Attempt < MCSharedPoseReadAttempts; ++Attempt)
+	{
+		const uint64 WriteIndex = Header->WriteIndex;
+		FPlatformMisc::MemoryBarrier();
+
+		// Producer restarted, continue from its first sample
+		if (WriteIndex < LastReadIndex)
+		{
+			LastReadIndex = 0;
+		}
+		if (WriteIndex == LastReadIndex)
+		{
+			return false;
+		}
+
+		// Seqlock read, retry if the producer wrote to the slot meanwhile (it may have wrapped around the ring)
+		const FMCSharedPoseSlot* Slot = FMCSharedPoseRing::GetSlot(WriteIndex - 1);
+		const uint32 Sequence = Slot->Sequence;
+		FPlatformMisc::MemoryBarrier();
+		if (Sequence & 1)
+		{
+			continue;
+		}
+		FMemory::Memcpy(&OutSample, const_cast<const FMCSharedPoseSample*>(&Slot->Sample), sizeof(FMCSharedPoseSample));
+		FPlatformMisc::MemoryBarrier();
+		if (Slot->Sequence != Sequence)
+		{
+			continue;
+		}
+
+		NumDropped += WriteIndex - LastReadIndex - 1;
+		LastReadIndex = WriteIndex;
+		return true;
+	}
+	return false;
+}
+
+// Publish a sample (producer only)
+void FMCSharedPoseRing::Write(const FMCSharedPoseSample& Sample)
+{
+	if (!Header)
+	{
+		return;
+	}
+
+	const uint64 WriteIndex = Header->WriteIndex;
+	FMCSharedPoseSlot* Slot = FMCSharedPoseRing::GetSlot(WriteIndex);
+	const uint32 Sequence = Slot->Sequence;
+
+	Slot->Sequence = Sequence + 1;
+	FPlatformMisc::MemoryBarrier();
+	FMemory::Memcpy(&Slot->Sample, &Sample, sizeof(FMCSharedPoseSample));
+	FPlatformMisc::MemoryBarrier();
+	Slot->Sequence = Sequence + 2;
+	FPlatformMisc::MemoryBarrier();
+	Header->WriteIndex = WriteIndex + 1;
+}
+
+// Map the region
+bool FMCSharedPoseRing::Map(const FString& Name, const bool bCreate)
+{
+	FMCSharedPoseRing::Close();
+
+	const uint32 AccessMode = bCreate
+		? (uint32)FPlatformMemory::ESharedMemoryAccess::Read | (uint32)FPlatformMemory::ESharedMemoryAccess::Write
+		: (uint32)FPlatformMemory::ESharedMemoryAccess::Read;
+	Region = FPlatformMemory::MapNamedSharedMemoryRegion(Name, bCreate, AccessMode, FMCSharedPoseRing::GetRegionSize());
+	if (!Region)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FMCSharedPoseRing: Could not %s the shared memory region %s .."),
+			bCreate ? TEXT("create") : TEXT("open"), *Name);
+		return false;
+	}
+	Header = static_cast<FMCSharedPoseHeader*>(Region->GetAddress());
+	return true;
+}
@@ -0,0 +1,34 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+
+/** Motion controller interaction stats (stat MCInteraction) */
+DECLARE_STATS_GROUP(TEXT("MCInteraction"), STATGROUP_MCInteraction, STATCAT_Advanced);
+
+// Time spent moving the hands towards the motion controller targets
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Hand Control"), STAT_MCHandControl, STATGROUP_MCInteraction, );
+
+// Time spent updating the finger drive targets
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Finger Drives"), STAT_MCFingerDrives, STATGROUP_MCInteraction, );
+
+// Contacts of the hand bodies with other actors in the current frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hand Contacts"), STAT_MCHandContacts, STATGROUP_MCInteraction, );
+
+// Smoothed plugin cost per frame (ms)
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Plugin Frame Cost (ms)"), STAT_MCPluginFrameMs, STATGROUP_MCInteraction, );
+
+// Smoothed physics step time per frame (ms)
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Physics Step (ms)"), STAT_MCPhysicsStepMs, STATGROUP_MCInteraction, );
+
+// Currently active quality tier of the frame budget governor
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Quality Tier"), STAT_MCQualityTier, STATGROUP_MCInteraction, );
+
+// Number of quality tier changes since start
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Quality Tier Changes"), STAT_MCQualityTierChanges, STATGROUP_MCInteraction, );
+
+// Hand state payload sent since start (bytes)
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Hand Net Bytes Sent"), STAT_MCHandNetBytes, STATGROUP_MCInteraction, );
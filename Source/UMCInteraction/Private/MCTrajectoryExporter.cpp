@@ -0,0 +1,315 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCTrajectoryExporter.h"
+#include "HAL/FileManager.h"
+#include "HAL/RunnableThread.h"
+#include "HAL/Event.h"
+#include "HAL/PlatformProcess.h"
+#include "Misc/FileHelper.h"
+
+// Constructor
+FMCTrajectoryExporter::FMCTrajectoryExporter()
+{
+	RowsPerChunk = 0;
+	RingRows = 0;
+	NumDroppedRows = 0;
+	FileWriter = nullptr;
+	Thread = nullptr;
+	WakeEvent = nullptr;
+}
+
+// Destructor, finishes the file if still open
+FMCTrajectoryExporter::~FMCTrajectoryExporter()
+{
+	FMCTrajectoryExporter::Finish();
+}
+
+// Add a column (before Start), returns its index in the row
+int32 FMCTrajectoryExporter::AddColumn(const FString& Name, const EMCTrajectoryColumnType Type)
+{
+	check(!IsStarted());
+
+	FMCTrajectoryColumn Column;
+	FMemory::Memzero(Column);
+	FCStringAnsi::Strncpy(Column.Name, TCHAR_TO_ANSI(*Name), ARRAY_COUNT(Column.Name));
+	Column.Type = (uint32)Type;
+	return Columns.Add(Column);
+}
+
+// Open the file, write the header and start the writer thread
+bool FMCTrajectoryExporter::Start(const FString& Filename, const int32 InRowsPerChunk, const int32 InRingChunks)
+{
+	if (IsStarted() || Columns.Num() == 0)
+	{
+		return false;
+	}
+
+	FileWriter = IFileManager::Get().CreateFileWriter(*Filename);
+	if (!FileWriter)
+	{
+		UE_LOG(LogTemp, Error, TEXT("FMCTrajectoryExporter: Could not create %s !"), *Filename);
+		return false;
+	}
+
+	// Preallocate everything, the game thread never allocates while exporting
+	RowsPerChunk = FMath::Max(InRowsPerChunk, 1);
+	RingRows = RowsPerChunk * FMath::Max(InRingChunks, 2);
+	Ring.SetNumZeroed(RingRows * Columns.Num());
+	ChunkBuffer.SetNumZeroed(RowsPerChunk * Columns.Num());
+	NumWrittenRows.Reset();
+	NumReadRows.Reset();
+	NumDroppedRows = 0;
+	ChunkIndex.Reset();
+	bStopRequested = false;
+
+	FMCTrajectoryFileHeader Header;
+	Header.Magic = MC_TRAJECTORY_MAGIC;
+	Header.Version = MC_TRAJECTORY_VERSION;
+	Header.RowsPerChunk = RowsPerChunk;
+	Header.NumColumns = Columns.Num();
+	Header.DataOffset = sizeof(FMCTrajectoryFileHeader) + Columns.Num() * sizeof(FMCTrajectoryColumn);
+	FileWriter->Serialize(&Header, sizeof(Header));
+	FileWriter->Serialize(Columns.GetData(), Columns.Num() * sizeof(FMCTrajectoryColumn));
+
+	WakeEvent = FPlatformProcess::GetSynchEventFromPool();
+	Thread = FRunnableThread::Create(this, TEXT("MCTrajectoryExporter"), 0, TPri_BelowNormal);
+	return true;
+}
+
+// Get the next row to fill (game thread), nullptr if the ring buffer is full and the row is dropped
+uint32* FMCTrajectoryExporter::BeginRow()
+{
+	if (!IsStarted())
+	{
+		return nullptr;
+	}
+
+	const int64 Written = NumWrittenRows.GetValue();
+	if (Written - NumReadRows.GetValue() >= RingRows)
+	{
+		NumDroppedRows++;
+		return nullptr;
+	}
+	return &Ring[(Written % RingRows) * Columns.Num()];
+}
+
+// Publish the filled row (game thread)
+void FMCTrajectoryExporter::EndRow()
+{
+	// The counter increment is a full barrier, the row values are visible before the new count
+	if (NumWrittenRows.Increment() % RowsPerChunk == 0)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+// Write the remaining rows and the footer, close the file
+void FMCTrajectoryExporter::Finish()
+{
+	if (!IsStarted())
+	{
+		return;
+	}
+
+	FMCTrajectoryExporter::Stop();
+	Thread->WaitForCompletion();
+	delete Thread;
+	Thread = nullptr;
+	FPlatformProcess::ReturnSynchEventToPool(WakeEvent);
+	WakeEvent = nullptr;
+
+	FMCTrajectoryFileFooter Footer;
+	Footer.IndexOffset = FileWriter->Tell();
+	Footer.NumRows = NumReadRows.GetValue();
+	Footer.NumDroppedRows = NumDroppedRows;
+	Footer.NumChunks = ChunkIndex.Num();
+	Footer.Magic = MC_TRAJECTORY_MAGIC;
+	FileWriter->Serialize(ChunkIndex.GetData(), ChunkIndex.Num() * sizeof(FMCTrajectoryChunk));
+	FileWriter->Serialize(&Footer, sizeof(Footer));
+	FileWriter->Close();
+	delete FileWriter;
+	FileWriter = nullptr;
+
+	if (NumDroppedRows > 0)
+	{
+		UE_LOG(LogTemp, Warning, TEXT("FMCTrajectoryExporter: %lld rows dropped, the writer could not keep up !"),
+			NumDroppedRows);
+	}
+
+	// Release the buffers
+	Ring.Empty();
+	ChunkBuffer.Empty();
+}
+
+// Writer thread loop
+uint32 FMCTrajectoryExporter::Run()
+{
+	while (true)
+	{
+		const int64 Available = NumWrittenRows.GetValue() - NumReadRows.GetValue();
+		if (Available >= RowsPerChunk)
+		{
+			FMCTrajectoryExporter::WriteChunk(RowsPerChunk);
+		}
+		else if (bStopRequested)
+		{
+			// Flush the last partial chunk
+			if (Available > 0)
+			{
+				FMCTrajectoryExporter::WriteChunk((int32)Available);
+			}
+			break;
+		}
+		else
+		{
+			WakeEvent->Wait(100);
+		}
+	}
+	return 0;
+}
+
+// Request the writer thread to flush and exit
+void FMCTrajectoryExporter::Stop()
+{
+	bStopRequested = true;
+	if (WakeEvent)
+	{
+		WakeEvent->Trigger();
+	}
+}
+
+// Transpose and write a chunk of rows (writer thread)
+void FMCTrajectoryExporter::WriteChunk(const int32 NumRows)
+{
+	const int32 NumColumns = Columns.Num();
+	const int64 FirstRow = NumReadRows.GetValue();
+
+	// Partial chunks keep the fixed chunk size so the column offsets stay computable
+	if (NumRows < RowsPerChunk)
+	{
+		FMemory::Memzero(ChunkBuffer.GetData(), ChunkBuffer.Num() * sizeof(uint32));
+	}
+
+	for (int32 RowIdx = 0; RowIdx < NumRows; ++RowIdx)
+	{
+		const uint32* Row = &Ring[((FirstRow + RowIdx) % RingRows) * NumColumns];
+		for (int32 ColIdx = 0; ColIdx < NumColumns; ++ColIdx)
+		{
+			ChunkBuffer[ColIdx * RowsPerChunk + RowIdx] = Row[ColIdx];
+		}
+	}
+
+	// The ring slots can be reused as soon as they are transposed
+	NumReadRows.Add(NumRows);
+
+	FMCTrajectoryChunk Chunk;
+	Chunk.Offset = FileWriter->Tell();
+	Chunk.NumRows = NumRows;
+	Chunk.Reserved = 0;
+	ChunkIndex.Add(Chunk);
+	FileWriter->Serialize(ChunkBuffer.GetData(), ChunkBuffer.Num() * sizeof(uint32));
+}
+
+// Concatenate trajectory files with the same columns and chunk size into one file (the chunks are copied as they are)
+bool FMCTrajectoryExporter::MergeFiles(const TArray<FString>& Filenames, const FString& OutFilename,
+	TArray<TPair<uint64, uint64>>& OutRowRanges)
+{
+	OutRowRanges.Init(TPair<uint64, uint64>(0, 0), Filenames.Num());
+
+	FArchive* Writer = nullptr;
+	FMCTrajectoryFileHeader MergedHeader;
+	TArray<FMCTrajectoryColumn> MergedColumns;
+	TArray<FMCTrajectoryChunk> MergedIndex;
+	uint64 NumRows = 0;
+	uint64 NumDroppedRows = 0;
+	for (int32 FileIdx = 0; FileIdx < Filenames.Num(); ++FileIdx)
+	{
+		const FString& Filename = Filenames[FileIdx];
+		TArray<uint8> Data;
+		if (!FFileHelper::LoadFileToArray(Data, *Filename))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("FMCTrajectoryExporter: Could not read %s, not merged.."), *Filename);
+			continue;
+		}
+
+		// Validate the header, the column table and the footer
+		FMCTrajectoryFileHeader Header;
+		FMCTrajectoryFileFooter Footer;
+		if (Data.Num() < (int64)(sizeof(Header) + sizeof(Footer)))
+		{
+			UE_LOG(LogTemp, Warning, TEXT("FMCTrajectoryExporter: %s is not a finished trajectory file, not merged.."), *Filename);
+			continue;
+		}
+		FMemory::Memcpy(&Header, Data.GetData(), sizeof(Header));
+		FMemory::Memcpy(&Footer, &Data[Data.Num() - sizeof(Footer)], sizeof(Footer));
+		const uint64 ChunkSize = (uint64)Header.RowsPerChunk * Header.NumColumns * sizeof(uint32);
+		if (Header.Magic != MC_TRAJECTORY_MAGIC || Header.Version != MC_TRAJECTORY_VERSION || Footer.Magic != MC_TRAJECTORY_MAGIC ||
+			Header.DataOffset != sizeof(Header) + (uint64)Header.NumColumns * sizeof(FMCTrajectoryColumn) ||
+			Footer.IndexOffset + (uint64)Footer.NumChunks * sizeof(FMCTrajectoryChunk) + sizeof(Footer) != (uint64)Data.Num())
+		{
+			UE_LOG(LogTemp, Warning, TEXT("FMCTrajectoryExporter: %s is not a finished trajectory file, not merged.."), *Filename);
+			continue;
+		}
+		const FMCTrajectoryColumn* Columns = reinterpret_cast<const FMCTrajectoryColumn*>(&Data[sizeof(Header)]);
+
+		// The first file sets the layout of the merged file
+		if (!Writer)
+		{
+			Writer = IFileManager::Get().CreateFileWriter(*OutFilename);
+			if (!Writer)
+			{
+				UE_LOG(LogTemp, Error, TEXT("FMCTrajectoryExporter: Could not create %s !"), *OutFilename);
+				return false;
+			}
+			MergedHeader = Header;
+			MergedColumns.Append(Columns, Header.NumColumns);
+			Writer->Serialize(&MergedHeader, sizeof(MergedHeader));
+			Writer->Serialize(MergedColumns.GetData(), MergedColumns.Num() * sizeof(FMCTrajectoryColumn));
+		}
+		else if (Header.RowsPerChunk != MergedHeader.RowsPerChunk || Header.NumColumns != MergedHeader.NumColumns ||
+			FMemory::Memcmp(Columns, MergedColumns.GetData(), MergedColumns.Num() * sizeof(FMCTrajectoryColumn)) != 0)
+		{
+			UE_LOG(LogTemp, Warning, TEXT("FMCTrajectoryExporter: %s has different columns than %s, not merged.."),
+				*Filename, *OutFilename);
+			continue;
+		}
+
+		// Copy the chunks, only their offsets change
+		const FMCTrajectoryChunk* Chunks = reinterpret_cast<const FMCTrajectoryChunk*>(&Data[Footer.IndexOffset]);
+		uint64 FileRows = 0;
+		for (uint32 ChunkIdx = 0; ChunkIdx < Footer.NumChunks; ++ChunkIdx)
+		{
+			FMCTrajectoryChunk Chunk = Chunks[ChunkIdx];
+			if (Chunk.Offset + ChunkSize > Footer.IndexOffset)
+			{
+				break;
+			}
+			Writer->Serialize(&Data[Chunk.Offset], ChunkSize);
+			Chunk.Offset = MergedIndex.Num() > 0 ? MergedIndex.Last().Offset + ChunkSize : MergedHeader.DataOffset;
+			MergedIndex.Add(Chunk);
+			FileRows += Chunk.NumRows;
+		}
+		OutRowRanges[FileIdx] = TPair<uint64, uint64>(NumRows, FileRows);
+		NumRows += FileRows;
+		NumDroppedRows += Footer.NumDroppedRows;
+	}
+
+	if (!Writer)
+	{
+		return false;
+	}
+
+	FMCTrajectoryFileFooter MergedFooter;
+	MergedFooter.IndexOffset = Writer->Tell();
+	MergedFooter.NumRows = NumRows;
+	MergedFooter.NumDroppedRows = NumDroppedRows;
+	MergedFooter.NumChunks = MergedIndex.Num();
+	MergedFooter.Magic = MC_TRAJECTORY_MAGIC;
+	Writer->Serialize(MergedIndex.GetData(), MergedIndex.Num() * sizeof(FMCTrajectoryChunk));
+	Writer->Serialize(&MergedFooter, sizeof(MergedFooter));
+	const bool bSuccess = !Writer->IsError();
+	Writer->Close();
+	delete Writer;
+	return bSuccess;
+}
@@ -0,0 +1,126 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#include "MCWorldRegistry.h"
+#include "Engine/World.h"
+#include "EngineUtils.h"
+#include "SLRuntimeManager.h"
+#include "MCHand.h"
+#include "MCCharacter.h"
+
+// Registries of the worlds
+static TMap<UWorld*, TSharedPtr<FMCWorldRegistry>> WorldRegistries;
+
+// World cleanup delegate handle
+static FDelegateHandle WorldCleanupHandle;
+
+// Constructor
+FMCWorldRegistry::FMCWorldRegistry(UWorld* InWorld) :
+	World(InWorld),
+	bSemLogRuntimeManagerResolved(false)
+{}
+
+// Get (or create) the registry of the world
+FMCWorldRegistry& FMCWorldRegistry::Get(UWorld* InWorld)
+{
+	check(IsInGameThread());
+	TSharedPtr<FMCWorldRegistry>* Registry = WorldRegistries.Find(InWorld);
+	if (Registry)
+	{
+		return **Registry;
+	}
+	return *WorldRegistries.Add(InWorld, MakeShareable(new FMCWorldRegistry(InWorld)));
+}
+
+// Bind the world cleanup callback
+void FMCWorldRegistry::Startup()
+{
+	WorldCleanupHandle = FWorldDelegates::OnWorldCleanup.AddStatic(&FMCWorldRegistry::OnWorldCleanup);
+}
+
+// Remove the cleanup callback and all registries
+void FMCWorldRegistry::Shutdown()
+{
+	FWorldDelegates::OnWorldCleanup.Remove(WorldCleanupHandle);
+	WorldRegistries.Empty();
+}
+
+// Remove the registry of the world
+void FMCWorldRegistry::OnWorldCleanup(UWorld* InWorld, bool bSessionEnded, bool bCleanupResources)
+{
+	WorldRegistries.Remove(InWorld);
+}
+
+// Get the semantic logging runtime manager, the world is only scanned on the first call
+ASLRuntimeManager* FMCWorldRegistry::GetSemLogRuntimeManager()
+{
+	if (!bSemLogRuntimeManagerResolved)
+	{
+		for (TActorIterator<ASLRuntimeManager>RMItr(World); RMItr; ++RMItr)
+		{
+			SemLogRuntimeManager = *RMItr;
+			break;
+		}
+		bSemLogRuntimeManagerResolved = true;
+	}
+	return SemLogRuntimeManager.Get();
+}
+
+// Write the grasp events of the world to a binary log instead of the runtime manager
+bool FMCWorldRegistry::OpenSemanticEventLog(const FString& Filename)
+{
+	return SemanticEventLog.Open(Filename);
+}
+
+// Close the binary semantic event log
+void FMCWorldRegistry::CloseSemanticEventLog()
+{
+	SemanticEventLog.Close();
+}
+
+// Register hand
+void FMCWorldRegistry::RegisterHand(AMCHand* InHand)
+{
+	Hands.AddUnique(InHand);
+}
+
+// Unregister hand, clears its pairing as well
+void FMCWorldRegistry::UnregisterHand(AMCHand* InHand)
+{
+	Hands.RemoveSingleSwap(InHand);
+
+	AMCHand* PairedHand = nullptr;
+	if (HandPairs.RemoveAndCopyValue(InHand, PairedHand))
+	{
+		HandPairs.Remove(PairedHand);
+		PairedHand->SetOtherHand(nullptr);
+	}
+}
+
+// Pair the two hands, used for the two hands fixation grasp
+void FMCWorldRegistry::RegisterHandPair(AMCHand* InLeftHand, AMCHand* InRightHand)
+{
+	HandPairs.Add(InLeftHand, InRightHand);
+	HandPairs.Add(InRightHand, InLeftHand);
+	InLeftHand->SetOtherHand(InRightHand);
+	InRightHand->SetOtherHand(InLeftHand);
+}
+
+// Get the paired hand
+AMCHand* FMCWorldRegistry::GetOtherHand(const AMCHand* InHand) const
+{
+	AMCHand* const* PairedHand = HandPairs.Find(InHand);
+	return PairedHand ? *PairedHand : nullptr;
+}
+
+// Register character
+void FMCWorldRegistry::RegisterCharacter(AMCCharacter* InCharacter)
+{
+	Characters.AddUnique(InCharacter);
+}
+
+// Unregister character
+void FMCWorldRegistry::UnregisterCharacter(AMCCharacter* InCharacter)
+{
+	Characters.RemoveSingleSwap(InCharacter);
+}
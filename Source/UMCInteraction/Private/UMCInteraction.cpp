@@ -2,18 +2,31 @@
 // Author: Andrei Haidu (http://haidu.eu)
 
 #include "UMCInteraction.h"
+#include "MCStats.h"
+#include "MCWorldRegistry.h"
+
+DEFINE_STAT(STAT_MCHandControl);
+DEFINE_STAT(STAT_MCFingerDrives);
+DEFINE_STAT(STAT_MCHandContacts);
+DEFINE_STAT(STAT_MCPluginFrameMs);
+DEFINE_STAT(STAT_MCPhysicsStepMs);
+DEFINE_STAT(STAT_MCQualityTier);
+DEFINE_STAT(STAT_MCQualityTierChanges);
+DEFINE_STAT(STAT_MCHandNetBytes);
 
 #define LOCTEXT_NAMESPACE "FUMCInteractionModule"
 
 void FUMCInteractionModule::StartupModule()
 {
 	// This code will execute after your module is loaded into memory; the exact timing is specified in the .uplugin file per-module
+	FMCWorldRegistry::Startup();
 }
 
 void FUMCInteractionModule::ShutdownModule()
 {
 	// This function may be called during shutdown to clean up your module.  For modules that support dynamic reloading,
 	// we call this function before unloading the module.
+	FMCWorldRegistry::Shutdown();
 }
 
 #undef LOCTEXT_NAMESPACE
@@ -9,9 +9,54 @@
 #include "Animation/SkeletalMeshActor.h"
 #include "MotionControllerComponent.h"
 #include "MCHand.h"
-#include "PIDController3D.h"
+#include "MCControlCore.h"
+#include "MCFrameBudgetGovernor.h"
+#include "MCInputFrame.h"
+#include "MCSharedPoseRing.h"
+#include "MCGloveInput.h"
+#include "MCHandNetState.h"
+#include "MCTrajectoryExporter.h"
 #include "MCCharacter.generated.h"
 
+class FPhysScene;
+
+/** Linear hand control strategy (same order as MCControl::ELinearStrategy) */
+UENUM(BlueprintType)
+enum class EMCLinearControl : uint8
+{
+	ForcePD			UMETA(DisplayName = "Force PD"),
+	VelocityP		UMETA(DisplayName = "Velocity P"),
+	Impulse			UMETA(DisplayName = "Impulse")
+};
+
+/**
+* Character tick function running after the physics results are available
+*/
+USTRUCT()
+struct FMCCharacterPostPhysicsTickFunction : public FTickFunction
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Character to tick
+	class AMCCharacter* Target;
+
+	// Calls the post physics tick of the character
+	virtual void ExecuteTick(float DeltaTime, ELevelTick TickType, ENamedThreads::Type CurrentThread,
+		const FGraphEventRef& MyCompletionGraphEvent) override;
+
+	// Describe the tick function
+	virtual FString DiagnosticMessage() override;
+};
+
+template<>
+struct TStructOpsTypeTraits<FMCCharacterPostPhysicsTickFunction> : public TStructOpsTypeTraitsBase2<FMCCharacterPostPhysicsTickFunction>
+{
+	enum
+	{
+		WithCopy = false
+	};
+};
+
 UCLASS()
 class UMCINTERACTION_API AMCCharacter : public ACharacter
 {
@@ -24,12 +69,57 @@ public:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
 
+	// Called every frame after the physics results are available
+	void PostPhysicsTick(float DeltaTime);
+
+	// Register / unregister the post physics tick function as well
+	virtual void RegisterActorTickFunctions(bool bRegister) override;
+
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+	// Switch to deterministic mode and replay the input recording, returns false if the recording cannot be loaded
+	bool StartReplay(const FString& InInputRecordingFile);
+
+	// Check if all the replayed input frames have been applied
+	bool IsReplayFinished() const;
+
+	// Get the number of simulation steps advanced in deterministic mode
+	int32 GetSimulationStep() const { return SimulationStep; };
+
+	// Get the left MC hand
+	AMCHand* GetLeftHand() const { return LeftHand; };
+
+	// Get the right MC hand
+	AMCHand* GetRightHand() const { return RightHand; };
+
+	// Start streaming the hand and object trajectories to file, returns false if the file cannot be created
+	bool StartTrajectoryExport(const FString& InTrajectoryFile);
+
+	// Write the remaining trajectory samples and close the file
+	void FinishTrajectoryExport();
+
+	// Switch the linear control strategy of a hand, the controller gains are set for the strategy
+	void SetLinearControl(const EHandType InHandType, const EMCLinearControl InLinearControl);
+
+	// Replicate the hand states to the other users
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Get the hand state payload sent per hand and second (bytes, all connections on the server)
+	float GetHandNetBytesPerSecond() const;
+
+	// Get the joint angle stream of a glove, the device adds its frames to it
+	FMCGloveStream& GetGloveStream(const EHandType InHandType)
+	{
+		return InHandType == EHandType::Left ? LeftGloveStream : RightGloveStream;
+	};
+
 protected:
 	// Left hand skeletal mesh
 	UPROPERTY(EditAnywhere, Category = "MC|Hands")
@@ -43,6 +133,14 @@ protected:
 	UPROPERTY(EditAnywhere, Category = "MC|Hands")
 	bool bUseHandsInitialRotationAsOffset;
 
+	// Hand spawned for the character if no left hand actor is set (e.g. the characters of other users)
+	UPROPERTY(EditAnywhere, Category = "MC|Hands")
+	TSubclassOf<AMCHand> LeftHandClass;
+
+	// Hand spawned for the character if no right hand actor is set (e.g. the characters of other users)
+	UPROPERTY(EditAnywhere, Category = "MC|Hands")
+	TSubclassOf<AMCHand> RightHandClass;
+
 	// Show motion controller pose arrows
 	UPROPERTY(EditAnywhere, Category = "MC|Hands")
 	bool bShowTargetArrows;
@@ -74,7 +172,136 @@ protected:
 	// Hand rotation controller boost
 	UPROPERTY(EditAnywhere, Category = "MC|Control")
 	float RotationBoost;
+
+	// Left hand linear control strategy
+	UPROPERTY(EditAnywhere, Category = "MC|Control")
+	EMCLinearControl LeftLinearControl;
+
+	// Right hand linear control strategy
+	UPROPERTY(EditAnywhere, Category = "MC|Control")
+	EMCLinearControl RightLinearControl;
+
+	// Proportional argument of the velocity and impulse strategies (1/s)
+	UPROPERTY(EditAnywhere, Category = "MC|Control", meta = (ClampMin = 0))
+	float VelocityPGain;
+
+	// Maximum velocity (change) of the velocity and impulse strategies (cm/s)
+	UPROPERTY(EditAnywhere, Category = "MC|Control", meta = (ClampMin = 0))
+	float VelocityMaxOutput;
+
+	// Scale the force PD output with the mass and the rotation with the inertia of every hand body (the palm includes the
+	// carried object), and feed the target motion forward
+	UPROPERTY(EditAnywhere, Category = "MC|Control")
+	bool bMassAwareControl;
+
+	// Share of the target acceleration (force PD) or velocity (velocity, impulse, rotation) fed forward
+	UPROPERTY(EditAnywhere, Category = "MC|Control", meta = (editcondition = "bMassAwareControl", ClampMin = 0, ClampMax = 1))
+	float FeedforwardGain;
+
+	// Number of kinematic history samples used to estimate the target motion
+	UPROPERTY(EditAnywhere, Category = "MC|Control", meta = (editcondition = "bMassAwareControl", ClampMin = 2, ClampMax = 16))
+	int32 FeedforwardSamples;
 	
+	// Trade hand simulation fidelity for time when the frame budget is exceeded
+	UPROPERTY(EditAnywhere, Category = "MC|Budget")
+	FMCFrameBudgetGovernor FrameBudgetGovernor;
+
+	// Advance the input and the hand control on a fixed simulation clock (fixed engine time step and physics substeps)
+	UPROPERTY(EditAnywhere, Category = "MC|Determinism")
+	bool bDeterministicMode;
+
+	// Simulation steps per second in deterministic mode
+	UPROPERTY(EditAnywhere, Category = "MC|Determinism", meta = (editcondition = "bDeterministicMode", ClampMin = 1))
+	float SimulationStepHz;
+
+	// Physics substeps per simulation step in deterministic mode
+	UPROPERTY(EditAnywhere, Category = "MC|Determinism", meta = (editcondition = "bDeterministicMode", ClampMin = 1))
+	int32 PhysicsSubsteps;
+
+	// Random seed used in deterministic mode
+	UPROPERTY(EditAnywhere, Category = "MC|Determinism", meta = (editcondition = "bDeterministicMode"))
+	int32 RandomSeed;
+
+	// Live input, live input recorded to file, or input replayed from file (deterministic mode only)
+	UPROPERTY(EditAnywhere, Category = "MC|Determinism", meta = (editcondition = "bDeterministicMode"))
+	EMCInputMode InputMode;
+
+	// Input recording file (absolute, or relative to the project directory)
+	UPROPERTY(EditAnywhere, Category = "MC|Determinism", meta = (editcondition = "bDeterministicMode"))
+	FString InputRecordingFile;
+
+	// Read the motion controller poses (and finger curls) of an external tracker from a shared memory ring instead of the MC components
+	UPROPERTY(EditAnywhere, Category = "MC|Tracking")
+	bool bUseSharedMemoryPoses;
+
+	// Name of the shared memory region written by the tracker
+	UPROPERTY(EditAnywhere, Category = "MC|Tracking", meta = (editcondition = "bUseSharedMemoryPoses"))
+	FString SharedMemoryName;
+
+	// Drive the finger joints with the per-joint angles of data gloves instead of the grasp axis values
+	UPROPERTY(EditAnywhere, Category = "MC|Glove")
+	bool bUseGloveInput;
+
+	// Live glove input, live input recorded to file, or input replayed from file (no glove hardware needed)
+	UPROPERTY(EditAnywhere, Category = "MC|Glove", meta = (editcondition = "bUseGloveInput"))
+	EMCInputMode GloveInputMode;
+
+	// Left glove recording file (absolute, or relative to the project directory)
+	UPROPERTY(EditAnywhere, Category = "MC|Glove", meta = (editcondition = "bUseGloveInput"))
+	FString LeftGloveRecordingFile;
+
+	// Right glove recording file (absolute, or relative to the project directory)
+	UPROPERTY(EditAnywhere, Category = "MC|Glove", meta = (editcondition = "bUseGloveInput"))
+	FString RightGloveRecordingFile;
+
+	// Cutoff frequency of the low-pass filter applied at the glove rate (Hz, 0 disables the filter)
+	UPROPERTY(EditAnywhere, Category = "MC|Glove", meta = (editcondition = "bUseGloveInput", ClampMin = 0))
+	float GloveFilterCutoffHz;
+
+	// The joint angles are resampled this far behind the newest glove frame (s), interpolated instead of extrapolated
+	UPROPERTY(EditAnywhere, Category = "MC|Glove", meta = (editcondition = "bUseGloveInput", ClampMin = 0))
+	float GloveResampleDelay;
+
+	// Send the hand states to the other users in networked sessions, their hands are rendered from the states
+	UPROPERTY(EditAnywhere, Category = "MC|Replication")
+	bool bReplicateHands;
+
+	// Hand states sent per second (owner to server, and server to the other users)
+	UPROPERTY(EditAnywhere, Category = "MC|Replication", meta = (editcondition = "bReplicateHands", ClampMin = 1, ClampMax = 120))
+	float HandNetSendHz;
+
+	// Send the per-joint angles instead of only the grasp value
+	UPROPERTY(EditAnywhere, Category = "MC|Replication", meta = (editcondition = "bReplicateHands"))
+	bool bReplicateJointAngles;
+
+	// The hands of other users are rendered this far behind their newest received state (s)
+	UPROPERTY(EditAnywhere, Category = "MC|Replication", meta = (editcondition = "bReplicateHands", ClampMin = 0))
+	float RemoteHandInterpolationDelay;
+
+	// Count the hand state RPC payload sent by the clients (serializes the states a second time, debug only)
+	UPROPERTY(EditAnywhere, Category = "MC|Replication", AdvancedDisplay, meta = (editcondition = "bReplicateHands"))
+	bool bCountClientHandNetBits;
+
+	// Stream the hand and object trajectories to a columnar file after every physics step
+	UPROPERTY(EditAnywhere, Category = "MC|Export")
+	bool bExportTrajectory;
+
+	// Trajectory file (absolute, or relative to the project directory)
+	UPROPERTY(EditAnywhere, Category = "MC|Export", meta = (editcondition = "bExportTrajectory"))
+	FString TrajectoryFile;
+
+	// Number of samples per file chunk
+	UPROPERTY(EditAnywhere, Category = "MC|Export", meta = (editcondition = "bExportTrajectory", ClampMin = 1))
+	int32 TrajectoryRowsPerChunk;
+
+	// Write the grasp events to a binary log (converted offline to OWL) instead of the semantic logger runtime manager
+	UPROPERTY(EditAnywhere, Category = "MC|Export")
+	bool bBinarySemanticLog;
+
+	// Binary semantic event log file (absolute, or relative to the project directory)
+	UPROPERTY(EditAnywhere, Category = "MC|Export", meta = (editcondition = "bBinarySemanticLog"))
+	FString SemanticLogFile;
+
 	// Character camera
 	UPROPERTY(EditAnywhere)
 	UCameraComponent* CharCamera;
@@ -93,9 +320,92 @@ protected:
 		UMotionControllerComponent* MC,
 		const FQuat& RotOffset,
 		USkeletalMeshComponent* SkelMesh,
-		PIDController3D& PIDController,
+		AMCHand* Hand,
+		FMCPIDController3& PIDController,
+		const EMCLinearControl LinearControl,
 		const float DeltaTime);
 
+	// Set the controller gains for the linear control strategy
+	void SetupLinearController(FMCPIDController3& PIDController, const EMCLinearControl LinearControl);
+
+	// Physics scene step callback, marks the physics step start
+	void OnPhysSceneStep(FPhysScene* PhysScene, uint32 SceneType, float DeltaTime);
+
+	// Apply the active quality tier of the frame budget governor
+	void ApplyQualityTier();
+
+	// Set the fixed engine time step, the physics substeps, and the random seed, load the input recording
+	void SetupDeterministicMode();
+
+	// Restore the engine time step and the physics substep settings changed by the deterministic mode
+	void RestoreTimingSettings();
+
+	// Get the absolute input recording file path
+	FString GetInputRecordingPath() const;
+
+	// Advance one fixed simulation step using the latched (or replayed) input
+	void StepSimulation(const float StepDeltaTime);
+
+	// Apply the input frame of a simulation step in a fixed order
+	void ApplyInputFrame(const FMCInputFrame& InputFrame, const float StepDeltaTime);
+
+	// Move both hands towards their motion controller targets
+	void UpdateHands(const float DeltaTime);
+
+	// Copy the newest shared memory tracker sample to the motion controllers and the grasp input
+	void ApplySharedPoses();
+
+	// Resample the glove streams and drive the finger joints of the hands
+	void UpdateGloves(const float DeltaTime);
+
+	// Spawn a hand for the character at the motion controller
+	AMCHand* SpawnHand(TSubclassOf<AMCHand> InHandClass, UMotionControllerComponent* MC);
+
+	// Check if the character belongs to another user, its hands are rendered from the replicated states
+	bool IsRemoteCharacter() const;
+
+	// Quantize the current state of a hand
+	void GetHandNetState(AMCHand* Hand, FMCHandNetState& OutState) const;
+
+	// Send the hand states at the send rate (server RPC, or replicated directly from the server)
+	void SendHandStates(const float DeltaTime);
+
+	// Count the sent hand state payload
+	void UpdateHandNetStats(const float DeltaTime);
+
+	// Render the hands from the interpolated replicated states
+	void UpdateRemoteHands(const float DeltaTime);
+
+	// Receive the hand states of the owning user
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerUpdateHands(const FMCHandNetState& InLeftState, const FMCHandNetState& InRightState);
+
+	// Left hand state received
+	UFUNCTION()
+	void OnRep_LeftHandNetState();
+
+	// Right hand state received
+	UFUNCTION()
+	void OnRep_RightHandNetState();
+
+	// Get the absolute path of a glove recording file
+	FString GetGloveRecordingPath(const FString& InGloveRecordingFile) const;
+
+	// Copy a shared memory hand pose to its motion controller, returns the mean finger curl (negative if none)
+	float ApplySharedHandPose(const FMCSharedHandPose& HandPose, UMotionControllerComponent* MC);
+
+	// Add the trajectory columns of a hand (prefixed)
+	void AddHandTrajectoryColumns(AMCHand* Hand, const FString& Prefix);
+
+	// Copy the current hand, target and object poses into the next trajectory row
+	void ExportTrajectorySample(const float DeltaTime);
+
+	// Copy the values of a hand into the trajectory row, returns the next column
+	int32 WriteHandTrajectory(uint32* Row, int32 Column, AMCHand* Hand, UMotionControllerComponent* MC) const;
+
+	// Try fixation grasp with the hand, or two hands fixation grasp with the other hand
+	void ApplyFixationGrasp(AMCHand* Hand, AMCHand* InOtherHand);
+
 	// Switch the current grasping style
 	void SwitchGrasp();
 
@@ -133,10 +443,10 @@ protected:
 	UArrowComponent* RightTargetArrow;
 
 	// Left hand controller
-	PIDController3D LeftPIDController;
+	FMCPIDController3 LeftPIDController;
 
 	// Right hand controller
-	PIDController3D RightPIDController;
+	FMCPIDController3 RightPIDController;
 
 	// Left MC hand // TODO look into delegates to avoid dynamic casting
 	AMCHand* LeftHand;
@@ -149,4 +459,99 @@ protected:
 
 	// Offset to add to the hand in order to tracked in the selected position (world rotation at start time)
 	FQuat RightHandRotationOffset;
+
+	// Tick function measuring the physics step
+	FMCCharacterPostPhysicsTickFunction PostPhysicsTickFunction;
+
+	// Physics scene step delegate handle
+	FDelegateHandle PhysSceneStepHandle;
+
+	// Frames since the last hand controller update
+	int32 ControllerUpdateFrames;
+
+	// Time accumulated since the last hand controller update
+	float ControllerUpdateDeltaTime;
+
+	// Length of one simulation step in deterministic mode
+	float FixedStepDeltaTime;
+
+	// Number of simulation steps advanced in deterministic mode
+	int32 SimulationStep;
+
+	// Flag showing that the engine timing settings have been saved (and have to be restored)
+	bool bTimingSettingsSaved;
+
+	// Engine fixed time step flag before the deterministic mode
+	bool bSavedUseFixedTimeStep;
+
+	// Engine fixed delta time before the deterministic mode
+	double SavedFixedDeltaTime;
+
+	// Physics substepping flag before the deterministic mode
+	bool bSavedSubstepping;
+
+	// Maximum physics substeps before the deterministic mode
+	int32 SavedMaxSubsteps;
+
+	// Maximum physics substep delta time before the deterministic mode
+	float SavedMaxSubstepDeltaTime;
+
+	// Maximum physics delta time before the deterministic mode
+	float SavedMaxPhysicsDeltaTime;
+
+	// Input latched since the last simulation step
+	FMCInputFrame PendingInput;
+
+	// Recorded or replayed input
+	FMCInputRecording InputRecording;
+
+	// Trajectory file writer
+	TSharedPtr<FMCTrajectoryExporter> TrajectoryExporter;
+
+	// Number of exported trajectory samples
+	int32 TrajectorySample;
+
+	// Simulation time of the exported trajectory samples
+	float TrajectoryTime;
+
+	// Shared memory tracker pose reader
+	FMCSharedPoseRing SharedPoseRing;
+
+	// Time since the last attempt of opening the shared memory region
+	float SharedPoseOpenDeltaTime;
+
+	// Replicated left hand state
+	UPROPERTY(ReplicatedUsing = OnRep_LeftHandNetState)
+	FMCHandReplicatedState LeftHandNetState;
+
+	// Replicated right hand state
+	UPROPERTY(ReplicatedUsing = OnRep_RightHandNetState)
+	FMCHandReplicatedState RightHandNetState;
+
+	// Received left hand states
+	FMCHandInterpolationBuffer LeftHandBuffer;
+
+	// Received right hand states
+	FMCHandInterpolationBuffer RightHandBuffer;
+
+	// Flag showing that the hands are rendered from the replicated states
+	bool bRemoteHandsEnabled;
+
+	// Flag showing that the hands have been spawned by the character
+	bool bSpawnedHands;
+
+	// Time since the last sent hand states
+	float HandNetSendDeltaTime;
+
+	// Sent hand state payload (bits)
+	uint64 HandNetBits;
+
+	// Time the hand state payload has been counted
+	float HandNetTime;
+
+	// Left glove joint angle stream
+	FMCGloveStream LeftGloveStream;
+
+	// Right glove joint angle stream
+	FMCGloveStream RightGloveStream;
 };
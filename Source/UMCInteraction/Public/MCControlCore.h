@@ -0,0 +1,212 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+// Engine independent hand control math (no engine includes), used by the plugin through
+// FMCControlAdapter and built standalone by Tools/MCControlBench
+#include <cmath>
+
+/** 3D vector */
+struct FMCVec3
+{
+	float X, Y, Z;
+
+	FMCVec3() : X(0.f), Y(0.f), Z(0.f) {}
+	FMCVec3(const float InX, const float InY, const float InZ) : X(InX), Y(InY), Z(InZ) {}
+
+	FMCVec3 operator+(const FMCVec3& V) const { return FMCVec3(X + V.X, Y + V.Y, Z + V.Z); }
+	FMCVec3 operator-(const FMCVec3& V) const { return FMCVec3(X - V.X, Y - V.Y, Z - V.Z); }
+	FMCVec3 operator*(const float S) const { return FMCVec3(X * S, Y * S, Z * S); }
+	FMCVec3 operator/(const float S) const { return FMCVec3(X / S, Y / S, Z / S); }
+	FMCVec3& operator+=(const FMCVec3& V) { X += V.X; Y += V.Y; Z += V.Z; return *this; }
+	float Dot(const FMCVec3& V) const { return X * V.X + Y * V.Y + Z * V.Z; }
+	FMCVec3 Cross(const FMCVec3& V) const { return FMCVec3(Y * V.Z - Z * V.Y, Z * V.X - X * V.Z, X * V.Y - Y * V.X); }
+	float Size() const { return std::sqrt(X * X + Y * Y + Z * Z); }
+	bool ContainsNaN() const { return std::isnan(X) || std::isnan(Y) || std::isnan(Z); }
+};
+
+/** Rotation quaternion, same convention as the engine (A * B applies B first) */
+struct FMCQuat
+{
+	float X, Y, Z, W;
+
+	FMCQuat() : X(0.f), Y(0.f), Z(0.f), W(1.f) {}
+	FMCQuat(const float InX, const float InY, const float InZ, const float InW) : X(InX), Y(InY), Z(InZ), W(InW) {}
+
+	FMCQuat operator*(const FMCQuat& Q) const
+	{
+		return FMCQuat(
+			W * Q.X + X * Q.W + Y * Q.Z - Z * Q.Y,
+			W * Q.Y - X * Q.Z + Y * Q.W + Z * Q.X,
+			W * Q.Z + X * Q.Y - Y * Q.X + Z * Q.W,
+			W * Q.W - X * Q.X - Y * Q.Y - Z * Q.Z);
+	}
+	FMCQuat operator-() const { return FMCQuat(-X, -Y, -Z, -W); }
+	float Dot(const FMCQuat& Q) const { return X * Q.X + Y * Q.Y + Z * Q.Z + W * Q.W; }
+
+	// Inverse of a unit quaternion
+	FMCQuat Inverse() const { return FMCQuat(-X, -Y, -Z, W); }
+
+	FMCQuat GetNormalized() const
+	{
+		const float Size = std::sqrt(X * X + Y * Y + Z * Z + W * W);
+		return Size > 1e-8f ? FMCQuat(X / Size, Y / Size, Z / Size, W / Size) : FMCQuat();
+	}
+};
+
+namespace MCControl
+{
+	// Clamp every component of the vector between the limits
+	inline FMCVec3 Clamp(const FMCVec3& V, const float Min, const float Max)
+	{
+		return FMCVec3(
+			V.X < Min ? Min : (V.X > Max ? Max : V.X),
+			V.Y < Min ? Min : (V.Y > Max ? Max : V.Y),
+			V.Z < Min ? Min : (V.Z > Max ? Max : V.Z));
+	}
+
+	// Rotation from the current to the target orientation, taking the short path around the sphere
+	inline FMCQuat ShortestPathError(const FMCQuat& Target, FMCQuat Current)
+	{
+		// Dot product to get cos theta
+		if (Target.Dot(Current) < 0.f)
+		{
+			Current = -Current;
+		}
+		return Target * Current.Inverse();
+	}
+
+	// Vector (xyz) part of the shortest path rotation error, sin(angle / 2) * axis
+	inline FMCVec3 RotationErrorVector(const FMCQuat& Target, const FMCQuat& Current)
+	{
+		const FMCQuat Error = ShortestPathError(Target, Current);
+		return FMCVec3(Error.X, Error.Y, Error.Z);
+	}
+
+	// Extrapolate a location with a constant velocity
+	inline FMCVec3 PredictLocation(const FMCVec3& Location, const FMCVec3& Velocity, const float DeltaTime)
+	{
+		return Location + Velocity * DeltaTime;
+	}
+
+	// Extrapolate a rotation with a constant angular velocity (rad/s)
+	inline FMCQuat PredictRotation(const FMCQuat& Rotation, const FMCVec3& AngularVelocity, const float DeltaTime)
+	{
+		const float Rate = AngularVelocity.Size();
+		const float HalfAngle = 0.5f * Rate * DeltaTime;
+		if (Rate < 1e-6f)
+		{
+			return Rotation;
+		}
+		const FMCVec3 Axis = AngularVelocity / Rate;
+		const float S = std::sin(HalfAngle);
+		return (FMCQuat(Axis.X * S, Axis.Y * S, Axis.Z * S, std::cos(HalfAngle)) * Rotation).GetNormalized();
+	}
+}
+
+/**
+* PID controller of a 3D error (per component gains and output limits)
+*/
+struct FMCPIDController3
+{
+	// Default constructor
+	FMCPIDController3() : P(0.f), I(0.f), D(0.f), MaxOutput(0.f), MinOutput(0.f) {}
+
+	// Set the gains and the output limits, resets the state
+	void SetValues(const float InP, const float InI, const float InD, const float InMaxOutput, const float InMinOutput)
+	{
+		P = InP;
+		I = InI;
+		D = InD;
+		MaxOutput = InMaxOutput;
+		MinOutput = InMinOutput;
+		Reset();
+	}
+
+	// Reset the error history
+	void Reset()
+	{
+		PrevError = FMCVec3();
+		IntegralError = FMCVec3();
+	}
+
+	// Proportional, integral and derivative output
+	FMCVec3 UpdateAsPID(const FMCVec3& Error, const float DeltaTime)
+	{
+		if (DeltaTime <= 0.f || Error.ContainsNaN())
+		{
+			return FMCVec3();
+		}
+		IntegralError += Error * DeltaTime;
+		const FMCVec3 Output = Error * P + IntegralError * I + (Error - PrevError) * (D / DeltaTime);
+		PrevError = Error;
+		return MCControl::Clamp(Output, MinOutput, MaxOutput);
+	}
+
+	// Proportional and derivative output
+	FMCVec3 UpdateAsPD(const FMCVec3& Error, const float DeltaTime)
+	{
+		if (DeltaTime <= 0.f || Error.ContainsNaN())
+		{
+			return FMCVec3();
+		}
+		const FMCVec3 Output = Error * P + (Error - PrevError) * (D / DeltaTime);
+		PrevError = Error;
+		return MCControl::Clamp(Output, MinOutput, MaxOutput);
+	}
+
+	// Proportional output
+	FMCVec3 UpdateAsP(const FMCVec3& Error) const
+	{
+		return Error.ContainsNaN() ? FMCVec3() : MCControl::Clamp(Error * P, MinOutput, MaxOutput);
+	}
+
+	// Gains
+	float P, I, D;
+
+	// Output limits (per component)
+	float MaxOutput, MinOutput;
+
+	// Error of the previous update
+	FMCVec3 PrevError;
+
+	// Accumulated error
+	FMCVec3 IntegralError;
+};
+
+namespace MCControl
+{
+	// Linear hand control strategies
+	enum ELinearStrategy
+	{
+		// PD output applied as acceleration to every body
+		LinearForcePD = 0,
+		// P output set as the velocity of every body
+		LinearVelocityP = 1,
+		// P output minus the current velocity applied as velocity change to every body (keeps the relative body velocities)
+		LinearImpulse = 2
+	};
+
+	// Linear controller output of the strategy: acceleration (force PD), velocity (velocity P), or velocity change (impulse)
+	inline FMCVec3 UpdateLinear(FMCPIDController3& Controller, const ELinearStrategy Strategy,
+		const FMCVec3& Error, const FMCVec3& Velocity, const float DeltaTime)
+	{
+		switch (Strategy)
+		{
+		case LinearVelocityP:
+			return Controller.UpdateAsP(Error);
+		case LinearImpulse:
+			return Clamp(Controller.UpdateAsP(Error) - Velocity, Controller.MinOutput, Controller.MaxOutput);
+		default:
+			return Controller.UpdateAsPD(Error, DeltaTime);
+		}
+	}
+
+	// Force of the mass scheduled force PD strategy on one body, the gains are tuned as accelerations and scaled with
+	// the body mass (including a welded carried object), the closed loop response does not depend on the load
+	inline FMCVec3 ScheduleForce(const FMCVec3& Acceleration, const FMCVec3& FeedforwardAcceleration, const float Mass)
+	{
+		return (Acceleration + FeedforwardAcceleration) * Mass;
+	}
+}
@@ -0,0 +1,55 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MCEpisodeRunner.h"
+#include "MCEpisodeOrchestratorCommandlet.generated.h"
+
+/**
+* Shards an episode list across headless worker processes (one per core) running UMCEpisodeRunner,
+* then merges the worker outputs into one dataset: the episode directories, one semantic event log and one trajectory
+* of all episodes, and an index with the record and row range of every episode:
+* -run=MCEpisodeOrchestrator -MCEpisodes=<Episodes.json> [-Workers=<N>] [-WorkerTimeout=<s>] [-MCOutput=<Dir>] [-MergeOnly]
+* The project GameInstanceClass must be UMCEpisodeRunner (or a child), workers over the timeout (7200 s, 0 for none) are terminated
+*/
+UCLASS()
+class UMCINTERACTION_API UMCEpisodeOrchestratorCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values
+	UMCEpisodeOrchestratorCommandlet();
+
+	// Run the orchestrator
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	// Split the episodes into shards of similar total input length
+	static void ShardEpisodes(const TArray<FMCEpisode>& Episodes, const int32 NumShards, TArray<TArray<FMCEpisode>>& OutShards);
+
+	// Launch the workers and wait for them to finish, returns the number of failed workers
+	int32 RunWorkers(const TArray<FString>& ShardFiles);
+
+	// Move the worker episode outputs into the dataset directory, merge their logs and write its index
+	bool MergeWorkerOutputs(const int32 NumWorkers);
+
+	// Concatenate the episode semantic event logs, outputs the first record and the number of records of every episode
+	static bool MergeSemanticLogs(const TArray<FString>& EpisodeDirectories, const FString& OutFilename,
+		TArray<TPair<uint64, uint64>>& OutRecordRanges);
+
+	// Check if the project game instance (the one the workers start with) is the episode runner
+	bool IsEpisodeRunnerGameInstance() const;
+
+	// Output directory of a worker
+	FString GetWorkerDirectory(const int32 WorkerIdx) const;
+
+	// Root output directory
+	FString OutputDirectory;
+
+	// Time (s) after which the still running workers are terminated (0 for no timeout)
+	float WorkerTimeout;
+};
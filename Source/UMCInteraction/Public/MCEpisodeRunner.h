@@ -0,0 +1,129 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/GameInstance.h"
+#include "Engine/EngineBaseTypes.h"
+#include "MCEpisodeRunner.generated.h"
+
+class AMCCharacter;
+
+/**
+* Episode to run, a level and the input replayed by its character
+*/
+struct FMCEpisode
+{
+	// Episode name, also the name of its output directory
+	FString Name;
+
+	// Level to load
+	FString Map;
+
+	// Input recording replayed by the character
+	FString InputRecordingFile;
+
+	// Maximum number of simulation steps (0 for the whole recording)
+	int32 MaxSteps;
+};
+
+/**
+* Game instance running a queue of episodes one after another, as fast as the CPU allows,
+* run headless with: -game -nullrhi -unattended -nosound -MCEpisodes=<Episodes.json> [-MCOutput=<Dir>] [-MCCoreMask=<hex>]
+* [-MCLoadTimeout=<s>]
+*/
+UCLASS()
+class UMCINTERACTION_API UMCEpisodeRunner : public UGameInstance
+{
+	GENERATED_BODY()
+
+public:
+	// Load the episode queue from the command line
+	virtual void Init() override;
+
+	// Stop running episodes
+	virtual void Shutdown() override;
+
+	// Load the episode queue from a json file
+	bool LoadEpisodes(const FString& Filename);
+
+	// Read episodes from a json file, input paths are made absolute
+	static bool ReadEpisodesFile(const FString& Filename, TArray<FMCEpisode>& OutEpisodes);
+
+	// Write episodes to a json file
+	static bool WriteEpisodesFile(const FString& Filename, const TArray<FMCEpisode>& Episodes);
+
+protected:
+	// Run the episodes, called every frame
+	bool RunnerTick(float DeltaTime);
+
+	// Episode level loaded, start replaying the input
+	void OnPostLoadMap(UWorld* LoadedWorld);
+
+	// Episode level could not be loaded
+	void OnTravelFailure(UWorld* InWorld, ETravelFailure::Type FailureType, const FString& ErrorString);
+
+	// Episode level could not be loaded (connection to the level failed)
+	void OnNetworkFailure(UWorld* InWorld, UNetDriver* NetDriver, ENetworkFailure::Type FailureType, const FString& ErrorString);
+
+	// Load the level of the next episode, or exit if none left
+	void StartNextEpisode();
+
+	// Write the metrics of the finished episode
+	void FinishEpisode();
+
+	// Mark the current episode as skipped and continue with the next one
+	void SkipEpisode(const FString& Reason);
+
+	// Directory of the episode output
+	FString GetEpisodeDirectory(const FMCEpisode& Episode) const;
+
+private:
+	// Episodes left to run
+	TArray<FMCEpisode> EpisodeQueue;
+
+	// Episode currently loading or running
+	FMCEpisode CurrentEpisode;
+
+	// Character replaying the input of the current episode
+	TWeakObjectPtr<AMCCharacter> EpisodeCharacter;
+
+	// Root output directory
+	FString OutputDirectory;
+
+	// Wall clock time at the episode start
+	double EpisodeStartTime;
+
+	// Number of episodes run
+	int32 NumEpisodesRun;
+
+	// Number of episodes skipped
+	int32 NumEpisodesSkipped;
+
+	// Wall clock time the episode level started loading
+	double LoadStartTime;
+
+	// Wall clock time (s) after which a level that has not been loaded is skipped
+	float LoadTimeout;
+
+	// Runner state
+	enum class ERunnerState : uint8
+	{
+		Idle,
+		Loading,
+		Running
+	} State;
+
+	// Ticker delegate handle
+	FDelegateHandle TickerHandle;
+
+	// Post load map delegate handle
+	FDelegateHandle PostLoadMapHandle;
+
+	// Travel failure delegate handle
+	FDelegateHandle TravelFailureHandle;
+
+	// Network failure delegate handle
+	FDelegateHandle NetworkFailureHandle;
+};
@@ -0,0 +1,155 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MCFrameBudgetGovernor.generated.h"
+
+/**
+* Hand simulation fidelity settings of one quality tier
+*/
+USTRUCT()
+struct FMCQualityTier
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Default constructor
+	FMCQualityTier() :
+		ControllerUpdateInterval(1),
+		FingerDriveUpdateInterval(1)
+	{}
+
+	// Constructor with initialization
+	FMCQualityTier(const int32 InControllerUpdateInterval, const int32 InFingerDriveUpdateInterval) :
+		ControllerUpdateInterval(InControllerUpdateInterval),
+		FingerDriveUpdateInterval(InFingerDriveUpdateInterval)
+	{}
+
+	// Number of frames between two hand controller updates
+	UPROPERTY(EditAnywhere, Category = "Tier", meta = (ClampMin = 1))
+	int32 ControllerUpdateInterval;
+
+	// Number of frames between two finger drive target updates
+	UPROPERTY(EditAnywhere, Category = "Tier", meta = (ClampMin = 1))
+	int32 FingerDriveUpdateInterval;
+};
+
+/**
+* Measures the plugin cost and the physics step time every frame,
+* and steps down (or up) through the quality tiers to keep the frame budget
+*/
+USTRUCT()
+struct UMCINTERACTION_API FMCFrameBudgetGovernor
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Default constructor
+	FMCFrameBudgetGovernor();
+
+	// Enable the governor
+	UPROPERTY(EditAnywhere, Category = "Budget")
+	bool bEnabled;
+
+	// Frame budget (ms), 11.1 ms at 90 Hz
+	UPROPERTY(EditAnywhere, Category = "Budget", meta = (ClampMin = 0))
+	float FrameBudgetMs;
+
+	// Share of the frame budget (ms) for the plugin cost and the physics step
+	UPROPERTY(EditAnywhere, Category = "Budget", meta = (ClampMin = 0))
+	float HandSimulationBudgetMs;
+
+	// Step back up only if the measured times are below this ratio of the budgets
+	UPROPERTY(EditAnywhere, Category = "Budget", meta = (ClampMin = 0, ClampMax = 1))
+	float HeadroomRatio;
+
+	// Consecutive over budget frames before stepping down a tier
+	UPROPERTY(EditAnywhere, Category = "Budget", meta = (ClampMin = 1))
+	int32 StepDownFrames;
+
+	// Consecutive frames with headroom before stepping up a tier
+	UPROPERTY(EditAnywhere, Category = "Budget", meta = (ClampMin = 1))
+	int32 StepUpFrames;
+
+	// Exponential smoothing factor of the measured times
+	UPROPERTY(EditAnywhere, Category = "Budget", meta = (ClampMin = 0, ClampMax = 1))
+	float SmoothingFactor;
+
+	// Quality tiers, from the highest fidelity (first) to the lowest (last)
+	UPROPERTY(EditAnywhere, Category = "Budget")
+	TArray<FMCQualityTier> Tiers;
+
+	// Reset the measurements and start at the highest tier
+	void Init();
+
+	// Add plugin work measured during the current frame
+	void AddPluginCycles(const uint32 Cycles) { PluginCycles += Cycles; };
+
+	// Mark the start of the physics step of the current frame (can be called multiple times when substepping)
+	void MarkPhysicsStepStart(const uint32 Cycles);
+
+	// Mark the physics results as available, returns true if the quality tier changed
+	bool MarkPhysicsStepEnd(const uint32 Cycles);
+
+	// Get the active quality tier (full fidelity defaults if there are no tiers)
+	const FMCQualityTier& GetActiveTier() const;
+
+	// Get the index of the active quality tier
+	int32 GetActiveTierIndex() const { return ActiveTierIndex; };
+
+private:
+	// Compare the smoothed times against the budgets, returns true if the tier changed
+	bool UpdateTier();
+
+	// Index of the currently active tier
+	int32 ActiveTierIndex;
+
+	// Plugin cycles of the current frame
+	uint32 PluginCycles;
+
+	// Cycle stamp of the physics step start of the current frame (0 if not started)
+	volatile int32 PhysicsStartCycles;
+
+	// Cycle stamp of the previous physics step end (frame time measurement)
+	uint32 LastFrameEndCycles;
+
+	// Smoothed frame time (ms)
+	float SmoothedFrameMs;
+
+	// Smoothed plugin cost (ms)
+	float SmoothedPluginMs;
+
+	// Smoothed physics step time (ms)
+	float SmoothedPhysicsMs;
+
+	// Number of consecutive frames over budget
+	int32 OverBudgetFrames;
+
+	// Number of consecutive frames with headroom
+	int32 HeadroomFrames;
+};
+
+/**
+* Adds the cycles spent in the enclosing scope to the governor plugin cost
+*/
+struct FMCScopedPluginCost
+{
+	// Start measuring
+	FMCScopedPluginCost(FMCFrameBudgetGovernor& InGovernor) :
+		Governor(InGovernor),
+		StartCycles(FPlatformTime::Cycles())
+	{}
+
+	// Stop measuring
+	~FMCScopedPluginCost()
+	{
+		Governor.AddPluginCycles(FPlatformTime::Cycles() - StartCycles);
+	}
+
+private:
+	// Governor to report to
+	FMCFrameBudgetGovernor& Governor;
+
+	// Cycle stamp at scope start
+	const uint32 StartCycles;
+};
@@ -0,0 +1,143 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Containers/Queue.h"
+#include "MCFinger.h"
+
+/** Glove input constants */
+enum
+{
+	MC_GLOVE_HISTORY_SIZE = 16,
+	MC_NUM_GLOVE_ANGLES = MC_NUM_HAND_JOINTS * 3
+};
+
+/**
+* Per-joint angles of one data glove sample
+*/
+struct FMCGloveFrame
+{
+	// Default constructor
+	FMCGloveFrame() : Timestamp(0.0)
+	{
+		FMemory::Memzero(JointAngles);
+	}
+
+	// Device time (s)
+	double Timestamp;
+
+	// Swing 1, swing 2 and twist (radians) of every joint, same layout as AMCHand::GetJointAngles
+	float JointAngles[MC_NUM_GLOVE_ANGLES];
+
+	// Serialize the frame
+	friend FArchive& operator<<(FArchive& Ar, FMCGloveFrame& Frame)
+	{
+		Ar << Frame.Timestamp;
+		for (int32 AngleIdx = 0; AngleIdx < MC_NUM_GLOVE_ANGLES; ++AngleIdx)
+		{
+			Ar << Frame.JointAngles[AngleIdx];
+		}
+		return Ar;
+	}
+};
+
+/**
+* Glove frames in the order they were received
+*/
+struct UMCINTERACTION_API FMCGloveRecording
+{
+	// Received frames
+	TArray<FMCGloveFrame> Frames;
+
+	// Write the recording to a binary file
+	bool SaveToFile(const FString& Filename) const;
+
+	// Read the recording from a binary file
+	bool LoadFromFile(const FString& Filename);
+};
+
+/**
+* High-rate joint angle stream of one glove, the frames are low-pass filtered at the glove rate
+* and resampled once per simulation step at a fixed delay behind the newest frame
+*
+* The device (or the replay) is the single producer, the game thread the single consumer
+*/
+class UMCINTERACTION_API FMCGloveStream
+{
+public:
+	// Constructor
+	FMCGloveStream();
+
+	// Set the filter cutoff (Hz, 0 disables the filter) and the resampling delay (s), clears the received frames
+	void Init(const float InFilterCutoffHz, const float InResampleDelay);
+
+	// Add a frame received from the device (producer thread)
+	void AddFrame(const FMCGloveFrame& Frame);
+
+	// Filter the new frames and interpolate the angles at the resampling time, returns false if there was no new frame
+	bool Resample(float* OutJointAngles);
+
+	// Keep the received frames for saving them
+	void StartRecording();
+
+	// Write the received frames to file
+	bool SaveRecording(const FString& Filename) const;
+
+	// Replace the device with a recording, the frames are added as the replay time advances
+	bool StartReplay(const FString& Filename);
+
+	// Advance the replay time, adds the frames recorded up to it
+	void AdvanceReplay(const float DeltaTime);
+
+	// Check if the recorded frames are replayed
+	bool IsReplaying() const { return bReplaying; };
+
+	// Check if all the recorded frames have been replayed
+	bool IsReplayFinished() const { return bReplaying && ReplayIndex >= Recording.Frames.Num(); };
+
+private:
+	// Low-pass filter the frame against the previous filtered frame and add it to the history
+	void AddFilteredFrame(const FMCGloveFrame& Frame);
+
+	// Get a filtered frame, 0 is the newest
+	const FMCGloveFrame& GetFilteredFrame(const int32 Age) const
+	{
+		checkSlow(Age >= 0 && Age < NumFiltered);
+		return Filtered[(Head - Age + MC_GLOVE_HISTORY_SIZE) % MC_GLOVE_HISTORY_SIZE];
+	};
+
+	// Frames received since the last resampling
+	TQueue<FMCGloveFrame, EQueueMode::Spsc> PendingFrames;
+
+	// Filtered frames
+	FMCGloveFrame Filtered[MC_GLOVE_HISTORY_SIZE];
+
+	// Index of the newest filtered frame
+	int32 Head;
+
+	// Number of filtered frames
+	int32 NumFiltered;
+
+	// Low-pass filter cutoff frequency (Hz)
+	float FilterCutoffHz;
+
+	// Resampling time behind the newest frame (s), the angles are interpolated instead of extrapolated
+	float ResampleDelay;
+
+	// Recorded or replayed frames
+	FMCGloveRecording Recording;
+
+	// Flag showing that the received frames are recorded
+	bool bRecording;
+
+	// Flag showing that the recording replaces the device
+	bool bReplaying;
+
+	// Next replayed frame
+	int32 ReplayIndex;
+
+	// Time since the replay start
+	double ReplayTime;
+};
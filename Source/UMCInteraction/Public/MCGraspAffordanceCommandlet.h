@@ -0,0 +1,30 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MCGraspAffordances.h"
+#include "MCGraspAffordanceCommandlet.generated.h"
+
+/**
+* Computes the grasp affordances of the static meshes and saves them with the meshes:
+* -run=MCGraspAffordance [-Path=/Game] [-MaxHandAperture=<cm>] [-MaxTwoHandsLength=<cm>] [-Slices=<N>]
+*/
+UCLASS()
+class UMCINTERACTION_API UMCGraspAffordanceCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values
+	UMCGraspAffordanceCommandlet();
+
+	// Run the affordance generation
+	virtual int32 Main(const FString& Params) override;
+
+	// Compute the affordances from the mesh vertices (mesh space)
+	static void ComputeAffordances(const TArray<FVector>& Vertices, const float MaxHandAperture,
+		const float MaxTwoHandsLength, const int32 NumSlices, TArray<FMCGraspAffordance>& OutAffordances);
+};
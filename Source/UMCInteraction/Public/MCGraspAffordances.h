@@ -0,0 +1,77 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/AssetUserData.h"
+#include "MCGraspAffordances.generated.h"
+
+class UStaticMesh;
+
+/**
+* Grasp affordance of a static mesh (mesh space)
+*/
+USTRUCT()
+struct FMCGraspAffordance
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Default constructor
+	FMCGraspAffordance() :
+		Location(FVector::ZeroVector),
+		ApproachAxis(FVector::ForwardVector),
+		Width(0.f),
+		NumHands(1)
+	{}
+
+	// Grasp point, the palm center is placed here
+	UPROPERTY(VisibleAnywhere, Category = "Affordance")
+	FVector Location;
+
+	// Direction the palm moves in towards the grasp point
+	UPROPERTY(VisibleAnywhere, Category = "Affordance")
+	FVector ApproachAxis;
+
+	// Width (cm) the hand has to close around
+	UPROPERTY(VisibleAnywhere, Category = "Affordance")
+	float Width;
+
+	// Number of hands needed (1 or 2)
+	UPROPERTY(VisibleAnywhere, Category = "Affordance")
+	int32 NumHands;
+};
+
+/**
+* Precomputed grasp affordances of a static mesh, stored as user data of the mesh asset
+* (generated offline with -run=MCGraspAffordance, no geometry analysis at runtime)
+*/
+UCLASS()
+class UMCINTERACTION_API UMCGraspAffordances : public UAssetUserData
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values
+	UMCGraspAffordances();
+
+	// Get the affordances of a mesh (nullptr if not generated)
+	static UMCGraspAffordances* Get(UStaticMesh* InMesh);
+
+	// Find the affordance closest to the palm (mesh space), the distance is traded against the approach alignment,
+	// returns INDEX_NONE if there is no affordance for the number of hands
+	int32 FindNearest(const FVector& PalmLocation, const FVector& PalmApproachAxis, const int32 InNumHands,
+		const float AlignmentWeight, float* OutScore = nullptr) const;
+
+	// Grasp affordances
+	UPROPERTY(VisibleAnywhere, Category = "MC|Affordances")
+	TArray<FMCGraspAffordance> Affordances;
+
+	// At least one affordance can be grasped with one hand
+	UPROPERTY(VisibleAnywhere, Category = "MC|Affordances")
+	bool bOneHandGraspable;
+
+	// At least one affordance needs two hands
+	UPROPERTY(VisibleAnywhere, Category = "MC|Affordances")
+	bool bTwoHandsGraspable;
+};
@@ -0,0 +1,57 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "MCFinger.h"
+#include "MCGraspPose.generated.h"
+
+/** Enum indicating the grasp type */
+UENUM(BlueprintType)
+enum class EMCGraspType : uint8
+{
+	Open		UMETA(DisplayName = "Open"),
+	Power		UMETA(DisplayName = "Power"),
+	Pinch		UMETA(DisplayName = "Pinch"),
+	Tripod		UMETA(DisplayName = "Tripod"),
+	Lateral		UMETA(DisplayName = "Lateral")
+};
+
+/**
+* Grasp pose, finger constraint orientation targets indexed by finger and part
+* (see FMCFinger::GetJointIndex)
+*/
+UCLASS()
+class UMCINTERACTION_API UMCGraspPose : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values
+	UMCGraspPose();
+
+	// Grasp type of the pose
+	UPROPERTY(EditAnywhere, Category = "MC|Grasp")
+	EMCGraspType GraspType;
+
+	// Orientation targets of the finger constraints
+	UPROPERTY(EditAnywhere, EditFixedSize, Category = "MC|Grasp")
+	TArray<FQuat> JointTargets;
+
+	// Check if the pose has a target for every hand joint
+	bool IsValidPose() const { return JointTargets.Num() == MC_NUM_HAND_JOINTS; };
+
+	// Make sure the table is fully sized after loading
+	virtual void PostLoad() override;
+
+#if WITH_EDITOR
+	// Keep the table fully sized when edited
+	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif // WITH_EDITOR
+
+private:
+	// Resize the table to the number of hand joints, new targets are identity
+	void ResizeJointTargets();
+};
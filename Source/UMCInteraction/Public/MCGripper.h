@@ -0,0 +1,89 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MCHand.h"
+#include "MCGripper.generated.h"
+
+/** Enum indicating how the gripper jaws move relative to the palm */
+UENUM(BlueprintType)
+enum class EMCGripperJawType : uint8
+{
+	Prismatic		UMETA(DisplayName = "Prismatic"),
+	Revolute		UMETA(DisplayName = "Revolute")
+};
+
+/**
+ * Parallel jaw gripper, a palm and two driven jaws, uses the grasp, fixation grasp
+ * and semantic event API of the hand
+ */
+UCLASS()
+class UMCINTERACTION_API AMCGripper : public AMCHand
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor
+	AMCGripper();
+
+	// Move the jaws between the open and the closed position
+	virtual void UpdateGrasp(const float Goal) override;
+
+	// First jaw bone name (the constraint is named after the jaw bone)
+	UPROPERTY(EditAnywhere, Category = "MC|Gripper")
+	FName FirstJawBoneName;
+
+	// Second jaw bone name (the constraint is named after the jaw bone)
+	UPROPERTY(EditAnywhere, Category = "MC|Gripper")
+	FName SecondJawBoneName;
+
+	// Jaw joint type
+	UPROPERTY(EditAnywhere, Category = "MC|Gripper")
+	EMCGripperJawType JawType;
+
+	// The second jaw constraint frame is mirrored, its targets are negated
+	UPROPERTY(EditAnywhere, Category = "MC|Gripper")
+	bool bMirrorSecondJaw;
+
+	// Jaw target when opened (cm along the constraint X axis, or twist degrees)
+	UPROPERTY(EditAnywhere, Category = "MC|Gripper")
+	float JawOpenTarget;
+
+	// Jaw target when closed (cm along the constraint X axis, or twist degrees)
+	UPROPERTY(EditAnywhere, Category = "MC|Gripper")
+	float JawClosedTarget;
+
+	// Jaw drive position strength
+	UPROPERTY(EditAnywhere, Category = "MC|Gripper", meta = (ClampMin = 0))
+	float JawStiffness;
+
+	// Jaw drive velocity strength
+	UPROPERTY(EditAnywhere, Category = "MC|Gripper", meta = (ClampMin = 0))
+	float JawDamping;
+
+	// Limit of the jaw drive force, the jaws stay compliant against the grasped objects (0 is unlimited)
+	UPROPERTY(EditAnywhere, Category = "MC|Gripper", meta = (ClampMin = 0))
+	float JawForceLimit;
+
+protected:
+	// Setup the jaw drives instead of the finger drives
+	virtual void SetupAngularDriveValues(EAngularDriveMode::Type DriveMode) override;
+
+private:
+	// Setup the drive of a jaw constraint
+	bool SetupJawDrive(FConstraintInstance* JawConstraint);
+
+	// Set the target of a jaw constraint
+	void SetJawTarget(FConstraintInstance* JawConstraint, const float Target);
+
+	// First jaw constraint
+	FConstraintInstance* FirstJawConstraint;
+
+	// Second jaw constraint
+	FConstraintInstance* SecondJawConstraint;
+
+	// Last applied grasp goal (negative if none)
+	float LastGoal;
+};
@@ -9,6 +9,13 @@
 #include "Engine/StaticMeshActor.h"
 #include "SLRuntimeManager.h"
 #include "MCFinger.h"
+#include "MCHandTopology.h"
+#include "MCGraspPose.h"
+#include "MCHandRig.h"
+#include "MCSemanticEventLog.h"
+#include "MCKinematicHistory.h"
+#include "MCGraspAffordances.h"
+#include "MCHandNetState.h"
 #include "MCHand.generated.h"
 
 /** Hand grasp constants */
@@ -19,6 +26,95 @@ enum
 	TWO_HANDS_GRASPABLE = 2
 };
 
+/** Hand fixation grasp states */
+enum
+{
+	NOT_GRASPING = 0,
+	ONE_HAND_GRASPING = 1,
+	TWO_HANDS_GRASPING = 2,
+	TWO_HANDS_MIMICKING = 3
+};
+
+/** Original frame and angular limits of a finger constraint, restored when the fingers are unwelded */
+struct FMCJointWeldState
+{
+	// Parent (second) constraint reference frame
+	FTransform ParentFrame;
+
+	// Swing 1 motion and limit (degrees)
+	EAngularConstraintMotion Swing1Motion;
+	float Swing1Limit;
+
+	// Swing 2 motion and limit (degrees)
+	EAngularConstraintMotion Swing2Motion;
+	float Swing2Limit;
+
+	// Twist motion and limit (degrees)
+	EAngularConstraintMotion TwistMotion;
+	float TwistLimit;
+};
+
+/** Distinct contact of a hand joint segment (INDEX_NONE for the palm) with another component */
+struct FMCHandContact
+{
+	// Constructor with initialization
+	FMCHandContact(const UPrimitiveComponent* InComponent, const int32 InJointIdx) :
+		Component(InComponent),
+		JointIdx(InJointIdx)
+	{}
+
+	bool operator==(const FMCHandContact& Other) const
+	{
+		return Component == Other.Component && JointIdx == Other.JointIdx;
+	}
+
+	friend uint32 GetTypeHash(const FMCHandContact& Contact)
+	{
+		return HashCombine(GetTypeHash(Contact.Component), GetTypeHash(Contact.JointIdx));
+	}
+
+	// Touched component (only compared, never dereferenced)
+	const UPrimitiveComponent* Component;
+
+	// Touching joint segment
+	int32 JointIdx;
+};
+
+/** Predicted one hand grasp target, its grasp data is looked up before the grasp is triggered */
+struct FMCGraspIntent
+{
+	// Default constructor
+	FMCGraspIntent() :
+		Object(nullptr),
+		Mass(0.f),
+		bHasAffordance(false),
+		bHasNameIds(false),
+		HandNameId(0),
+		ObjectNameId(0)
+	{}
+
+	// Predicted object (nullptr if none)
+	AStaticMeshActor* Object;
+
+	// Object mass (kg), not available once the object is welded to the hand
+	float Mass;
+
+	// Flag showing that the affordance is set
+	bool bHasAffordance;
+
+	// Nearest affordance to the current palm pose
+	FMCGraspAffordance Affordance;
+
+	// Flag showing that the semantic event log names are set
+	bool bHasNameIds;
+
+	// Semantic event log name index of the hand individual
+	uint32 HandNameId;
+
+	// Semantic event log name index of the object individual
+	uint32 ObjectNameId;
+};
+
 /** Enum indicating the hand type */
 UENUM(BlueprintType)
 enum class EHandType : uint8
@@ -42,11 +138,17 @@ public:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	// Called when the game ends or when destroyed
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// Called every frame
 	virtual void Tick(float DeltaSeconds) override;
 
 	// Update the grasp //TODO state, power, step
-	void UpdateGrasp(const float Goal);
+	virtual void UpdateGrasp(const float Goal);
+
+	// Drive every finger joint to its own angles (swing 1, swing 2 and twist in radians per joint, see GetJointAngles)
+	void UpdateJointTargets(const float* JointAngles);
 
 	// Switch the grasping style
 	void SwitchGrasp();
@@ -54,6 +156,9 @@ public:
 	// Fixation grasp via attachment of the object to the hand
 	bool TryOneHandFixationGrasp();
 
+	// Take over the object fixation grasped by the other hand of the user if it is in reach and no free object is closer, the object stays kinematic
+	bool TryHandoverFixationGrasp();
+
 	// Fixation grasp of two hands attachment
 	bool TryTwoHandsFixationGrasp();
 
@@ -74,11 +179,81 @@ public:
 
 	// Set pointer to other hand, used for two hand fixation grasp
 	void SetOtherHand(AMCHand* InOtherHand);
+
+	// Get the number of grasps started by the hand
+	int32 GetNumGrasps() const { return NumGrasps; };
+
+	// Get the number of objects taken over from other hands
+	int32 GetNumHandovers() const { return NumHandovers; };
+
+	// Get the number of distinct contacts of the hand bodies with other actors
+	int32 GetNumContacts() const { return NumContacts; };
+
+	// Set the number of grasp updates between two finger drive target updates
+	void SetFingerDriveUpdateInterval(const int32 InInterval);
+
+	// Get the fixation grasp state of the hand
+	uint8 GetGraspState() const;
+
+	// Get the fixation grasped object (nullptr if none, or if only mimicking the other hand)
+	AStaticMeshActor* GetGraspedObject() const
+	{
+		return OneHandGraspedObject ? OneHandGraspedObject : TwoHandsGraspedObject;
+	};
+
+	// Write the swing 1, swing 2 and twist angles (radians) of every joint (MC_NUM_HAND_JOINTS * 3 values)
+	void GetJointAngles(float* OutAngles) const;
+
+	// Store the current palm pose and the motion controller target pose in the kinematic history
+	void RecordKinematics(const FTransform& TargetPose);
+
+	// Predict the likely one hand grasp target from the palm approach and stage its grasp data
+	void UpdateGraspIntent();
+
+	// Get the predicted one hand grasp target (nullptr if none)
+	AStaticMeshActor* GetGraspIntentObject() const { return GraspIntent.Object; };
+
+	// Switch the physics asset of the hand (not while grasping), the finger joints are set up again
+	bool SwitchPhysicsAsset(UPhysicsAsset* InPhysicsAsset);
+
+	// Switch between the detailed and the reduced physics asset of the hand rig
+	bool SetUseReducedPhysicsAsset(const bool bReduced);
+
+	// Get the recent palm and target poses
+	const FMCKinematicHistory& GetKinematicHistory() const { return KinematicHistory; };
+
+	// Get the last grasp goal
+	float GetGraspGoal() const { return GraspGoal; };
+
+	// Render the hand of another user from its replicated states, the palm is kinematic and the hand does not interact
+	void EnableRemoteProxy();
+
+	// Move the palm to the replicated pose, drive the fingers and attach the replicated fixation grasped object
+	void ApplyRemotePose(const FMCHandNetPose& InPose);
+
+	// Drop the object no longer grasped in the replicated state, unless another hand took it over
+	// (called after the poses of all hands have been applied)
+	void ReleaseRemoteObject();
+
+	// Check if the hand is rendered from replicated states
+	bool IsRemoteProxy() const { return bRemoteProxy; };
 	
 	// Hand type
 	UPROPERTY(EditAnywhere, Category = "MC|Hand")
 	EHandType HandType;
 
+	// Finger topology of the hand rig, the joint loops are unrolled for it at compile time
+	UPROPERTY(EditAnywhere, Category = "MC|Hand")
+	EMCHandTopology HandTopology;
+
+	// Prebuilt finger constraint mapping and drive parameters, bone names below are used if not set
+	UPROPERTY(EditAnywhere, Category = "MC|Hand")
+	UMCHandRig* HandRig;
+
+	// Start with the reduced physics asset of the hand rig
+	UPROPERTY(EditAnywhere, Category = "MC|Hand")
+	bool bUseReducedPhysicsAsset;
+
 	// Thumb finger skeletal bone names
 	UPROPERTY(EditAnywhere, Category = "MC|Hand")
 	FMCFinger Thumb;
@@ -99,6 +274,14 @@ public:
 	UPROPERTY(EditAnywhere, Category = "MC|Hand")
 	FMCFinger Pinky;
 
+	// Grasp poses to switch between (loaded with the hand), uniform curl if empty
+	UPROPERTY(EditAnywhere, Category = "MC|Grasp")
+	TArray<UMCGraspPose*> GraspPoses;
+
+	// Pose of the opened hand, identity targets if not set
+	UPROPERTY(EditAnywhere, Category = "MC|Grasp")
+	UMCGraspPose* OpenPose;
+
 	// Flag showing that the hand is ready for a two hands grasp
 	bool bReadyForTwoHandsGrasp;
 
@@ -116,6 +299,17 @@ protected:
 	void OnFixationGraspAreaEndOverlap(class UPrimitiveComponent* HitComp, class AActor* OtherActor,
 		class UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
 
+	// Finger segment contact, marks the joint of the segment as touching
+	UFUNCTION()
+	void OnHandHit(UPrimitiveComponent* HitComp, AActor* OtherActor,
+		UPrimitiveComponent* OtherComp, FVector NormalImpulse, const FHitResult& Hit);
+
+	// Setup fingers angular drive values (hand variants set up their own joints)
+	virtual void SetupAngularDriveValues(EAngularDriveMode::Type DriveMode);
+
+	// Last grasp goal
+	float GraspGoal;
+
 private:
 	// Start grasp event
 	bool StartGraspEvent(AActor* OtherActor);
@@ -126,17 +320,77 @@ private:
 	// Check if object is graspable, return the number of hands (0, 1, 2)
 	uint8 CheckObjectGraspableType(AActor* InActor);
 
+	// Blend the finger drive targets between the open and the active grasp pose, skip the frozen joints
+	template<typename TopologyType>
+	void UpdateFingerDrives(const float Goal);
+
 	// Hold grasp in the current position
+	template<typename TopologyType>
 	void MaintainFingerPositions();
 
+	// Set the joint angle targets in one pass over the joints, skip the joints whose target did not change
+	template<typename TopologyType>
+	void ApplyJointTargets(const float* JointAngles);
+
+	// Map the finger segment bones to their joint index (used by the hit callback)
+	void SetupBoneToJointIndex();
+
+	// Read the current orientation of every joint in one pass
+	template<typename TopologyType>
+	void ReadJointOrientations();
+
+	// Forget the contacts of the released joints (bit per joint), they count as new contacts when touching again
+	void ReleaseContacts(const uint32 InJointMask);
+
+	// Freeze the targets of the joints (and their parent joints) at the current orientation
+	template<typename TopologyType>
+	void FreezeJoints(const uint32 InJointMask, const float Goal);
+
+	// Set the drive mode of the joints and mark the joint table entries used by the topology
+	template<typename TopologyType>
+	void SetupJointDrives(const EAngularDriveMode::Type DriveMode);
+
 	// Setup hand default values
 	void SetupHandDefaultValues(EHandType HandType);
 
 	// Setup skeletal mesh default values
 	void SetupSkeletalDefaultValues(USkeletalMeshComponent* InSkeletalMeshComponent);
 
-	// Setup fingers angular drive values
-	void SetupAngularDriveValues(EAngularDriveMode::Type DriveMode);
+	// Apply the collision profile, the fixation grasp area channels, and disable the finger joint collisions
+	void SetupCollision();
+
+	// Lock the finger constraints in their current pose and disable their drives (held grasp)
+	void WeldFingers();
+
+	// Restore the finger constraints articulation, the drives hold the current pose
+	void UnweldFingers();
+
+	// Throw the released object with the filtered palm velocities
+	void ApplyReleaseVelocity(AStaticMeshActor* ReleasedObject) const;
+
+	// Give the one hand grasped object to another hand, it is detached without enabling its physics
+	AStaticMeshActor* ReleaseForHandover();
+
+	// Find the precomputed affordance of the object closest to the palm, returns false if the mesh has none
+	bool FindGraspAffordance(AStaticMeshActor* InObject, const int32 InNumHands,
+		FMCGraspAffordance& OutAffordance, float& OutScore) const;
+
+	// Find the precomputed affordance of the object closest to the given grasp location and palm rotation
+	bool FindGraspAffordance(AStaticMeshActor* InObject, const int32 InNumHands, const FVector& InGraspLocation,
+		const FQuat& InPalmRotation, FMCGraspAffordance& OutAffordance, float& OutScore) const;
+
+	// Look up the grasp data of the object (mass, affordance, semantic event names)
+	void StageGraspIntent(AStaticMeshActor* InObject);
+
+	// Pick the one hand graspable object with the best affordance (the closest object if none have affordances)
+	int32 SelectOneHandGraspableObject() const;
+
+	// Move the object so that the affordance grasp point is in the palm, approached along the palm axis
+	void SnapToAffordance(AStaticMeshActor* InObject, const FMCGraspAffordance& InAffordance) const;
+
+	// Move the object so that its two hand affordance ends are centered between the palms, aligned with them
+	void SnapToTwoHandsAffordances(AStaticMeshActor* InObject, const FMCGraspAffordance& InAffordance,
+		const FMCGraspAffordance& InOtherAffordance) const;
 
 	// Enable grasping with fixation
 	UPROPERTY(EditAnywhere, Category = "MC|Fixation Grasp")
@@ -150,6 +404,46 @@ private:
 	UPROPERTY(EditAnywhere, Category = "MC|Fixation Grasp", meta = (editcondition = "bFixationGraspEnabled"))
 	USphereComponent* FixationGraspArea;
 
+	// Object channels the fixation grasp area overlaps with (objects of other channels are never graspable)
+	UPROPERTY(EditAnywhere, Category = "MC|Fixation Grasp", meta = (editcondition = "bFixationGraspEnabled"))
+	TArray<TEnumAsByte<ECollisionChannel>> GraspableChannels;
+
+	// Place the objects at their nearest precomputed grasp affordance when attaching
+	UPROPERTY(EditAnywhere, Category = "MC|Fixation Grasp", meta = (editcondition = "bFixationGraspEnabled"))
+	bool bSnapToAffordance;
+
+	// Direction the palm faces (hand space), matched against the affordance approach axes
+	UPROPERTY(EditAnywhere, Category = "MC|Fixation Grasp", meta = (editcondition = "bFixationGraspEnabled"))
+	FVector PalmApproachAxis;
+
+	// Distance (cm) an aligned approach is worth when searching for the nearest affordance
+	UPROPERTY(EditAnywhere, Category = "MC|Fixation Grasp", meta = (editcondition = "bFixationGraspEnabled", ClampMin = 0))
+	float AffordanceAlignmentWeight;
+
+	// Lock the fingers onto the palm while an object is fixation grasped (no finger drives during the grasp)
+	UPROPERTY(EditAnywhere, Category = "MC|Fixation Grasp", meta = (editcondition = "bFixationGraspEnabled"))
+	bool bWeldFingersWhileGrasped;
+
+	// Number of recent palm samples used for the velocity of the released object
+	UPROPERTY(EditAnywhere, Category = "MC|Fixation Grasp", meta = (editcondition = "bFixationGraspEnabled", ClampMin = 2, ClampMax = 32))
+	int32 ReleaseVelocitySamples;
+
+	// Predict the grasp target while the hand approaches, its grasp data is ready when the grasp is triggered
+	UPROPERTY(EditAnywhere, Category = "MC|Fixation Grasp", meta = (editcondition = "bFixationGraspEnabled"))
+	bool bPredictGraspIntent;
+
+	// Time (s) the palm approach is extrapolated when scoring the grasp targets
+	UPROPERTY(EditAnywhere, Category = "MC|Fixation Grasp", meta = (editcondition = "bPredictGraspIntent", ClampMin = 0))
+	float GraspIntentLookAhead;
+
+	// Number of recent palm samples used for the approach velocity
+	UPROPERTY(EditAnywhere, Category = "MC|Fixation Grasp", meta = (editcondition = "bPredictGraspIntent", ClampMin = 2, ClampMax = 32))
+	int32 GraspIntentVelocitySamples;
+
+	// Score (cm) another object has to be better by to replace the predicted target
+	UPROPERTY(EditAnywhere, Category = "MC|Fixation Grasp", meta = (editcondition = "bPredictGraspIntent", ClampMin = 0))
+	float GraspIntentSwitchMargin;
+
 	// Maximum mass (kg) of an object that can be attached to the hand
 	UPROPERTY(EditAnywhere, Category = "MC|Fixation Grasp", meta = (editcondition = "bFixationGraspEnabled"), meta = (ClampMin = 0))
 	float OneHandFixationMaximumMass;
@@ -166,6 +460,14 @@ private:
 	UPROPERTY(EditAnywhere, Category = "MC|Fixation Grasp", meta = (editcondition = "bFixationGraspEnabled"), meta = (ClampMin = 0))
 	float TwoHandsFixationMaximumLength;
 
+	// Collision profile of the hand bodies, the default hand responses are kept if the profile does not exist
+	UPROPERTY(EditAnywhere, Category = "MC|Collision")
+	FName HandCollisionProfileName;
+
+	// Disable the collision between the two bodies of every finger joint
+	UPROPERTY(EditAnywhere, Category = "MC|Collision")
+	bool bDisableFingerJointCollision;
+
 	// Spring value to apply to the angular drive (Position strength)
 	UPROPERTY(EditAnywhere, Category = "MC|Drive Parameters")
 	TEnumAsByte<EAngularDriveMode::Type> AngularDriveMode;;
@@ -182,12 +484,23 @@ private:
 	UPROPERTY(EditAnywhere, Category = "MC|Drive Parameters", meta = (ClampMin = 0))
 	float ForceLimit;
 
+	// Per-joint targets closer than this (degrees) to the applied target are not sent to the physics scene
+	UPROPERTY(EditAnywhere, Category = "MC|Drive Parameters", meta = (ClampMin = 0))
+	float JointTargetTolerance;
+
+	// A frozen joint is released once the grasp goal drops this far below the goal it was frozen at
+	UPROPERTY(EditAnywhere, Category = "MC|Drive Parameters", meta = (ClampMin = 0, ClampMax = 1))
+	float FrozenJointReleaseMargin;
+
 	// Objects that are in reach to be grasped by one hand
 	TArray<AStaticMeshActor*> OneHandGraspableObjects;
 
 	// Pointer to the grasped object
 	AStaticMeshActor* OneHandGraspedObject;
 
+	// Predicted one hand grasp target
+	FMCGraspIntent GraspIntent;
+
 	// Object that is in reach, and is two hand graspable
 	AStaticMeshActor* TwoHandsGraspableObject;
 
@@ -209,6 +522,81 @@ private:
 	// Mark that the grasp has been held, avoid reinitializing the finger drivers
 	bool bGraspHeld;
 
+	// Finger constraints indexed by finger and part (see FMCFinger::GetJointIndex)
+	TArray<FConstraintInstance*> JointTable;
+
+	// Joint table entries with a constraint, limited to the hand topology (bit per joint)
+	uint32 BoundJointMask;
+
+	// Index of the active grasp pose
+	int32 ActiveGraspPoseIndex;
+
+	// Joint targets of the opened hand
+	const TArray<FQuat>* OpenTargets;
+
+	// Joint targets of the active grasp pose
+	const TArray<FQuat>* ClosedTargets;
+
+	// Fallback open targets (identity)
+	TArray<FQuat> DefaultOpenTargets;
+
+	// Fallback grasp targets (uniform curl of every joint)
+	TArray<FQuat> DefaultClosedTargets;
+
+	// Number of grasp updates between two finger drive target updates
+	int32 FingerDriveUpdateInterval;
+
+	// Grasp updates since the last finger drive target update
+	int32 FingerDriveUpdateCounter;
+
+	// Finger segment bone name to joint index
+	TMap<FName, int32> BoneToJointIndex;
+
+	// Joints whose segments touched something since the last grasp update (bit per joint)
+	uint32 JointContactMask;
+
+	// Joints with frozen targets (bit per joint)
+	uint32 FrozenJointMask;
+
+	// Grasp goal at the time the joint has been frozen
+	float FrozenJointGoals[MC_NUM_HAND_JOINTS];
+
+	// Current joint orientations, read in one pass
+	FQuat JointOrientations[MC_NUM_HAND_JOINTS];
+
+	// Last per-joint targets set from joint angles
+	FQuat AppliedJointTargets[MC_NUM_HAND_JOINTS];
+
+	// Joints whose drive target is the applied per-joint target (bit per joint), cleared when the targets are set otherwise
+	uint32 AppliedJointTargetMask;
+
+	// Flag showing that the finger constraints are locked in the grasp pose
+	bool bFingersWelded;
+
+	// Original constraint frames and limits of the welded fingers
+	FMCJointWeldState JointWeldStates[MC_NUM_HAND_JOINTS];
+
+	// Joints locked by the weld, only these have a stored weld state (bit per joint)
+	uint32 WeldedJointMask;
+
+	// Number of grasps started by the hand
+	int32 NumGrasps;
+
+	// Number of objects taken over from other hands
+	int32 NumHandovers;
+
+	// Number of distinct contacts of the hand bodies with other actors
+	int32 NumContacts;
+
+	// Distinct contacts since the touching joints were last released, repeated hits are not counted again
+	TSet<FMCHandContact> ActiveContacts;
+
+	// Recent palm and motion controller target poses
+	FMCKinematicHistory KinematicHistory;
+
+	// Mass (kg) of the attached object, set when the grasp starts and cleared when it ends
+	float LoadMass;
+
 	// Hand individual
 	FOwlIndividualName HandIndividual;
 
@@ -217,4 +605,19 @@ private:
 
 	// Current grasp event
 	TSharedPtr<FOwlNode> GraspEvent;
+
+	// Start record of the current grasp event (binary semantic event log)
+	FMCSemanticEventRecord GraspEventRecord;
+
+	// Flag showing that the current grasp event is written to the binary semantic event log
+	bool bGraspEventRecorded;
+
+	// Flag showing that the hand is rendered from replicated states
+	bool bRemoteProxy;
+
+	// Object attached to the hand by the replicated fixation grasp
+	AStaticMeshActor* RemoteAttachedObject;
+
+	// Object no longer grasped in the replicated state, dropped once every hand has claimed its object
+	AStaticMeshActor* RemoteReleasedObject;
 };
@@ -0,0 +1,229 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "MCFinger.h"
+#include "MCHandNetState.generated.h"
+
+/** Hand replication constants */
+enum
+{
+	MC_HAND_NET_BUFFER_SIZE = 16,
+	MC_HAND_NET_ANGLE_BITS = 10
+};
+
+/** Field groups of the hand state, a group is sent only if it differs from the base state */
+enum EMCHandNetField : uint32
+{
+	MCHN_Location = 1 << 0,
+	MCHN_Rotation = 1 << 1,
+	MCHN_Grasp = 1 << 2,
+	MCHN_JointAngles = 1 << 3,
+	MCHN_Attachment = 1 << 4,
+	MCHN_AllFields = (1 << 5) - 1
+};
+
+/** Hand state flags */
+enum EMCHandNetFlags : uint8
+{
+	MCHN_HasJointAngles = 1 << 0
+};
+
+/**
+* Dequantized hand state, used for rendering the hands of other users
+*/
+struct FMCHandNetPose
+{
+	// Palm (hand root body) world pose
+	FTransform Palm;
+
+	// Grasp goal (0 opened, 1 closed)
+	float Grasp;
+
+	// Flag showing that the joint angles are set (otherwise the grasp goal drives the fingers)
+	bool bHasJointAngles;
+
+	// Swing 1, swing 2 and twist (radians) of every joint, same layout as AMCHand::GetJointAngles
+	float JointAngles[MC_NUM_HAND_JOINTS * 3];
+
+	// Fixation grasp state of the hand
+	uint8 GraspState;
+
+	// Fixation grasped object
+	AActor* AttachedObject;
+
+	// Pose of the grasped object relative to the palm
+	FTransform AttachedRelativePose;
+};
+
+/**
+* Quantized hand state (palm pose, grasp value or per-joint angles, fixation grasp), serialized
+* as a field change mask followed by the fields that differ from a base state
+*/
+USTRUCT()
+struct UMCINTERACTION_API FMCHandNetState
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Default constructor
+	FMCHandNetState();
+
+	// Time the state was sampled on the owning machine (s)
+	float Timestamp;
+
+	// Palm location (mm)
+	int32 Location[3];
+
+	// Palm rotation (smallest three, 2 bit index and 3 x 10 bit components)
+	uint32 Rotation;
+
+	// Grasp goal (0 - 255)
+	uint8 Grasp;
+
+	// EMCHandNetFlags
+	uint8 Flags;
+
+	// Joint angles (MC_HAND_NET_ANGLE_BITS per angle over -PI .. PI)
+	uint16 JointAngles[MC_NUM_HAND_JOINTS * 3];
+
+	// Fixation grasp state of the hand
+	uint8 GraspState;
+
+	// Fixation grasped object
+	TWeakObjectPtr<AActor> AttachedObject;
+
+	// Location of the grasped object relative to the palm (mm)
+	int32 AttachedLocation[3];
+
+	// Rotation of the grasped object relative to the palm (smallest three)
+	uint32 AttachedRotation;
+
+	// Quantize the hand state, the joint angles are optional
+	void Quantize(const float InTimestamp, const FTransform& Palm, const float InGrasp, const float* InJointAngles,
+		const uint8 InGraspState, AActor* InAttachedObject, const FTransform& InAttachedRelativePose);
+
+	// Dequantize the hand state
+	void Dequantize(FMCHandNetPose& OutPose) const;
+
+	// Get the field groups that differ from the base state (EMCHandNetField)
+	uint32 GetChangedFields(const FMCHandNetState& Base) const;
+
+	// Write the fields that differ from the base state, or read them (the other fields keep their values)
+	void SerializeFields(FArchive& Ar, UPackageMap* Map, const FMCHandNetState& Base);
+
+	// Serialize the whole state (server RPC)
+	bool NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess);
+
+	// Get the changed joints (bit per joint)
+	uint32 GetChangedJoints(const FMCHandNetState& Base) const;
+
+	// Quantize a rotation to its smallest three components
+	static uint32 QuantizeRotation(const FQuat& InRotation);
+
+	// Dequantize a smallest three rotation
+	static FQuat DequantizeRotation(const uint32 InRotation);
+};
+
+template<>
+struct TStructOpsTypeTraits<FMCHandNetState> : public TStructOpsTypeTraitsBase2<FMCHandNetState>
+{
+	enum
+	{
+		WithNetSerializer = true
+	};
+};
+
+/**
+* Delta base state of the replicated hand state, the state last sent on a connection (reset to the
+* acknowledged one by the replication system when a packet is lost)
+*/
+class FMCHandNetDeltaState : public INetDeltaBaseState
+{
+public:
+	// Constructor
+	FMCHandNetDeltaState(const FMCHandNetState& InState) : State(InState)
+	{}
+
+	// Compare the base states
+	virtual bool IsStateEqual(INetDeltaBaseState* OtherState) override
+	{
+		return State.GetChangedFields(static_cast<FMCHandNetDeltaState*>(OtherState)->State) == 0;
+	}
+
+	// Base state
+	FMCHandNetState State;
+};
+
+/**
+* Replicated hand state, delta compressed against the base state of the connection
+*/
+USTRUCT()
+struct UMCINTERACTION_API FMCHandReplicatedState
+{
+	GENERATED_USTRUCT_BODY()
+
+	// Default constructor
+	FMCHandReplicatedState() : NumBitsWritten(0)
+	{}
+
+	// Current state
+	FMCHandNetState State;
+
+	// Bits written on all connections since the last reset (not replicated)
+	uint32 NumBitsWritten;
+
+	// Write the fields changed since the base state of the connection, or read them
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+};
+
+template<>
+struct TStructOpsTypeTraits<FMCHandReplicatedState> : public TStructOpsTypeTraitsBase2<FMCHandReplicatedState>
+{
+	enum
+	{
+		WithNetDeltaSerializer = true
+	};
+};
+
+/**
+* Received hand states of another user, rendered a fixed delay behind the newest state
+* (interpolated instead of extrapolated)
+*/
+class UMCINTERACTION_API FMCHandInterpolationBuffer
+{
+public:
+	// Constructor
+	FMCHandInterpolationBuffer();
+
+	// Remove all states
+	void Reset();
+
+	// Add a received state, states older than the newest one are dropped
+	void Add(const FMCHandNetState& InState);
+
+	// Advance the render time and interpolate the pose at it, returns false if there is no state yet
+	bool Sample(const float DeltaTime, const float Delay, FMCHandNetPose& OutPose);
+
+private:
+	// Get a state, 0 is the newest
+	const FMCHandNetState& GetState(const int32 Age) const
+	{
+		checkSlow(Age >= 0 && Age < NumStates);
+		return States[(Head - Age + MC_HAND_NET_BUFFER_SIZE) % MC_HAND_NET_BUFFER_SIZE];
+	};
+
+	// States
+	FMCHandNetState States[MC_HAND_NET_BUFFER_SIZE];
+
+	// Index of the newest state
+	int32 Head;
+
+	// Number of stored states
+	int32 NumStates;
+
+	// Render time on the clock of the owning machine
+	float RenderTime;
+};
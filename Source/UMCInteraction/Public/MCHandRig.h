@@ -0,0 +1,114 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/DataAsset.h"
+#include "PhysicsEngine/PhysicsAsset.h"
+#include "MCFinger.h"
+#include "MCHandRig.generated.h"
+
+/**
+* Pair of physics asset bodies
+*/
+USTRUCT()
+struct FMCBodyPair
+{
+	GENERATED_USTRUCT_BODY()
+
+	// First body bone name
+	UPROPERTY(EditAnywhere, Category = "Pair")
+	FName BodyA;
+
+	// Second body bone name
+	UPROPERTY(EditAnywhere, Category = "Pair")
+	FName BodyB;
+};
+
+/**
+* Hand rig, finger part to constraint mapping and drive parameters of a physics asset,
+* the constraint indices are resolved and validated in the editor and saved (cooked) with the asset
+*/
+UCLASS()
+class UMCINTERACTION_API UMCHandRig : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values
+	UMCHandRig();
+
+	// Physics asset of the hand skeletal mesh
+	UPROPERTY(EditAnywhere, Category = "MC|Rig")
+	UPhysicsAsset* PhysicsAsset;
+
+	// Reduced interaction physics asset (same bodies and constraints, simple shapes), see GenerateReducedPhysicsAsset
+	UPROPERTY(EditAnywhere, Category = "MC|Rig")
+	UPhysicsAsset* ReducedPhysicsAsset;
+
+	// Constraint joint names indexed by finger and part (see FMCFinger::GetJointIndex), None if the rig has no such joint
+	UPROPERTY(EditAnywhere, EditFixedSize, Category = "MC|Rig")
+	TArray<FName> JointNames;
+
+	// Angular drive mode of the finger constraints
+	UPROPERTY(EditAnywhere, Category = "MC|Drive Parameters")
+	TEnumAsByte<EAngularDriveMode::Type> AngularDriveMode;
+
+	// Spring value to apply to the angular drive (Position strength)
+	UPROPERTY(EditAnywhere, Category = "MC|Drive Parameters", meta = (ClampMin = 0))
+	float Spring;
+
+	// Damping value to apply to the angular drive (Velocity strength)
+	UPROPERTY(EditAnywhere, Category = "MC|Drive Parameters", meta = (ClampMin = 0))
+	float Damping;
+
+	// Limit of the force that the angular drive can apply
+	UPROPERTY(EditAnywhere, Category = "MC|Drive Parameters", meta = (ClampMin = 0))
+	float ForceLimit;
+
+	// Disable the collision between all the bodies of the same finger (including the palm - proximal pair)
+	UPROPERTY(EditAnywhere, Category = "MC|Collision")
+	bool bDisableFingerSelfCollision;
+
+	// Additional body pairs that never collide
+	UPROPERTY(EditAnywhere, Category = "MC|Collision")
+	TArray<FMCBodyPair> DisabledCollisionPairs;
+
+	// Write the self collision matrix into the physics asset (saved with it, no runtime cost)
+	UFUNCTION(CallInEditor, Category = "MC|Collision")
+	void ApplySelfCollisionMatrix();
+
+	// Create a copy of the physics asset with a capsule per phalanx and a box per other body, logs the cost of both
+	UFUNCTION(CallInEditor, Category = "MC|Rig")
+	void GenerateReducedPhysicsAsset();
+
+	// Copy the prebuilt constraint index table into the hand joint table, returns false if the rig does not fit the component
+	bool CopyJointTable(USkeletalMeshComponent* SkelComp, TArray<FConstraintInstance*>& OutJointTable) const;
+
+	// Check if the constraint indices are resolved
+	bool IsResolved() const { return bResolved; };
+
+#if WITH_EDITOR
+	// Resolve and validate the constraint indices against the physics asset
+	bool ResolveConstraintIndices();
+
+	// Resolve the indices when edited
+	virtual void PostEditChangeProperty(struct FPropertyChangedEvent& PropertyChangedEvent) override;
+
+	// Resolve the indices before saving / cooking
+	virtual void PreSave(const class ITargetPlatform* TargetPlatform) override;
+
+	// Describe the collision cost of a physics asset (bodies, shapes, convex vertices, colliding body pairs)
+	static FString GetCollisionCostReport(const UPhysicsAsset* InPhysicsAsset);
+#endif // WITH_EDITOR
+
+private:
+	// Physics asset constraint indices of the hand joints (INDEX_NONE if the rig has no such joint)
+	UPROPERTY(VisibleAnywhere, Category = "MC|Rig")
+	TArray<int32> ConstraintIndices;
+
+	// Flag showing that the constraint indices have been resolved and validated
+	UPROPERTY(VisibleAnywhere, Category = "MC|Rig")
+	bool bResolved;
+};
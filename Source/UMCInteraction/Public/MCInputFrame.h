@@ -0,0 +1,105 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MCInputFrame.generated.h"
+
+/** Enum indicating where the character input comes from */
+UENUM(BlueprintType)
+enum class EMCInputMode : uint8
+{
+	Live		UMETA(DisplayName = "Live"),
+	Record		UMETA(DisplayName = "Record"),
+	Replay		UMETA(DisplayName = "Replay")
+};
+
+/** Input action flags of a simulation step */
+enum EMCInputAction : uint8
+{
+	MCIA_None = 0,
+	MCIA_SwitchGrasp = 1 << 0,
+	MCIA_LeftAttach = 1 << 1,
+	MCIA_LeftDetach = 1 << 2,
+	MCIA_RightAttach = 1 << 3,
+	MCIA_RightDetach = 1 << 4
+};
+
+/**
+* Character input of one simulation step
+*/
+struct FMCInputFrame
+{
+	// Default constructor
+	FMCInputFrame() :
+		CharacterLocation(FVector::ZeroVector),
+		CharacterRotation(FQuat::Identity),
+		LeftTargetLocation(FVector::ZeroVector),
+		LeftTargetRotation(FQuat::Identity),
+		RightTargetLocation(FVector::ZeroVector),
+		RightTargetRotation(FQuat::Identity),
+		LeftGrasp(0.f),
+		RightGrasp(0.f),
+		Actions(MCIA_None)
+	{}
+
+	// Character world location
+	FVector CharacterLocation;
+
+	// Character world rotation
+	FQuat CharacterRotation;
+
+	// Left motion controller world location
+	FVector LeftTargetLocation;
+
+	// Left motion controller world rotation
+	FQuat LeftTargetRotation;
+
+	// Right motion controller world location
+	FVector RightTargetLocation;
+
+	// Right motion controller world rotation
+	FQuat RightTargetRotation;
+
+	// Left hand grasp axis value
+	float LeftGrasp;
+
+	// Right hand grasp axis value
+	float RightGrasp;
+
+	// Actions triggered during the step (EMCInputAction flags)
+	uint8 Actions;
+
+	// Serialize the frame
+	friend FArchive& operator<<(FArchive& Ar, FMCInputFrame& Frame)
+	{
+		Ar << Frame.CharacterLocation << Frame.CharacterRotation;
+		Ar << Frame.LeftTargetLocation << Frame.LeftTargetRotation;
+		Ar << Frame.RightTargetLocation << Frame.RightTargetRotation;
+		Ar << Frame.LeftGrasp << Frame.RightGrasp << Frame.Actions;
+		return Ar;
+	}
+};
+
+/**
+* Input frames of consecutive fixed length simulation steps
+*/
+struct UMCINTERACTION_API FMCInputRecording
+{
+	// Default constructor
+	FMCInputRecording() : StepDeltaTime(0.f)
+	{}
+
+	// Length of one simulation step (s)
+	float StepDeltaTime;
+
+	// Input frames, one per simulation step
+	TArray<FMCInputFrame> Frames;
+
+	// Write the recording to a binary file
+	bool SaveToFile(const FString& Filename) const;
+
+	// Read the recording from a binary file
+	bool LoadFromFile(const FString& Filename);
+};
@@ -0,0 +1,104 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Kinematic history constants */
+enum
+{
+	MC_KINEMATIC_HISTORY_SIZE = 32
+};
+
+/** Palm and motion controller target pose at one controller update */
+struct FMCKinematicSample
+{
+	// World time (s)
+	float Time;
+
+	// Palm (hand root body) location
+	FVector PalmLocation;
+
+	// Palm (hand root body) rotation
+	FQuat PalmRotation;
+
+	// Motion controller target location
+	FVector TargetLocation;
+
+	// Motion controller target rotation
+	FQuat TargetRotation;
+};
+
+/**
+* Fixed-size ring buffer of the recent palm and target poses, velocities are
+* estimated from several samples (no physics queries needed)
+*/
+class UMCINTERACTION_API FMCKinematicHistory
+{
+public:
+	// Constructor
+	FMCKinematicHistory();
+
+	// Remove all samples
+	void Reset();
+
+	// Add a sample, overwrites the oldest one when full
+	void Add(const float Time, const FTransform& PalmPose, const FTransform& TargetPose);
+
+	// Get the number of stored samples
+	int32 Num() const { return NumSamples; };
+
+	// Get a sample, 0 is the newest
+	const FMCKinematicSample& GetSample(const int32 Age) const
+	{
+		checkSlow(Age >= 0 && Age < NumSamples);
+		return Samples[(Head - Age + MC_KINEMATIC_HISTORY_SIZE) % MC_KINEMATIC_HISTORY_SIZE];
+	};
+
+	// Palm linear velocity (cm/s), least squares fit over the newest samples
+	FVector GetPalmLinearVelocity(const int32 InNumSamples) const
+	{
+		return FMCKinematicHistory::FitLinearVelocity(&FMCKinematicSample::PalmLocation, InNumSamples);
+	};
+
+	// Palm angular velocity (rad/s), mean over the newest samples
+	FVector GetPalmAngularVelocity(const int32 InNumSamples) const
+	{
+		return FMCKinematicHistory::MeanAngularVelocity(&FMCKinematicSample::PalmRotation, InNumSamples);
+	};
+
+	// Target linear velocity (cm/s), least squares fit over the newest samples
+	FVector GetTargetLinearVelocity(const int32 InNumSamples) const
+	{
+		return FMCKinematicHistory::FitLinearVelocity(&FMCKinematicSample::TargetLocation, InNumSamples);
+	};
+
+	// Target linear acceleration (cm/s^2), change between the velocities of two consecutive sample windows
+	FVector GetTargetLinearAcceleration(const int32 InNumSamples) const;
+
+	// Target angular velocity (rad/s), mean over the newest samples
+	FVector GetTargetAngularVelocity(const int32 InNumSamples) const
+	{
+		return FMCKinematicHistory::MeanAngularVelocity(&FMCKinematicSample::TargetRotation, InNumSamples);
+	};
+
+	// Extrapolate the palm pose with the estimated velocities
+	FTransform PredictPalmPose(const float DeltaTime, const int32 InNumSamples) const;
+
+private:
+	// Least squares slope of a location over the newest samples (starting at the given age)
+	FVector FitLinearVelocity(FVector FMCKinematicSample::*Location, const int32 InNumSamples, const int32 FirstAge = 0) const;
+
+	// Summed rotation between the newest samples divided by their time span
+	FVector MeanAngularVelocity(FQuat FMCKinematicSample::*Rotation, const int32 InNumSamples) const;
+
+	// Samples
+	FMCKinematicSample Samples[MC_KINEMATIC_HISTORY_SIZE];
+
+	// Index of the newest sample
+	int32 Head;
+
+	// Number of stored samples
+	int32 NumSamples;
+};
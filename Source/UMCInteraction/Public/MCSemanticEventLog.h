@@ -0,0 +1,106 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/** Semantic event log magic ("MCSE") and version */
+enum
+{
+	MC_SEMANTIC_LOG_MAGIC = 0x4553434D,
+	MC_SEMANTIC_LOG_VERSION = 1
+};
+
+/** Semantic event record types */
+enum EMCSemanticEventType : uint8
+{
+	MCSE_GraspStart = 0,
+	MCSE_GraspFinish = 1
+};
+
+/** Fixed-size grasp event record, names are indices into the log name table */
+struct FMCSemanticEventRecord
+{
+	// World time (s)
+	double Timestamp;
+
+	// Event index, shared by the start and finish records of the same event
+	uint32 EventId;
+
+	// Hand individual name index
+	uint32 HandId;
+
+	// Grasped object individual name index
+	uint32 ObjectId;
+
+	// EMCSemanticEventType
+	uint8 EventType;
+
+	// Number of hands grasping the object (1 or 2)
+	uint8 NumHands;
+
+	// Padding
+	uint16 Reserved;
+
+	// Padding
+	uint32 Reserved2;
+};
+
+static_assert(sizeof(FMCSemanticEventRecord) == 32, "Semantic event record layout changed");
+
+/**
+* Writes grasp events as fixed-size binary records instead of building the OWL document at runtime,
+* the log is converted offline to OWL (see UMCSemanticLogConverterCommandlet).
+*
+* File layout: [Magic, Version, RecordSize][Records..][Name table][NameTableOffset (uint64), NumRecords, Magic]
+*/
+class UMCINTERACTION_API FMCSemanticEventLog
+{
+public:
+	// Constructor
+	FMCSemanticEventLog();
+
+	// Destructor, closes the file
+	~FMCSemanticEventLog();
+
+	// Create the log file
+	bool Open(const FString& Filename);
+
+	// Write the name table and close the file
+	void Close();
+
+	// Check if the log file is open
+	bool IsOpen() const { return FileWriter != nullptr; };
+
+	// Get the index of an individual name, added to the name table on first use
+	uint32 GetNameId(const FString& Name);
+
+	// Write a grasp start record, returns it (with a new event id) for finishing the event
+	FMCSemanticEventRecord StartGraspEvent(const double Timestamp, const uint32 HandId, const uint32 ObjectId, const uint8 NumHands);
+
+	// Write the finish record of a started grasp event
+	void FinishGraspEvent(const FMCSemanticEventRecord& StartRecord, const double Timestamp);
+
+	// Read the records and the name table of a log file
+	static bool ReadFromFile(const FString& Filename, TArray<FMCSemanticEventRecord>& OutRecords, TArray<FString>& OutNames);
+
+	// Write the records and the name table as a log file (e.g. logs merged offline)
+	static bool WriteToFile(const FString& Filename, const TArray<FMCSemanticEventRecord>& Records, const TArray<FString>& Names);
+
+private:
+	// Output file
+	FArchive* FileWriter;
+
+	// Individual name to name table index
+	TMap<FString, uint32> NameIds;
+
+	// Name table
+	TArray<FString> Names;
+
+	// Number of written records
+	uint32 NumRecords;
+
+	// Number of started events
+	uint32 NumEvents;
+};
@@ -0,0 +1,29 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MCSemanticEventLog.h"
+#include "MCSemanticLogConverterCommandlet.generated.h"
+
+/**
+* Converts a binary semantic event log into the OWL grasp events written by the semantic logger runtime manager:
+* -run=MCSemanticLogConverter -Log=<SemanticEvents.bin> [-Owl=<Events.owl>]
+*/
+UCLASS()
+class UMCINTERACTION_API UMCSemanticLogConverterCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values
+	UMCSemanticLogConverterCommandlet();
+
+	// Run the converter
+	virtual int32 Main(const FString& Params) override;
+
+	// Convert the records to an OWL document
+	static FString ConvertToOwl(const TArray<FMCSemanticEventRecord>& Records, const TArray<FString>& Names);
+};
@@ -0,0 +1,30 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MCSharedPoseRing.h"
+#include "MCSharedPoseProducerCommandlet.generated.h"
+
+/**
+* Stand-in for an external tracker, publishes synthetic hand poses (both hands moving on circles,
+* fingers opening and closing) to the shared pose ring read by the character:
+* -run=MCSharedPoseProducer [-Name=MCTrackerPoses] [-Hz=90] [-Duration=<s>]
+*/
+UCLASS()
+class UMCINTERACTION_API UMCSharedPoseProducerCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values
+	UMCSharedPoseProducerCommandlet();
+
+	// Run the producer
+	virtual int32 Main(const FString& Params) override;
+
+	// Get the synthetic sample at the given time
+	static FMCSharedPoseSample GetSample(const double Time);
+};
@@ -0,0 +1,165 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/PlatformMemory.h"
+#include "MCFinger.h"
+
+/** Shared pose ring magic ("MCSP"), version and size (power of two) */
+enum
+{
+	MC_SHARED_POSE_MAGIC = 0x5053434D,
+	MC_SHARED_POSE_VERSION = 1,
+	MC_SHARED_POSE_RING_SIZE = 64
+};
+
+/** Shared hand pose flags */
+enum EMCSharedPoseFlags : uint32
+{
+	MCSP_None = 0,
+	MCSP_Valid = 1 << 0,
+	MCSP_HasFingers = 1 << 1
+};
+
+/** Tracked hand pose in the motion controller origin frame (cm, Unreal axes) */
+struct FMCSharedHandPose
+{
+	// Location (X, Y, Z)
+	float Location[3];
+
+	// Rotation quaternion (X, Y, Z, W)
+	float Rotation[4];
+
+	// EMCSharedPoseFlags
+	uint32 Flags;
+
+	// Finger curl (0 opened, 1 closed), in EFingerType order
+	float FingerCurl[MC_NUM_FINGERS];
+};
+
+/** Poses of both hands at one tracker sample */
+struct FMCSharedPoseSample
+{
+	// Tracker time (s)
+	double Timestamp;
+
+	// Left hand pose
+	FMCSharedHandPose Left;
+
+	// Right hand pose
+	FMCSharedHandPose Right;
+};
+
+/** Ring slot, the sequence is odd while the producer writes the sample */
+struct FMCSharedPoseSlot
+{
+	// Write sequence of the slot
+	volatile uint32 Sequence;
+
+	// Padding
+	uint32 Reserved;
+
+	// Sample
+	FMCSharedPoseSample Sample;
+};
+
+/** Ring header, followed by the slots */
+struct FMCSharedPoseHeader
+{
+	// MC_SHARED_POSE_MAGIC
+	uint32 Magic;
+
+	// MC_SHARED_POSE_VERSION
+	uint32 Version;
+
+	// sizeof(FMCSharedPoseHeader)
+	uint32 HeaderSize;
+
+	// sizeof(FMCSharedPoseSlot)
+	uint32 SlotSize;
+
+	// Number of slots
+	uint32 RingSize;
+
+	// Padding
+	uint32 Reserved;
+
+	// Number of published samples, the newest one is in slot (WriteIndex - 1) % RingSize
+	volatile uint64 WriteIndex;
+};
+
+static_assert(sizeof(FMCSharedHandPose) == 52, "Shared hand pose layout changed");
+static_assert(sizeof(FMCSharedPoseSample) == 112, "Shared pose sample layout changed");
+static_assert(sizeof(FMCSharedPoseSlot) == 120, "Shared pose slot layout changed");
+static_assert(sizeof(FMCSharedPoseHeader) == 32, "Shared pose header layout changed");
+static_assert((MC_SHARED_POSE_RING_SIZE & (MC_SHARED_POSE_RING_SIZE - 1)) == 0, "Shared pose ring size must be a power of two");
+
+/**
+* Single producer / single consumer ring of tracker poses in a named shared memory region,
+* the external tracker process writes, the game thread reads the newest sample without locking
+*
+* Region layout: [FMCSharedPoseHeader][FMCSharedPoseSlot x RingSize]
+*/
+class UMCINTERACTION_API FMCSharedPoseRing
+{
+public:
+	// Constructor
+	FMCSharedPoseRing();
+
+	// Destructor, unmaps the region
+	~FMCSharedPoseRing();
+
+	// Map an existing region for reading, returns false if it does not exist or has a different layout
+	bool OpenForReading(const FString& Name);
+
+	// Create (or map) the region for writing and initialize the header
+	bool CreateForWriting(const FString& Name);
+
+	// Unmap the region
+	void Close();
+
+	// Check if the region is mapped
+	bool IsOpen() const { return Header != nullptr; };
+
+	// Copy the newest sample if it was not read before, never blocks (gives up after a few torn reads)
+	bool ReadLatest(FMCSharedPoseSample& OutSample);
+
+	// Publish a sample (producer only)
+	void Write(const FMCSharedPoseSample& Sample);
+
+	// Get the number of samples published by the producer
+	uint64 GetWriteIndex() const { return Header ? Header->WriteIndex : 0; };
+
+	// Get the number of samples overwritten before they could be read
+	uint64 GetNumDropped() const { return NumDropped; };
+
+	// Get the size of the mapped region
+	static SIZE_T GetRegionSize()
+	{
+		return sizeof(FMCSharedPoseHeader) + sizeof(FMCSharedPoseSlot) * MC_SHARED_POSE_RING_SIZE;
+	};
+
+private:
+	// Map the region
+	bool Map(const FString& Name, const bool bCreate);
+
+	// Get a slot
+	FMCSharedPoseSlot* GetSlot(const uint64 Index) const
+	{
+		return reinterpret_cast<FMCSharedPoseSlot*>(Header + 1) + (Index & (MC_SHARED_POSE_RING_SIZE - 1));
+	};
+
+	// Mapped region
+	FPlatformMemory::FSharedMemoryRegion* Region;
+
+	// Ring header (start of the mapped region)
+	FMCSharedPoseHeader* Header;
+
+	// Write index of the last read sample
+	uint64 LastReadIndex;
+
+	// Samples overwritten before they could be read
+	uint64 NumDropped;
+};
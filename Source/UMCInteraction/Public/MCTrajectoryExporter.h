@@ -0,0 +1,171 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/Runnable.h"
+#include "HAL/ThreadSafeBool.h"
+#include "HAL/ThreadSafeCounter64.h"
+
+/**
+* Trajectory file layout (little endian, offsets in bytes from the file start), readable by memory mapping:
+*
+*   [FMCTrajectoryFileHeader][FMCTrajectoryColumn x NumColumns]   (DataOffset is the end of the column table)
+*   [Chunk 0] .. [Chunk N-1]    each chunk holds NumColumns column blocks of RowsPerChunk 4 byte values,
+*                               column C of a chunk starts at ChunkOffset + C * RowsPerChunk * 4
+*   [FMCTrajectoryChunk x NumChunks][FMCTrajectoryFileFooter]   (footer is the last 32 bytes of the file)
+*/
+
+/** Trajectory file magic ("MCTR") and version */
+enum
+{
+	MC_TRAJECTORY_MAGIC = 0x5254434D,
+	MC_TRAJECTORY_VERSION = 1
+};
+
+/** Column value types (all values are 4 bytes wide) */
+enum class EMCTrajectoryColumnType : uint32
+{
+	Float32 = 0,
+	Int32 = 1
+};
+
+/** File header */
+struct FMCTrajectoryFileHeader
+{
+	uint32 Magic;
+	uint32 Version;
+	uint32 RowsPerChunk;
+	uint32 NumColumns;
+	uint64 DataOffset;
+};
+
+/** Column description */
+struct FMCTrajectoryColumn
+{
+	ANSICHAR Name[56];
+	uint32 Type;
+	uint32 Reserved;
+};
+
+/** Footer index entry of a chunk */
+struct FMCTrajectoryChunk
+{
+	uint64 Offset;
+	uint32 NumRows;
+	uint32 Reserved;
+};
+
+/** File footer */
+struct FMCTrajectoryFileFooter
+{
+	uint64 IndexOffset;
+	uint64 NumRows;
+	uint64 NumDroppedRows;
+	uint32 NumChunks;
+	uint32 Magic;
+};
+
+static_assert(sizeof(FMCTrajectoryFileHeader) == 24, "Trajectory header layout changed");
+static_assert(sizeof(FMCTrajectoryColumn) == 64, "Trajectory column layout changed");
+static_assert(sizeof(FMCTrajectoryChunk) == 16, "Trajectory chunk layout changed");
+static_assert(sizeof(FMCTrajectoryFileFooter) == 32, "Trajectory footer layout changed");
+
+/**
+* Streams fixed-width rows into columnar chunks, the game thread copies the rows into a preallocated ring buffer,
+* a background thread transposes full chunks and writes them to file
+*/
+class UMCINTERACTION_API FMCTrajectoryExporter : public FRunnable
+{
+public:
+	// Constructor
+	FMCTrajectoryExporter();
+
+	// Destructor, finishes the file if still open
+	virtual ~FMCTrajectoryExporter();
+
+	// Add a column (before Start), returns its index in the row
+	int32 AddColumn(const FString& Name, const EMCTrajectoryColumnType Type = EMCTrajectoryColumnType::Float32);
+
+	// Open the file, write the header and start the writer thread
+	bool Start(const FString& Filename, const int32 InRowsPerChunk = 1024, const int32 InRingChunks = 4);
+
+	// Get the next row to fill (game thread), nullptr if the ring buffer is full and the row is dropped
+	uint32* BeginRow();
+
+	// Publish the filled row (game thread)
+	void EndRow();
+
+	// Write the remaining rows and the footer, close the file
+	void Finish();
+
+	// Check if the exporter is writing
+	bool IsStarted() const { return Thread != nullptr; };
+
+	// Get the number of values in a row
+	int32 GetNumColumns() const { return Columns.Num(); };
+
+	// Concatenate trajectory files with the same columns and chunk size into one file (the chunks are copied as they are),
+	// outputs the first row and the number of rows of every input file in the merged file (0 rows if it was not merged)
+	static bool MergeFiles(const TArray<FString>& Filenames, const FString& OutFilename, TArray<TPair<uint64, uint64>>& OutRowRanges);
+
+	// Write a float value into the row
+	FORCEINLINE static void SetFloat(uint32* Row, const int32 Column, const float Value)
+	{
+		FMemory::Memcpy(&Row[Column], &Value, sizeof(float));
+	}
+
+	// Write an integer value into the row
+	FORCEINLINE static void SetInt(uint32* Row, const int32 Column, const int32 Value)
+	{
+		FMemory::Memcpy(&Row[Column], &Value, sizeof(int32));
+	}
+
+	// FRunnable interface
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	// Transpose and write a chunk of rows (writer thread)
+	void WriteChunk(const int32 NumRows);
+
+	// Column descriptions
+	TArray<FMCTrajectoryColumn> Columns;
+
+	// Ring buffer of rows (row major)
+	TArray<uint32> Ring;
+
+	// Chunk buffer (column major)
+	TArray<uint32> ChunkBuffer;
+
+	// Footer index
+	TArray<FMCTrajectoryChunk> ChunkIndex;
+
+	// Rows per chunk
+	int32 RowsPerChunk;
+
+	// Rows in the ring buffer
+	int32 RingRows;
+
+	// Rows published by the game thread
+	FThreadSafeCounter64 NumWrittenRows;
+
+	// Rows consumed by the writer thread
+	FThreadSafeCounter64 NumReadRows;
+
+	// Rows dropped because the ring buffer was full
+	int64 NumDroppedRows;
+
+	// Output file
+	FArchive* FileWriter;
+
+	// Writer thread
+	FRunnableThread* Thread;
+
+	// Wakes the writer thread
+	FEvent* WakeEvent;
+
+	// Set when no more rows will be published
+	FThreadSafeBool bStopRequested;
+};
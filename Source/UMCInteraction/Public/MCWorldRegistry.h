@@ -0,0 +1,93 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MCSemanticEventLog.h"
+
+class UWorld;
+class ASLRuntimeManager;
+class AMCHand;
+class AMCCharacter;
+
+/**
+* Per world registry of the interaction services (semantic logging runtime manager, hands, characters),
+* resolved once and handed out without world scans
+*/
+class UMCINTERACTION_API FMCWorldRegistry
+{
+public:
+	// Get (or create) the registry of the world
+	static FMCWorldRegistry& Get(UWorld* InWorld);
+
+	// Bind the world cleanup callback (called at module startup)
+	static void Startup();
+
+	// Remove the cleanup callback and all registries (called at module shutdown)
+	static void Shutdown();
+
+	// Get the semantic logging runtime manager, the world is only scanned on the first call
+	ASLRuntimeManager* GetSemLogRuntimeManager();
+
+	// Write the grasp events of the world to a binary log instead of the runtime manager
+	bool OpenSemanticEventLog(const FString& Filename);
+
+	// Close the binary semantic event log
+	void CloseSemanticEventLog();
+
+	// Get the binary semantic event log (nullptr if not open)
+	FMCSemanticEventLog* GetSemanticEventLog() { return SemanticEventLog.IsOpen() ? &SemanticEventLog : nullptr; };
+
+	// Register hand
+	void RegisterHand(AMCHand* InHand);
+
+	// Unregister hand, clears its pairing as well
+	void UnregisterHand(AMCHand* InHand);
+
+	// Pair the two hands, used for the two hands fixation grasp
+	void RegisterHandPair(AMCHand* InLeftHand, AMCHand* InRightHand);
+
+	// Get the paired hand (nullptr if not paired)
+	AMCHand* GetOtherHand(const AMCHand* InHand) const;
+
+	// Register character
+	void RegisterCharacter(AMCCharacter* InCharacter);
+
+	// Unregister character
+	void UnregisterCharacter(AMCCharacter* InCharacter);
+
+	// Get the registered hands
+	const TArray<AMCHand*>& GetHands() const { return Hands; };
+
+	// Get the registered characters
+	const TArray<AMCCharacter*>& GetCharacters() const { return Characters; };
+
+private:
+	// Constructor
+	FMCWorldRegistry(UWorld* InWorld);
+
+	// Remove the registry of the world
+	static void OnWorldCleanup(UWorld* InWorld, bool bSessionEnded, bool bCleanupResources);
+
+	// World of the registry
+	UWorld* World;
+
+	// Semantic logging runtime manager of the world
+	TWeakObjectPtr<ASLRuntimeManager> SemLogRuntimeManager;
+
+	// Flag showing that the world has been scanned for the runtime manager
+	bool bSemLogRuntimeManagerResolved;
+
+	// Binary semantic event log, closed with the world
+	FMCSemanticEventLog SemanticEventLog;
+
+	// Registered hands
+	TArray<AMCHand*> Hands;
+
+	// Hand to its paired hand
+	TMap<const AMCHand*, AMCHand*> HandPairs;
+
+	// Registered characters
+	TArray<AMCCharacter*> Characters;
+};
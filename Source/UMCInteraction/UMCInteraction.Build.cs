@@ -29,7 +29,6 @@ public class UMCInteraction : ModuleRules
 			new string[]
 			{
 				"Core",
-				"UPIDController",
 				"SemLog",
 				"UTags",
 				// ... add other public dependencies that you statically link with here ...
@@ -46,6 +45,8 @@ public class UMCInteraction : ModuleRules
 				"SlateCore",
 				"HeadMountedDisplay",
 				"SteamVR",
+				"Json",
+				"AssetRegistry",
 				// ... add private dependencies that you statically link with here ...	
 			}
 			);
@@ -0,0 +1,350 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+// Micro-benchmark of the hand control core, simulates a hand (palm and finger bodies) tracking a target
+// with the same update the plugin runs every frame (see AMCCharacter::UpdateHandLocationAndRotation),
+// once for every linear control strategy
+#include "MCControlCore.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	// Simulated point mass body (cm, s) with an angular state
+	struct FBody
+	{
+		FMCVec3 Location;
+		FMCVec3 Velocity;
+		FMCQuat Rotation;
+	};
+
+	// Number of simulated finger bodies
+	const int NumFingers = 5;
+
+	// Palm and finger bodies, the fingers are held at their (closing) grasp offsets by spring damper joint drives
+	struct FHand
+	{
+		FBody Palm;
+		FBody Fingers[NumFingers];
+		// Mass of the grasped object welded to the palm (kg)
+		float LoadMass;
+	};
+
+	// Hand body masses (kg) and finger joint drive (N/cm, N s/cm)
+	const float PalmMass = 0.5f;
+	const float FingerMass = 0.05f;
+	const float FingerSpring = 5.f;
+	const float FingerDamping = 0.1f;
+
+	// Finger offset from the palm while the grasp closes and opens (once per second)
+	FMCVec3 GetFingerTarget(const int FingerIdx, const float Time)
+	{
+		const float Curl = 0.5f - 0.5f * std::cos(2.f * 3.14159265f * Time);
+		return FMCVec3(8.f - 4.f * Curl, (FingerIdx - 2) * 2.f, -3.f * Curl);
+	}
+
+	// Place the hand with its fingers at their targets, at rest
+	FHand MakeHand(const FMCVec3& PalmLocation)
+	{
+		FHand Hand;
+		Hand.LoadMass = 0.f;
+		Hand.Palm.Location = PalmLocation;
+		for (int FingerIdx = 0; FingerIdx < NumFingers; ++FingerIdx)
+		{
+			Hand.Fingers[FingerIdx].Location = PalmLocation + GetFingerTarget(FingerIdx, 0.f);
+		}
+		return Hand;
+	}
+
+	// Benchmarked linear control strategy and its gains (same defaults as the character)
+	struct FStrategy
+	{
+		const char* Name;
+		MCControl::ELinearStrategy Strategy;
+		float P, D, MaxOutput;
+	};
+
+	// Results of a strategy
+	struct FResult
+	{
+		// Time until the step error stays within the settle band (s, negative if never)
+		float ConvergenceTime;
+		// Largest overshoot past the step target (% of the step)
+		float Overshoot;
+		// Largest velocity change per second the controller applies to the palm (cm/s^2), a proxy of the solver load
+		float PeakEffort;
+		// Mean location error seen by the controller while tracking the moving target (cm)
+		float TrackingError;
+		// Mean rotation error seen by the controller while tracking the moving target (sin half angle)
+		float RotationError;
+		// Mean distance of the fingers from their drive targets relative to the palm while tracking (cm)
+		float FingerLag;
+		// Controller cost (ns per update)
+		double NsPerUpdate;
+	};
+
+	// Target moving on a circle while rotating around the vertical axis
+	void GetTarget(const float Time, FMCVec3& OutLocation, FMCQuat& OutRotation)
+	{
+		OutLocation = FMCVec3(std::cos(Time) * 30.f, std::sin(Time) * 30.f, 100.f + std::sin(2.f * Time) * 10.f);
+		const float HalfAngle = 0.5f * Time;
+		OutRotation = FMCQuat(0.f, 0.f, std::sin(HalfAngle), std::cos(HalfAngle));
+	}
+
+	// Step the finger joint drives and integrate the hand bodies, the drive reactions act on the palm and its load
+	// (semi implicit Euler)
+	void StepHand(FHand& Hand, const float Time, const float DeltaTime)
+	{
+		const float PalmBodyMass = PalmMass + Hand.LoadMass;
+		for (int FingerIdx = 0; FingerIdx < NumFingers; ++FingerIdx)
+		{
+			FBody& Finger = Hand.Fingers[FingerIdx];
+			const FMCVec3 Force = (GetFingerTarget(FingerIdx, Time) - (Finger.Location - Hand.Palm.Location)) * FingerSpring -
+				(Finger.Velocity - Hand.Palm.Velocity) * FingerDamping;
+			Finger.Velocity += Force * (DeltaTime / FingerMass);
+			Hand.Palm.Velocity += Force * (-DeltaTime / PalmBodyMass);
+		}
+		Hand.Palm.Location += Hand.Palm.Velocity * DeltaTime;
+		for (FBody& Finger : Hand.Fingers)
+		{
+			Finger.Location += Finger.Velocity * DeltaTime;
+		}
+	}
+
+	// Apply the controller output to every hand body as the plugin does (all bodies below the root), step the finger
+	// joint drives, returns the velocity change of the palm
+	FMCVec3 ApplyLinear(FHand& Hand, const MCControl::ELinearStrategy Strategy, const FMCVec3& Output,
+		const float Time, const float DeltaTime)
+	{
+		const FMCVec3 PrevVelocity = Hand.Palm.Velocity;
+		FBody* Bodies[NumFingers + 1] = { &Hand.Palm };
+		for (int FingerIdx = 0; FingerIdx < NumFingers; ++FingerIdx)
+		{
+			Bodies[FingerIdx + 1] = &Hand.Fingers[FingerIdx];
+		}
+
+		// Velocity P overwrites the finger velocities relative to the palm, the impulse and the force keep them
+		for (FBody* Body : Bodies)
+		{
+			switch (Strategy)
+			{
+			case MCControl::LinearVelocityP:
+				Body->Velocity = Output;
+				break;
+			case MCControl::LinearImpulse:
+				Body->Velocity += Output;
+				break;
+			default:
+				Body->Velocity += Output * DeltaTime;
+				break;
+			}
+		}
+
+		StepHand(Hand, Time, DeltaTime);
+		return Hand.Palm.Velocity - PrevVelocity;
+	}
+
+	// Mean distance of the fingers from their drive targets relative to the palm (cm)
+	float GetFingerLag(const FHand& Hand, const float Time)
+	{
+		float Lag = 0.f;
+		for (int FingerIdx = 0; FingerIdx < NumFingers; ++FingerIdx)
+		{
+			Lag += (GetFingerTarget(FingerIdx, Time) - (Hand.Fingers[FingerIdx].Location - Hand.Palm.Location)).Size();
+		}
+		return Lag / NumFingers;
+	}
+
+	// Update the controller, timing only the control math
+	FMCVec3 TimedUpdate(FMCPIDController3& Controller, const FStrategy& Strategy,
+		const FMCVec3& Error, const FMCVec3& Velocity, const float DeltaTime, double& InOutNs)
+	{
+		const auto Start = std::chrono::steady_clock::now();
+		const FMCVec3 Output = MCControl::UpdateLinear(Controller, Strategy.Strategy, Error, Velocity, DeltaTime);
+		InOutNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - Start).count();
+		return Output;
+	}
+
+	// Step response from rest towards a target 10 cm away, and tracking of the moving target
+	FResult Run(const FStrategy& Strategy, const int NumSteps, const float DeltaTime)
+	{
+		const float StepSize = 10.f;
+		const float SettleBand = 0.02f * StepSize;
+		const float RotationBoost = 12000.f;
+
+		FResult Result;
+		Result.ConvergenceTime = -1.f;
+		Result.Overshoot = 0.f;
+		Result.PeakEffort = 0.f;
+		double ControlNs = 0.0;
+
+		FMCPIDController3 Controller;
+		Controller.SetValues(Strategy.P, 0.f, Strategy.D, Strategy.MaxOutput, -Strategy.MaxOutput);
+
+		// Step response of the palm (3 s), the grasp keeps closing and opening
+		FHand Hand = MakeHand(FMCVec3());
+		const FMCVec3 StepTarget(StepSize, 0.f, 0.f);
+		const int StepResponseSteps = (int)(3.f / DeltaTime);
+		for (int Step = 0; Step < StepResponseSteps; ++Step)
+		{
+			const FMCVec3 Output = TimedUpdate(Controller, Strategy, StepTarget - Hand.Palm.Location, Hand.Palm.Velocity, DeltaTime, ControlNs);
+			const FMCVec3 DeltaVelocity = ApplyLinear(Hand, Strategy.Strategy, Output, Step * DeltaTime, DeltaTime);
+
+			const float Effort = DeltaVelocity.Size() / DeltaTime;
+			Result.PeakEffort = Effort > Result.PeakEffort ? Effort : Result.PeakEffort;
+			const float Overshoot = (Hand.Palm.Location.X - StepSize) / StepSize * 100.f;
+			Result.Overshoot = Overshoot > Result.Overshoot ? Overshoot : Result.Overshoot;
+			if ((StepTarget - Hand.Palm.Location).Size() > SettleBand)
+			{
+				Result.ConvergenceTime = -1.f;
+			}
+			else if (Result.ConvergenceTime < 0.f)
+			{
+				Result.ConvergenceTime = (Step + 1) * DeltaTime;
+			}
+		}
+
+		// Tracking
+		Controller.Reset();
+		Hand = MakeHand(FMCVec3(30.f, 0.f, 100.f));
+		Result.TrackingError = 0.f;
+		Result.RotationError = 0.f;
+		Result.FingerLag = 0.f;
+		FMCVec3 TargetLoc;
+		FMCQuat TargetRot;
+		for (int Step = 0; Step < NumSteps; ++Step)
+		{
+			GetTarget(Step * DeltaTime, TargetLoc, TargetRot);
+			FBody& Palm = Hand.Palm;
+			Result.TrackingError += (TargetLoc - Palm.Location).Size();
+			Result.RotationError += MCControl::RotationErrorVector(TargetRot, Palm.Rotation).Size();
+
+			const FMCVec3 Output = TimedUpdate(Controller, Strategy, TargetLoc - Hand.Palm.Location, Hand.Palm.Velocity, DeltaTime, ControlNs);
+			ApplyLinear(Hand, Strategy.Strategy, Output, Step * DeltaTime, DeltaTime);
+
+			// Angular velocity is in deg/s as in the plugin
+			const FMCVec3 AngularVelocity = MCControl::RotationErrorVector(TargetRot, Palm.Rotation) * RotationBoost;
+			Palm.Rotation = MCControl::PredictRotation(Palm.Rotation, AngularVelocity * (3.14159265f / 180.f), DeltaTime);
+			Result.FingerLag += GetFingerLag(Hand, (Step + 1) * DeltaTime);
+		}
+		Result.TrackingError /= NumSteps;
+		Result.RotationError /= NumSteps;
+		Result.FingerLag /= NumSteps;
+		Result.NsPerUpdate = ControlNs / (NumSteps + StepResponseSteps);
+		return Result;
+	}
+
+	// Force PD with a load welded to the palm, applied as the plugin default (acceleration change on every body) or mass
+	// scheduled (force of every body scaled with its mass, the palm carrying the load, with target feedforward),
+	// returns the step convergence time and the mean tracking error
+	void RunLoad(const float LoadMass, const bool bScheduled, const float DeltaTime,
+		float& OutConvergenceTime, float& OutTrackingError)
+	{
+		const float StepSize = 10.f;
+		FMCPIDController3 Controller;
+		Controller.SetValues(700.f, 0.f, 50.f, 350000.f, -350000.f);
+
+		// Apply the output, the scheduled forces add up to the hand and load mass
+		auto Apply = [&](FHand& Hand, const FMCVec3& Output, const FMCVec3& Feedforward, const float Time)
+		{
+			if (bScheduled)
+			{
+				const float PalmBodyMass = PalmMass + Hand.LoadMass;
+				Hand.Palm.Velocity += MCControl::ScheduleForce(Output, Feedforward, PalmBodyMass) * (DeltaTime / PalmBodyMass);
+				for (FBody& Finger : Hand.Fingers)
+				{
+					Finger.Velocity += MCControl::ScheduleForce(Output, Feedforward, FingerMass) * (DeltaTime / FingerMass);
+				}
+				StepHand(Hand, Time, DeltaTime);
+			}
+			else
+			{
+				ApplyLinear(Hand, MCControl::LinearForcePD, Output, Time, DeltaTime);
+			}
+		};
+
+		// Step response (3 s)
+		FHand Hand = MakeHand(FMCVec3());
+		Hand.LoadMass = LoadMass;
+		OutConvergenceTime = -1.f;
+		const int StepResponseSteps = (int)(3.f / DeltaTime);
+		for (int Step = 0; Step < StepResponseSteps; ++Step)
+		{
+			const FMCVec3 Output = Controller.UpdateAsPD(FMCVec3(StepSize, 0.f, 0.f) - Hand.Palm.Location, DeltaTime);
+			Apply(Hand, Output, FMCVec3(), Step * DeltaTime);
+			if (std::fabs(Hand.Palm.Location.X - StepSize) > 0.02f * StepSize)
+			{
+				OutConvergenceTime = -1.f;
+			}
+			else if (OutConvergenceTime < 0.f)
+			{
+				OutConvergenceTime = (Step + 1) * DeltaTime;
+			}
+		}
+
+		// Tracking (10 s), the target acceleration is known from the previous target samples, the error is the one seen by the controller
+		Controller.Reset();
+		Hand = MakeHand(FMCVec3(30.f, 0.f, 100.f));
+		Hand.LoadMass = LoadMass;
+		OutTrackingError = 0.f;
+		const int TrackingSteps = (int)(10.f / DeltaTime);
+		FMCVec3 TargetLoc, PrevTargetLoc, PrevPrevTargetLoc;
+		FMCQuat TargetRot;
+		GetTarget(-2.f * DeltaTime, PrevPrevTargetLoc, TargetRot);
+		GetTarget(-DeltaTime, PrevTargetLoc, TargetRot);
+		for (int Step = 0; Step < TrackingSteps; ++Step)
+		{
+			GetTarget(Step * DeltaTime, TargetLoc, TargetRot);
+			OutTrackingError += (TargetLoc - Hand.Palm.Location).Size();
+			const FMCVec3 Output = Controller.UpdateAsPD(TargetLoc - Hand.Palm.Location, DeltaTime);
+			const FMCVec3 Feedforward = (TargetLoc - PrevTargetLoc * 2.f + PrevPrevTargetLoc) / (DeltaTime * DeltaTime);
+			Apply(Hand, Output, Feedforward, Step * DeltaTime);
+			PrevPrevTargetLoc = PrevTargetLoc;
+			PrevTargetLoc = TargetLoc;
+		}
+		OutTrackingError /= TrackingSteps;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const int NumSteps = argc > 1 ? std::atoi(argv[1]) : 1000000;
+	const float DeltaTime = 1.f / 90.f;
+
+	const FStrategy Strategies[] =
+	{
+		{ "Force PD", MCControl::LinearForcePD, 700.f, 50.f, 350000.f },
+		{ "Velocity P", MCControl::LinearVelocityP, 20.f, 0.f, 1000.f },
+		{ "Impulse", MCControl::LinearImpulse, 20.f, 0.f, 1000.f }
+	};
+
+	std::printf("MCControlBench: %d tracking steps @ %.1f Hz, 10 cm step response\n", NumSteps, 1.f / DeltaTime);
+	std::printf("Palm %.2f kg and %d fingers of %.2f kg on joint drives, the grasp closes and opens once per second\n",
+		PalmMass, NumFingers, FingerMass);
+	std::printf("%-12s %12s %12s %18s %12s %12s %16s %10s\n", "strategy", "converge(s)", "overshoot(%)",
+		"peak dv/dt(cm/s^2)", "track(cm)", "rot(sin)", "finger lag(cm)", "ns/update");
+	for (const FStrategy& Strategy : Strategies)
+	{
+		const FResult Result = Run(Strategy, NumSteps, DeltaTime);
+		std::printf("%-12s %12.3f %12.2f %18.1f %12.3f %12.5f %16.3f %10.2f\n",
+			Strategy.Name, Result.ConvergenceTime, Result.Overshoot, Result.PeakEffort,
+			Result.TrackingError, Result.RotationError, Result.FingerLag, Result.NsPerUpdate);
+	}
+	std::printf("(peak dv/dt is the largest palm velocity change per second, a proxy of the solver load, not a measured solver cost)\n");
+
+	// Carried loads, the plugin default (acceleration change, bMassAwareControl off) against the mass scheduled force
+	std::printf("\nForce PD carrying a load, default acceleration change against mass scheduled force with feedforward\n");
+	std::printf("%-10s %16s %16s %16s %16s %14s\n",
+		"load(kg)", "accel conv(s)", "accel track(cm)", "sched conv(s)", "sched track(cm)", "track gain(x)");
+	const float Loads[] = { 0.f, 1.f, 5.f, 15.f };
+	for (const float Load : Loads)
+	{
+		float AccelConvergence, AccelTracking, ScheduledConvergence, ScheduledTracking;
+		RunLoad(Load, false, DeltaTime, AccelConvergence, AccelTracking);
+		RunLoad(Load, true, DeltaTime, ScheduledConvergence, ScheduledTracking);
+		std::printf("%-10.1f %16.3f %16.3f %16.3f %16.3f %14.3f\n", Load, AccelConvergence, AccelTracking,
+			ScheduledConvergence, ScheduledTracking, AccelTracking / ScheduledTracking);
+	}
+	return 0;
+}
@@ -0,0 +1,214 @@
+// Copyright 2017, Institute for Artificial Intelligence - University of Bremen
+// Author: Andrei Haidu (http://haidu.eu)
+
+// Unit tests of the engine independent hand control core (MCControlCore.h), run with ctest
+#include "MCControlCore.h"
+#include <cmath>
+#include <cstdio>
+#include <initializer_list>
+#include <limits>
+
+namespace
+{
+	// Number of failed checks
+	int NumFailures = 0;
+
+	// Report a failed check
+	void Check(const bool bCondition, const char* Expression, const char* File, const int Line)
+	{
+		if (!bCondition)
+		{
+			std::printf("%s:%d: check failed: %s\n", File, Line, Expression);
+			NumFailures++;
+		}
+	}
+
+	bool IsNear(const float A, const float B, const float Tolerance = 1e-4f)
+	{
+		return std::fabs(A - B) <= Tolerance;
+	}
+
+	bool IsNear(const FMCVec3& A, const FMCVec3& B, const float Tolerance = 1e-4f)
+	{
+		return IsNear(A.X, B.X, Tolerance) && IsNear(A.Y, B.Y, Tolerance) && IsNear(A.Z, B.Z, Tolerance);
+	}
+
+	bool IsNear(const FMCQuat& A, const FMCQuat& B, const float Tolerance = 1e-4f)
+	{
+		return IsNear(A.X, B.X, Tolerance) && IsNear(A.Y, B.Y, Tolerance) &&
+			IsNear(A.Z, B.Z, Tolerance) && IsNear(A.W, B.W, Tolerance);
+	}
+
+	// Rotation around the vertical axis (radians)
+	FMCQuat RotationZ(const float Angle)
+	{
+		return FMCQuat(0.f, 0.f, std::sin(0.5f * Angle), std::cos(0.5f * Angle));
+	}
+
+	// Controller with the given gains and symmetric output limits
+	FMCPIDController3 MakeController(const float P, const float I, const float D, const float MaxOutput)
+	{
+		FMCPIDController3 Controller;
+		Controller.SetValues(P, I, D, MaxOutput, -MaxOutput);
+		return Controller;
+	}
+
+	const float NaN = std::numeric_limits<float>::quiet_NaN();
+}
+
+#define MC_CHECK(Expression) Check((Expression), #Expression, __FILE__, __LINE__)
+
+// The error takes the short way around, a current orientation in the other hemisphere gives the same error
+void TestShortestPathError()
+{
+	const FMCQuat Target = RotationZ(0.3f);
+	const FMCQuat Current = RotationZ(0.1f);
+	const FMCQuat Error = MCControl::ShortestPathError(Target, Current);
+	MC_CHECK(IsNear(Error, RotationZ(0.2f)));
+
+	// Same orientation, negated quaternion
+	MC_CHECK(IsNear(MCControl::ShortestPathError(Target, -Current), RotationZ(0.2f)));
+	MC_CHECK(IsNear(MCControl::RotationErrorVector(Target, -Current), MCControl::RotationErrorVector(Target, Current)));
+
+	// Identical orientations in opposite hemispheres have no error
+	MC_CHECK(IsNear(MCControl::ShortestPathError(Target, -Target), FMCQuat()));
+	MC_CHECK(IsNear(MCControl::RotationErrorVector(Target, -Target), FMCVec3()));
+
+	// Error of 0.2 rad around Z as sin(angle / 2) * axis
+	MC_CHECK(IsNear(MCControl::RotationErrorVector(Target, Current), FMCVec3(0.f, 0.f, std::sin(0.1f))));
+}
+
+// Every output component is clamped to the limits
+void TestOutputClamping()
+{
+	FMCPIDController3 Controller = MakeController(10.f, 0.f, 0.f, 5.f);
+	MC_CHECK(IsNear(Controller.UpdateAsP(FMCVec3(100.f, -100.f, 0.2f)), FMCVec3(5.f, -5.f, 2.f)));
+	MC_CHECK(IsNear(Controller.UpdateAsPD(FMCVec3(100.f, -100.f, 0.2f), 0.01f), FMCVec3(5.f, -5.f, 2.f)));
+	Controller.Reset();
+	MC_CHECK(IsNear(Controller.UpdateAsPID(FMCVec3(100.f, -100.f, 0.2f), 0.01f), FMCVec3(5.f, -5.f, 2.f)));
+	MC_CHECK(IsNear(MCControl::Clamp(FMCVec3(-3.f, 0.5f, 3.f), -1.f, 1.f), FMCVec3(-1.f, 0.5f, 1.f)));
+}
+
+// Zero and negative time steps give no output and leave the error history untouched
+void TestInvalidDeltaTime()
+{
+	FMCPIDController3 Controller = MakeController(2.f, 1.f, 0.5f, 1000.f);
+	const FMCVec3 Error(1.f, 2.f, 3.f);
+	for (const float DeltaTime : { 0.f, -0.01f })
+	{
+		MC_CHECK(IsNear(Controller.UpdateAsPID(Error, DeltaTime), FMCVec3()));
+		MC_CHECK(IsNear(Controller.UpdateAsPD(Error, DeltaTime), FMCVec3()));
+		MC_CHECK(IsNear(Controller.PrevError, FMCVec3()));
+		MC_CHECK(IsNear(Controller.IntegralError, FMCVec3()));
+	}
+}
+
+// NaN errors give no output and leave the error history untouched
+void TestNaNGuards()
+{
+	FMCPIDController3 Controller = MakeController(2.f, 1.f, 0.5f, 1000.f);
+	Controller.UpdateAsPID(FMCVec3(1.f, 1.f, 1.f), 0.1f);
+	const FMCVec3 PrevError = Controller.PrevError;
+	const FMCVec3 IntegralError = Controller.IntegralError;
+
+	const FMCVec3 NaNError(NaN, 0.f, 0.f);
+	MC_CHECK(NaNError.ContainsNaN());
+	MC_CHECK(!FMCVec3(1.f, 2.f, 3.f).ContainsNaN());
+	MC_CHECK(IsNear(Controller.UpdateAsPID(NaNError, 0.1f), FMCVec3()));
+	MC_CHECK(IsNear(Controller.UpdateAsPD(FMCVec3(0.f, 0.f, NaN), 0.1f), FMCVec3()));
+	MC_CHECK(IsNear(Controller.UpdateAsP(FMCVec3(0.f, NaN, 0.f)), FMCVec3()));
+	MC_CHECK(IsNear(Controller.PrevError, PrevError));
+	MC_CHECK(IsNear(Controller.IntegralError, IntegralError));
+}
+
+// P on the error, D on the error change since the previous update
+void TestUpdateAsPD()
+{
+	FMCPIDController3 Controller = MakeController(2.f, 100.f, 0.5f, 1000.f);
+	const float DeltaTime = 0.1f;
+
+	// First update, the previous error is zero
+	MC_CHECK(IsNear(Controller.UpdateAsPD(FMCVec3(1.f, 0.f, -2.f), DeltaTime), FMCVec3(2.f + 5.f, 0.f, -4.f - 10.f)));
+
+	// Second update, the derivative uses the change (0.5, 1, 2) over 0.1 s
+	MC_CHECK(IsNear(Controller.UpdateAsPD(FMCVec3(1.5f, 1.f, 0.f), DeltaTime), FMCVec3(3.f + 2.5f, 2.f + 5.f, 0.f + 10.f)));
+
+	// The integral gain is not used
+	MC_CHECK(IsNear(Controller.IntegralError, FMCVec3()));
+
+	// Reset clears the history
+	Controller.Reset();
+	MC_CHECK(IsNear(Controller.PrevError, FMCVec3()));
+}
+
+// Constant angular velocity extrapolation
+void TestPredictRotation()
+{
+	const FMCQuat Start = RotationZ(0.2f);
+
+	// 1 rad/s around Z for 0.5 s
+	MC_CHECK(IsNear(MCControl::PredictRotation(Start, FMCVec3(0.f, 0.f, 1.f), 0.5f), RotationZ(0.7f)));
+
+	// No rotation below the rate threshold, or without time
+	MC_CHECK(IsNear(MCControl::PredictRotation(Start, FMCVec3(), 0.5f), Start));
+	MC_CHECK(IsNear(MCControl::PredictRotation(Start, FMCVec3(0.f, 0.f, 1.f), 0.f), Start));
+
+	// The result stays normalized
+	const FMCQuat Predicted = MCControl::PredictRotation(Start, FMCVec3(3.f, -2.f, 1.f), 0.37f);
+	MC_CHECK(IsNear(Predicted.Dot(Predicted), 1.f));
+
+	MC_CHECK(IsNear(MCControl::PredictLocation(FMCVec3(1.f, 2.f, 3.f), FMCVec3(10.f, 0.f, -10.f), 0.1f), FMCVec3(2.f, 2.f, 2.f)));
+}
+
+// Output of every linear strategy
+void TestUpdateLinear()
+{
+	const FMCVec3 Error(2.f, -1.f, 0.f);
+	const FMCVec3 Velocity(5.f, 5.f, -50.f);
+	const float DeltaTime = 0.1f;
+
+	// Force PD, same as the PD update
+	FMCPIDController3 Controller = MakeController(3.f, 0.f, 0.2f, 1000.f);
+	FMCPIDController3 Reference = Controller;
+	MC_CHECK(IsNear(MCControl::UpdateLinear(Controller, MCControl::LinearForcePD, Error, Velocity, DeltaTime),
+		Reference.UpdateAsPD(Error, DeltaTime)));
+	MC_CHECK(IsNear(Controller.PrevError, Error));
+
+	// Velocity P, the target velocity (independent of the current velocity)
+	Controller = MakeController(3.f, 0.f, 0.2f, 1000.f);
+	MC_CHECK(IsNear(MCControl::UpdateLinear(Controller, MCControl::LinearVelocityP, Error, Velocity, DeltaTime), FMCVec3(6.f, -3.f, 0.f)));
+	MC_CHECK(IsNear(Controller.PrevError, FMCVec3()));
+
+	// Impulse, the velocity change to the target velocity
+	MC_CHECK(IsNear(MCControl::UpdateLinear(Controller, MCControl::LinearImpulse, Error, Velocity, DeltaTime), FMCVec3(1.f, -8.f, 50.f)));
+
+	// Impulse, clamped after removing the current velocity
+	Controller = MakeController(3.f, 0.f, 0.f, 20.f);
+	MC_CHECK(IsNear(MCControl::UpdateLinear(Controller, MCControl::LinearImpulse, Error, Velocity, DeltaTime), FMCVec3(1.f, -8.f, 20.f)));
+}
+
+// Mass scheduled force, the acceleration and the feedforward scale with the controlled mass
+void TestScheduleForce()
+{
+	MC_CHECK(IsNear(MCControl::ScheduleForce(FMCVec3(1.f, 2.f, 3.f), FMCVec3(1.f, 0.f, -1.f), 4.f), FMCVec3(8.f, 8.f, 8.f)));
+}
+
+int main()
+{
+	TestShortestPathError();
+	TestOutputClamping();
+	TestInvalidDeltaTime();
+	TestNaNGuards();
+	TestUpdateAsPD();
+	TestPredictRotation();
+	TestUpdateLinear();
+	TestScheduleForce();
+
+	if (NumFailures > 0)
+	{
+		std::printf("MCControlCoreTests: %d checks failed\n", NumFailures);
+		return 1;
+	}
+	std::printf("MCControlCoreTests: all checks passed\n");
+	return 0;
+}